@@ -0,0 +1,166 @@
+// implementation of AST.h
+
+#include "AST.h"
+#include <iomanip>
+
+void Ast::clear() {
+    nodes.clear();
+    texts.clear();
+    root = NO_NODE;
+}
+
+NodeId Ast::addNode(NodeKind kind, TokenType op, std::string_view text, size_t line) {
+    nodes.push_back(AstNode{kind, op, 0, NO_NODE, NO_NODE, NO_NODE, line, text});
+    return static_cast<NodeId>(nodes.size() - 1);
+}
+
+void Ast::appendChild(NodeId parent, NodeId child) {
+    if (parent == NO_NODE || child == NO_NODE) {
+        return;
+    }
+    AstNode& p = nodes[parent];
+    if (p.lastChild == NO_NODE) {
+        p.firstChild = child;
+    } else {
+        nodes[p.lastChild].nextSibling = child;
+    }
+    p.lastChild = child;
+}
+
+void Ast::replaceChildren(NodeId parent, const std::vector<NodeId>& children) {
+    AstNode& p = nodes[parent];
+    p.firstChild = NO_NODE;
+    p.lastChild = NO_NODE;
+    for (NodeId child : children) {
+        if (child != NO_NODE) {
+            nodes[child].nextSibling = NO_NODE;
+            appendChild(parent, child);
+        }
+    }
+}
+
+size_t Ast::reserveProgram(const Ast& piece) {
+    size_t at = nodes.size();
+    nodes.resize(at + piece.nodes.size() - 1);
+    return at;
+}
+
+// The piece's root is its node 0 and is dropped, so its node id moves to id + at - 1
+void Ast::copyProgram(const Ast& piece, size_t at) {
+    NodeId shift = static_cast<NodeId>(at) - 1;
+    auto move = [shift](NodeId id) { return id == NO_NODE ? NO_NODE : id + shift; };
+    for (size_t id = 1; id < piece.nodes.size(); ++id) {
+        AstNode& n = nodes[id + shift];
+        n = piece.nodes[id];
+        n.firstChild = move(n.firstChild);
+        n.lastChild = move(n.lastChild);
+        n.nextSibling = move(n.nextSibling);
+    }
+}
+
+// The statements are already linked as siblings; hang the chain off this root
+void Ast::linkProgram(const Ast& piece, size_t at) {
+    const AstNode& pieceRoot = piece.nodes[piece.root];
+    if (pieceRoot.firstChild != NO_NODE) {
+        NodeId shift = static_cast<NodeId>(at) - 1;
+        appendChild(root, pieceRoot.firstChild + shift);
+        nodes[root].lastChild = pieceRoot.lastChild + shift;
+    }
+}
+
+NodeId Ast::copySubtree(NodeId from) {
+    std::vector<NodeId> copies; // copies[d]: the copy of the node last visited at depth d
+    walk(from, [&](NodeId id, size_t depth) {
+        const AstNode source = nodes[id]; // A copy: addNode may move the array
+        NodeId made = addNode(source.kind, source.op, source.text, source.line);
+        nodes[made].flags = source.flags;
+        copies.resize(depth + 1);
+        copies[depth] = made;
+        if (depth > 0) {
+            appendChild(copies[depth - 1], made);
+        }
+        return true;
+    });
+    return copies.empty() ? NO_NODE : copies[0];
+}
+
+std::string_view Ast::addText(std::string text) {
+    texts.push_back(std::move(text));
+    return texts.back();
+}
+
+size_t Ast::compact() {
+    std::vector<NodeId> newId(nodes.size(), NO_NODE);
+    std::vector<AstNode> kept;
+    kept.reserve(nodes.size());
+    walk(root, [&](NodeId id, size_t) {
+        newId[id] = static_cast<NodeId>(kept.size());
+        kept.push_back(nodes[id]);
+        return true;
+    });
+    auto remap = [&](NodeId id) { return id == NO_NODE ? NO_NODE : newId[id]; };
+    for (AstNode& n : kept) {
+        n.firstChild = remap(n.firstChild);
+        n.lastChild = remap(n.lastChild);
+        n.nextSibling = remap(n.nextSibling);
+    }
+    size_t dropped = nodes.size() - kept.size();
+    root = remap(root);
+    nodes.swap(kept);
+    return dropped;
+}
+
+const char* nodeKindName(NodeKind kind) {
+    switch (kind) {
+        case NodeKind::Program: return "Program";
+        case NodeKind::Block: return "Block";
+        case NodeKind::Assign: return "Assign";
+        case NodeKind::ExprStmt: return "ExprStmt";
+        case NodeKind::If: return "If";
+        case NodeKind::While: return "While";
+        case NodeKind::For: return "For";
+        case NodeKind::Print: return "Print";
+        case NodeKind::Input: return "Input";
+        case NodeKind::Literal: return "Literal";
+        case NodeKind::Name: return "Name";
+        case NodeKind::Unary: return "Unary";
+        case NodeKind::Binary: return "Binary";
+        default: return "Unknown";
+    }
+}
+
+void Ast::print(std::ostream& out) const {
+    out << "\n--- Abstract Syntax Tree ---" << std::endl;
+    walk(root, [&](NodeId id, size_t depth) {
+        const AstNode& n = nodes[id];
+        out << std::string(depth * 2, ' ') << nodeKindName(n.kind);
+        if (!n.text.empty()) {
+            out << " '" << n.text << "'";
+        }
+        if (n.flags & HAS_ELSE) {
+            out << " (else)";
+        }
+        out << "  [line " << n.line << "]" << std::endl;
+        return true;
+    });
+    out << "----------------------------" << std::endl;
+}
+
+void Ast::printMemoryReport(std::ostream& out) const {
+    size_t counts[static_cast<size_t>(NodeKind::Binary) + 1] = {};
+    for (const AstNode& n : nodes) {
+        counts[static_cast<size_t>(n.kind)]++;
+    }
+
+    out << "\n--- AST Memory Report ---" << std::endl;
+    out << std::left << std::setw(20) << "Nodes" << nodes.size() << std::endl;
+    out << std::setw(20) << "Bytes per node" << sizeof(AstNode) << std::endl;
+    out << std::setw(20) << "Bytes used" << nodes.size() * sizeof(AstNode) << std::endl;
+    out << std::setw(20) << "Bytes reserved" << nodes.capacity() * sizeof(AstNode) << std::endl;
+    for (size_t kind = 0; kind <= static_cast<size_t>(NodeKind::Binary); ++kind) {
+        if (counts[kind] != 0) {
+            out << "  " << std::setw(18) << nodeKindName(static_cast<NodeKind>(kind)) << counts[kind] << std::endl;
+        }
+    }
+    out << "-------------------------" << std::endl;
+}
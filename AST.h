@@ -0,0 +1,144 @@
+#ifndef AST_H
+#define AST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iostream>
+
+#include "Token.h"
+
+// Index of a node in its Ast. Indices stay valid as the node array grows, unlike pointers.
+using NodeId = uint32_t;
+const NodeId NO_NODE = UINT32_MAX;
+
+enum class NodeKind : uint8_t {
+    Program,   // children: statements
+    Block,     // children: statements of an if/elif/else/while/for body
+    Assign,    // text: target identifier; child: value
+    ExprStmt,  // child: expression evaluated for its side effects (e.g. a bare input())
+    If,        // children: condition, block, then (condition, block) per elif, then the else block if HAS_ELSE
+    While,     // children: condition, block
+    For,       // text: loop variable; child: block
+    Print,     // child: expression
+    Input,     // optional child: prompt literal
+    Literal,   // op: literal token type; text: lexeme
+    Name,      // text: identifier
+    Unary,     // op: operator; child: operand
+    Binary     // op: operator; children: left, right
+};
+
+// Node flags
+const uint16_t HAS_ELSE = 1 << 0;
+
+// Nodes are plain data linked by index (first child / next sibling) so the whole tree is one
+// flat array: no per-node allocation, and freeing it is a single deallocation.
+struct AstNode {
+    NodeKind kind;
+    TokenType op;         // Operator or literal type, UNKNOWN when unused
+    uint16_t flags;
+    NodeId firstChild;
+    NodeId lastChild;     // Lets children be appended in source order in O(1)
+    NodeId nextSibling;
+    size_t line;
+    std::string_view text; // View into the source buffer, like Token::lexeme, or into the Ast's own texts
+};
+
+// Arena holding the nodes of one parse. clear() keeps the capacity, so an Ast can be reused
+// across parses without touching the allocator again. Text made after parsing (see addText)
+// is owned by the Ast, so it can be moved but not copied.
+class Ast {
+private:
+    std::vector<AstNode> nodes;
+    NodeId root;
+    std::deque<std::string> texts; // Storage of addText; a deque never moves its elements
+
+public:
+    Ast() : root(NO_NODE) {}
+    Ast(Ast&&) = default;
+    Ast& operator=(Ast&&) = default;
+    Ast(const Ast&) = delete;
+    Ast& operator=(const Ast&) = delete;
+
+    void reserve(size_t nodeCount) { nodes.reserve(nodeCount); }
+    void clear();
+
+    NodeId addNode(NodeKind kind, TokenType op, std::string_view text, size_t line);
+    void appendChild(NodeId parent, NodeId child); // Ignores NO_NODE, so failed sub-parses can be passed through
+    // Relinks parent to exactly these children, in order (NO_NODE entries are skipped). The old
+    // children that are not listed stay in the array until compact().
+    void replaceChildren(NodeId parent, const std::vector<NodeId>& children);
+    // Joining trees parsed as consecutive pieces of one program (see Parser::parsePiece), so the
+    // node ids come out as if the program had been parsed as one. Every tree must come straight
+    // from a parse (the root is its first node, no addText). reserveProgram() makes room at the
+    // end for a piece's nodes other than its root and returns where they go; copyProgram() fills
+    // that room (calls for different pieces may run at once); linkProgram() then moves the
+    // piece's statements to the end of this tree's root.
+    size_t reserveProgram(const Ast& piece);
+    void copyProgram(const Ast& piece, size_t at);
+    void linkProgram(const Ast& piece, size_t at);
+    // Copies the subtree under from (texts are shared) and returns the copy's root, which has
+    // no parent yet
+    NodeId copySubtree(NodeId from);
+    // Keeps a copy of text for the lifetime of the Ast (e.g. a folded literal's lexeme)
+    std::string_view addText(std::string text);
+
+    // Drops the nodes no longer reachable from the root and renumbers the rest in pre-order.
+    // Invalidates every NodeId held outside the tree; returns the number of nodes dropped.
+    size_t compact();
+
+    AstNode& node(NodeId id) { return nodes[id]; }
+    const AstNode& node(NodeId id) const { return nodes[id]; }
+    size_t size() const { return nodes.size(); }
+
+    NodeId getRoot() const { return root; }
+    void setRoot(NodeId id) { root = id; }
+
+    // Pre-order walk from `from`; visit(id, depth) returns false to skip that node's children.
+    // Uses an explicit stack, so deep trees cannot overflow the native stack.
+    template <typename Visitor>
+    void walk(NodeId from, Visitor&& visit) const;
+
+    // Prints the tree, one node per line indented by depth
+    void print(std::ostream& out = std::cout) const;
+
+    // Prints node count, bytes per node and total memory (used and reserved)
+    void printMemoryReport(std::ostream& out = std::cout) const;
+};
+
+template <typename Visitor>
+void Ast::walk(NodeId from, Visitor&& visit) const {
+    if (from == NO_NODE) {
+        return;
+    }
+    // Goes down first children directly; only a sibling still to visit is stacked
+    std::vector<std::pair<NodeId, size_t>> pending;
+    NodeId id = from;
+    size_t depth = 0;
+    while (true) {
+        bool descend = visit(id, depth);
+        const AstNode& n = nodes[id];
+        if (descend && n.firstChild != NO_NODE) {
+            if (id != from && n.nextSibling != NO_NODE) {
+                pending.emplace_back(n.nextSibling, depth);
+            }
+            id = n.firstChild;
+            depth++;
+        } else if (id != from && n.nextSibling != NO_NODE) {
+            id = n.nextSibling;
+        } else if (!pending.empty()) {
+            id = pending.back().first;
+            depth = pending.back().second;
+            pending.pop_back();
+        } else {
+            return;
+        }
+    }
+}
+
+const char* nodeKindName(NodeKind kind);
+
+#endif
@@ -0,0 +1,346 @@
+// implementation of AnalysisCache.h
+
+#include "AnalysisCache.h"
+#include "SourceFile.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char CACHE_MAGIC[4] = {'P', 'L', 'A', 'C'};
+const uint32_t CACHE_FORMAT_VERSION = 3;
+const uint32_t NOT_IN_SOURCE = 0xFFFFFFFFu; // Token lexeme lives in the string pool instead
+
+// On-disk layout: Header, then the arrays in this order, then the string pool.
+// Every field is 32 bits (or a multiple), so the arrays stay aligned inside the mapping.
+struct Header {
+    char magic[4];
+    uint32_t formatVersion;
+    uint32_t analyzerVersion;
+    uint32_t tokenCount;
+    uint32_t symbolCount;
+    uint32_t usageCount;
+    uint32_t errorCount;
+    uint32_t stringBytes;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+};
+
+// Lexemes are offsets into the source; "EOF" and other lexemes that are not source text go to the pool
+struct TokenRecord {
+    uint32_t type;
+    uint32_t offset; // NOT_IN_SOURCE: poolOffset holds the lexeme
+    uint32_t poolOffset;
+    uint32_t length;
+    uint32_t position; // Token::offset
+};
+
+struct SymbolRecord {
+    uint32_t name; // Pool offsets and lengths
+    uint32_t nameLength;
+    uint32_t dataType;
+    uint32_t dataTypeLength;
+    uint32_t size;
+    uint32_t dimension;
+    uint32_t line;
+    uint32_t firstUsage; // Index into the usage-line array
+    uint32_t usageCount;
+};
+
+// Errors are stored as their compact form (see ErrorHandler.h), with the detail text in the pool
+struct ErrorRecord {
+    uint8_t kind;
+    uint8_t code;
+    uint8_t expected;
+    uint8_t found;
+    uint32_t detail;
+    uint32_t detailLength;
+    uint32_t position; // Error::offset
+};
+
+// Appends strings to the pool and returns their offset
+struct StringPool {
+    std::string bytes;
+
+    uint32_t add(std::string_view text) {
+        uint32_t offset = static_cast<uint32_t>(bytes.size());
+        bytes.append(text);
+        return offset;
+    }
+};
+
+template <typename T>
+void writeArray(std::ofstream& out, const std::vector<T>& items) {
+    out.write(reinterpret_cast<const char*>(items.data()), static_cast<std::streamsize>(items.size() * sizeof(T)));
+}
+
+// Entries hold the results of a stop-at-first-error run at the default nesting limit only
+bool cacheable(const ErrorPolicy& policy) {
+    return !policy.recover && policy.maxNesting == ErrorPolicy().maxNesting;
+}
+
+unsigned long processId() {
+#ifdef _WIN32
+    return static_cast<unsigned long>(::GetCurrentProcessId());
+#else
+    return static_cast<unsigned long>(::getpid());
+#endif
+}
+
+} // namespace
+
+AnalysisCache::AnalysisCache(const std::string& directory)
+    : directory(directory), hitCount(0), missCount(0), storeCount(0) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+}
+
+uint64_t AnalysisCache::hashSource(std::string_view source) {
+    // 8 bytes per step: xor in, multiply by an odd constant, fold the high half down
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = 0x243F6A8885A308D3ull ^ (source.size() * multiplier);
+    size_t i = 0;
+    for (; i + 8 <= source.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, source.data() + i, sizeof(word));
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 32;
+    }
+    uint64_t last = 0;
+    if (i < source.size()) { // An empty source may have no data() to copy from
+        std::memcpy(&last, source.data() + i, source.size() - i);
+    }
+    hash = (hash ^ last) * multiplier;
+    hash ^= hash >> 29;
+    return hash;
+}
+
+std::string AnalysisCache::entryPath(uint64_t sourceHash) const {
+    char name[40];
+    std::snprintf(name, sizeof(name), "%016llx-v%u.plac", static_cast<unsigned long long>(sourceHash), ANALYZER_VERSION);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool AnalysisCache::load(std::string_view source, SymbolTable& symbolTable, ErrorHandler& errorHandler,
+                         size_t& tokenCount, std::vector<Token>* tokens) {
+    if (!cacheable(errorHandler.getPolicy())) {
+        return false;
+    }
+    uint64_t sourceHash = hashSource(source);
+    SourceFile entry;
+    if (!entry.open(entryPath(sourceHash)) || entry.size() < sizeof(Header)) {
+        missCount++;
+        return false;
+    }
+
+    // Check the entry is complete and belongs to exactly this source, then point into the mapping
+    const char* base = entry.contents().data();
+    const Header* header = reinterpret_cast<const Header*>(base);
+    uint64_t expectedSize = sizeof(Header) + uint64_t(header->tokenCount) * sizeof(TokenRecord) +
+                            uint64_t(header->symbolCount) * sizeof(SymbolRecord) + uint64_t(header->usageCount) * sizeof(uint32_t) +
+                            uint64_t(header->errorCount) * sizeof(ErrorRecord) + header->stringBytes;
+    if (std::memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header->formatVersion != CACHE_FORMAT_VERSION || header->analyzerVersion != ANALYZER_VERSION ||
+        header->sourceHash != sourceHash || header->sourceSize != source.size() || entry.size() != expectedSize) {
+        missCount++;
+        return false;
+    }
+    const TokenRecord* tokenRecords = reinterpret_cast<const TokenRecord*>(header + 1);
+    const SymbolRecord* symbolRecords = reinterpret_cast<const SymbolRecord*>(tokenRecords + header->tokenCount);
+    const uint32_t* usageLines = reinterpret_cast<const uint32_t*>(symbolRecords + header->symbolCount);
+    const ErrorRecord* errorRecords = reinterpret_cast<const ErrorRecord*>(usageLines + header->usageCount);
+    const char* pool = reinterpret_cast<const char*>(errorRecords + header->errorCount);
+
+    // Offsets are bounds-checked so a damaged entry is a miss, never a bad read
+    auto poolText = [&](uint32_t offset, uint32_t length, std::string_view& text) {
+        if (static_cast<uint64_t>(offset) + length > header->stringBytes) {
+            return false;
+        }
+        text = std::string_view(pool + offset, length);
+        return true;
+    };
+
+    std::vector<Token> cachedTokens;
+    cachedTokens.reserve(tokens != nullptr ? header->tokenCount : 0);
+    for (uint32_t i = 0; tokens != nullptr && i < header->tokenCount; ++i) {
+        const TokenRecord& record = tokenRecords[i];
+        std::string_view lexeme;
+        if (record.type > static_cast<uint32_t>(TokenType::UNKNOWN) || record.position > source.size()) {
+            missCount++;
+            return false;
+        }
+        if (record.offset != NOT_IN_SOURCE) {
+            if (static_cast<uint64_t>(record.offset) + record.length > source.size()) {
+                missCount++;
+                return false;
+            }
+            lexeme = source.substr(record.offset, record.length);
+        } else {
+            // Only the lexer's string literals end up here (see syntheticLexeme); map back to those
+            std::string_view text;
+            lexeme = syntheticLexeme(static_cast<TokenType>(record.type));
+            if (!poolText(record.poolOffset, record.length, text) || text != lexeme) {
+                missCount++;
+                return false;
+            }
+        }
+        cachedTokens.emplace_back(static_cast<TokenType>(record.type), lexeme, record.position);
+    }
+
+    SymbolTable cachedTable;
+    for (uint32_t i = 0; i < header->symbolCount; ++i) {
+        const SymbolRecord& record = symbolRecords[i];
+        std::string_view name;
+        std::string_view dataType;
+        if (!poolText(record.name, record.nameLength, name) || !poolText(record.dataType, record.dataTypeLength, dataType) ||
+            static_cast<uint64_t>(record.firstUsage) + record.usageCount > header->usageCount ||
+            !cachedTable.insert(name, std::string(dataType), record.size, record.dimension, record.line)) {
+            missCount++;
+            return false;
+        }
+        SymbolTable::SymTabPos pos = static_cast<SymbolTable::SymTabPos>(i);
+        for (uint32_t u = 0; u < record.usageCount; ++u) {
+            cachedTable.addLineOfUsage(pos, usageLines[record.firstUsage + u]);
+        }
+    }
+
+    ErrorHandler cachedErrors;
+    for (uint32_t i = 0; i < header->errorCount; ++i) {
+        const ErrorRecord& record = errorRecords[i];
+        std::string_view detail;
+        if (!poolText(record.detail, record.detailLength, detail) || record.kind > static_cast<uint8_t>(ErrorKind::SYNTAX) ||
+            record.code > static_cast<uint8_t>(ErrorCode::MESSAGE) || record.expected > static_cast<uint8_t>(TokenType::UNKNOWN) ||
+            record.found > static_cast<uint8_t>(TokenType::UNKNOWN) || record.position > source.size()) {
+            missCount++;
+            return false;
+        }
+        cachedErrors.reportError(static_cast<ErrorKind>(record.kind), static_cast<ErrorCode>(record.code), detail,
+                                 record.position, static_cast<TokenType>(record.expected),
+                                 static_cast<TokenType>(record.found));
+    }
+
+    if (tokens != nullptr) {
+        *tokens = std::move(cachedTokens);
+    }
+    tokenCount = header->tokenCount;
+    symbolTable = std::move(cachedTable);
+    errorHandler.clearErrors(); // Keeps the caller's policy, e.g. its maxErrors
+    errorHandler.appendErrors(cachedErrors, 0);
+    hitCount++;
+    return true;
+}
+
+void AnalysisCache::store(std::string_view source, const std::vector<Token>& tokens, const SymbolTable& symbolTable,
+                          const ErrorHandler& errorHandler) {
+    if (source.size() >= NOT_IN_SOURCE || !cacheable(errorHandler.getPolicy())) {
+        return;
+    }
+
+    StringPool pool;
+    std::vector<TokenRecord> tokenRecords;
+    tokenRecords.reserve(tokens.size());
+    for (const Token& token : tokens) {
+        TokenRecord record{static_cast<uint32_t>(token.type), NOT_IN_SOURCE, 0, static_cast<uint32_t>(token.lexeme.size()),
+                           static_cast<uint32_t>(token.offset)};
+        // Pointer comparison through uintptr_t: lexemes from string literals are outside the buffer
+        uintptr_t at = reinterpret_cast<uintptr_t>(token.lexeme.data());
+        uintptr_t begin = reinterpret_cast<uintptr_t>(source.data());
+        if (at >= begin && at + token.lexeme.size() <= begin + source.size()) {
+            record.offset = static_cast<uint32_t>(at - begin);
+        } else {
+            record.poolOffset = pool.add(token.lexeme);
+        }
+        tokenRecords.push_back(record);
+    }
+
+    std::vector<SymbolRecord> symbolRecords;
+    std::vector<uint32_t> usageLines;
+    for (const STEntry& entry : symbolTable.getEntries()) {
+        SymbolRecord record{};
+        record.nameLength = static_cast<uint32_t>(entry.name.size());
+        record.name = pool.add(entry.name);
+        record.dataTypeLength = static_cast<uint32_t>(entry.dataType.size());
+        record.dataType = pool.add(entry.dataType);
+        record.size = static_cast<uint32_t>(entry.size);
+        record.dimension = static_cast<uint32_t>(entry.dimension);
+        record.line = static_cast<uint32_t>(entry.lineOfDeclaration);
+        record.firstUsage = static_cast<uint32_t>(usageLines.size());
+        record.usageCount = static_cast<uint32_t>(entry.linesOfUsage.size());
+        for (size_t line : entry.linesOfUsage) {
+            usageLines.push_back(static_cast<uint32_t>(line));
+        }
+        symbolRecords.push_back(record);
+    }
+
+    std::vector<ErrorRecord> errorRecords;
+    for (const Error& error : errorHandler.getErrors()) {
+        ErrorRecord record{};
+        record.kind = static_cast<uint8_t>(error.kind);
+        record.code = static_cast<uint8_t>(error.code);
+        record.expected = static_cast<uint8_t>(error.expected);
+        record.found = static_cast<uint8_t>(error.found);
+        record.detailLength = static_cast<uint32_t>(error.detail.size());
+        record.detail = pool.add(error.detail);
+        record.position = static_cast<uint32_t>(error.offset);
+        errorRecords.push_back(record);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.formatVersion = CACHE_FORMAT_VERSION;
+    header.analyzerVersion = ANALYZER_VERSION;
+    header.tokenCount = static_cast<uint32_t>(tokenRecords.size());
+    header.symbolCount = static_cast<uint32_t>(symbolRecords.size());
+    header.usageCount = static_cast<uint32_t>(usageLines.size());
+    header.errorCount = static_cast<uint32_t>(errorRecords.size());
+    header.stringBytes = static_cast<uint32_t>(pool.bytes.size());
+    header.sourceHash = hashSource(source);
+    header.sourceSize = source.size();
+
+    // Write next to the final name, then rename over it in one step
+    std::string path = entryPath(header.sourceHash);
+    // The temporary name must not clash with other workers or other processes writing the same
+    // entry: thread ids and counters repeat across processes sharing a cache directory, pids do not
+    static std::atomic<unsigned> tempCounter(0);
+    std::string tempPath = path + ".tmp" + std::to_string(processId()) + "-" +
+                           std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "-" +
+                           std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "-" +
+                           std::to_string(tempCounter++);
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeArray(out, tokenRecords);
+        writeArray(out, symbolRecords);
+        writeArray(out, usageLines);
+        writeArray(out, errorRecords);
+        out.write(pool.bytes.data(), static_cast<std::streamsize>(pool.bytes.size()));
+        if (!out.good()) {
+            out.close();
+            std::remove(tempPath.c_str());
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::remove(tempPath.c_str());
+        return;
+    }
+    storeCount++;
+}
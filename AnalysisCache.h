@@ -0,0 +1,56 @@
+#ifndef ANALYSISCACHE_H
+#define ANALYSISCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Token.h"
+#include "SymbolTable.h"
+#include "ErrorHandler.h"
+
+// Bump whenever a change to the Lexer, Parser, SymbolTable or TypeInference changes their results,
+// so entries written by an older analyzer are never read back
+const uint32_t ANALYZER_VERSION = 8;
+
+// Persistent, content-addressed cache of analysis results (tokens, symbol table, errors).
+// Each result is one file in the cache directory, named after a hash of the source bytes and
+// ANALYZER_VERSION. Entries use a fixed binary layout of 32-bit fields (native byte order) that
+// is memory-mapped and read in place: no text is parsed on a hit, and token lexemes are rebuilt
+// as views into the caller's source buffer.
+// Entries are written to a temporary file and renamed into place, so concurrent runs and batch
+// workers never see a partial one. Sources of 4 GiB or more are not cached, and neither are runs
+// with ErrorPolicy::recover or a non-default maxNesting.
+class AnalysisCache {
+private:
+    std::string directory;
+    std::atomic<size_t> hitCount;
+    std::atomic<size_t> missCount;
+    std::atomic<size_t> storeCount;
+
+    std::string entryPath(uint64_t sourceHash) const;
+
+public:
+    // Creates the directory if needed
+    explicit AnalysisCache(const std::string& directory);
+
+    // Fast 64-bit hash of the source bytes (not cryptographic)
+    static uint64_t hashSource(std::string_view source);
+
+    // On a hit fills in the results of analyzing source and returns true. The tokens are only
+    // rebuilt if asked for (they view into source); tokenCount is always set.
+    bool load(std::string_view source, SymbolTable& symbolTable, ErrorHandler& errorHandler, size_t& tokenCount,
+              std::vector<Token>* tokens = nullptr);
+
+    // Saves the results of analyzing source; failures only mean the next run misses again
+    void store(std::string_view source, const std::vector<Token>& tokens, const SymbolTable& symbolTable,
+               const ErrorHandler& errorHandler);
+
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+    size_t stores() const { return storeCount; }
+};
+
+#endif
@@ -0,0 +1,440 @@
+// implementation of AnalysisServer.h
+
+#include "AnalysisServer.h"
+#include "ThreadPool.h"
+#include "SourceFile.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "TypeInference.h"
+#include "SymbolTable.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Buffers a worker reuses from one request to the next. Anything that grew past these caps for
+// one huge file is released afterwards, so an idle server does not sit on it.
+const size_t KEEP_TOKENS = 1 << 20;
+const size_t KEEP_RESPONSE_BYTES = 16 << 20;
+
+struct Workspace {
+    TokenBuffer tokens;
+    std::vector<Token> largeTokens; // For sources too large for a TokenBuffer
+    LineIndex lines;
+    SymbolTable symbolTable;
+    Ast ast;
+    std::string response;
+};
+
+Workspace& workspace() {
+    thread_local Workspace instance;
+    return instance;
+}
+
+} // namespace
+
+void AnalysisServer::handle(const ServerProtocol::Request& request, ErrorPolicy defaults, std::string& out) {
+    using ServerProtocol::ResponseStatus;
+    Workspace& ws = workspace();
+
+    ErrorPolicy policy = defaults;
+    if (request.flags & ServerProtocol::RECOVER) {
+        policy.recover = true;
+    }
+    if (request.maxErrors != 0) {
+        policy.maxErrors = request.maxErrors;
+    }
+    ErrorHandler errorHandler(policy);
+    ws.symbolTable.clear();
+
+    SourceFile source;
+    std::string_view text = request.text;
+    if (request.kind == ServerProtocol::RequestKind::PATH) {
+        bool opened;
+        {
+            Stats::PhaseTimer timer(Stats::Phase::READ);
+            opened = source.open(std::string(request.text));
+        }
+        if (!opened) {
+            ServerProtocol::encodeResponse(request.requestId, ResponseStatus::READ_FAILED, 0, ws.symbolTable,
+                                           errorHandler, LineIndex(), out);
+            return;
+        }
+        text = source.contents();
+    }
+    ws.lines.reset(text); // Only built if the parser or an error needs a line
+
+    bool large = !TokenBuffer::fits(text);
+    {
+        Stats::PhaseTimer timer(Stats::Phase::LEX);
+        Lexer lexer(text, errorHandler);
+        if (large) {
+            lexer.tokenize(ws.largeTokens);
+        } else {
+            lexer.tokenize(ws.tokens);
+        }
+    }
+    size_t tokenCount = large ? ws.largeTokens.size() : ws.tokens.size();
+    // Same rule as the other modes: lexical errors stop the analysis before parsing
+    if (!errorHandler.hasErrors()) {
+        Parser parser = large ? Parser(ws.largeTokens, ws.lines, ws.symbolTable, errorHandler)
+                              : Parser(ws.tokens, ws.lines, ws.symbolTable, errorHandler);
+        parser.getAst() = std::move(ws.ast); // parse() clears it but keeps the node capacity
+        {
+            Stats::PhaseTimer timer(Stats::Phase::PARSE);
+            parser.parse();
+        }
+        {
+            Stats::PhaseTimer timer(Stats::Phase::INFER);
+            TypeInference(parser.getAst(), ws.symbolTable).run();
+        }
+        ws.ast = std::move(parser.getAst());
+    }
+
+    Stats::PhaseTimer timer(Stats::Phase::PRINT);
+    ServerProtocol::encodeResponse(request.requestId, ResponseStatus::OK, tokenCount, ws.symbolTable, errorHandler,
+                                   ws.lines, out);
+    if (tokenCount > KEEP_TOKENS) {
+        ws.tokens = TokenBuffer();
+        std::vector<Token>().swap(ws.largeTokens);
+        ws.lines = LineIndex();
+        ws.ast = Ast();
+    }
+}
+
+#ifndef _WIN32
+
+struct AnalysisServer::Connection {
+    int fd;
+    std::string input;               // Received bytes not yet cut into frames (poll thread only)
+    std::string sending;             // Responses being written, from sent on (poll thread only)
+    size_t sent = 0;
+    bool readClosed = false;         // The client ended its stream (poll thread only)
+    std::mutex queueMutex;
+    std::string queued;              // Finished response frames the poll thread has not taken yet
+    std::atomic<size_t> unsent{0};   // Bytes in queued and in sending past sent
+    std::atomic<size_t> inFlight{0}; // Requests handed to the pool and not yet answered
+
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { ::close(fd); }
+};
+
+namespace {
+
+bool setNonBlocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+} // namespace
+
+AnalysisServer::AnalysisServer(const std::string& socketPath, size_t threadCount, ErrorPolicy policy)
+    : socketPath(socketPath), threadCount(threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threadCount),
+      policy(policy), listenFd(-1), wakePipe{-1, -1}, stopRequested(false), requestCount(0), connectionCount(0) {}
+
+AnalysisServer::~AnalysisServer() {
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        ::unlink(socketPath.c_str());
+    }
+    for (int fd : wakePipe) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+bool AnalysisServer::listen() {
+    sockaddr_un address{};
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: Socket path must be 1 to " << sizeof(address.sun_path) - 1 << " bytes long" << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    struct stat info;
+    if (::stat(socketPath.c_str(), &info) == 0) {
+        int probe = ServerProtocol::connectTo(socketPath);
+        if (probe >= 0 || !S_ISSOCK(info.st_mode)) {
+            if (probe >= 0) {
+                ::close(probe);
+            }
+            std::cerr << "Error: " << socketPath << " is in use" << std::endl;
+            return false;
+        }
+        ::unlink(socketPath.c_str()); // Stale socket: nobody is listening on it
+    }
+
+    // A client that disconnects early must not kill the server when it is answered
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Only the server's own user may connect (set before listening, so nobody connects earlier):
+    // a PATH request reads any file the server can read
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::chmod(socketPath.c_str(), S_IRUSR | S_IWUSR) != 0 || ::listen(listenFd, SOMAXCONN) != 0 || !setNonBlocking(listenFd) || ::pipe(wakePipe) != 0 ||
+        !setNonBlocking(wakePipe[0]) || !setNonBlocking(wakePipe[1])) {
+        std::cerr << "Error: Cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void AnalysisServer::wake() {
+    char byte = 0;
+    // A full pipe already has a wake-up pending, so a failed write is fine
+    [[maybe_unused]] ssize_t ignored = ::write(wakePipe[1], &byte, 1);
+}
+
+void AnalysisServer::stop() {
+    stopRequested.store(true);
+    if (wakePipe[1] >= 0) {
+        wake();
+    }
+}
+
+// Submits the complete frames at the start of the connection's input while it has fewer than
+// MAX_IN_FLIGHT requests pending; the rest stay buffered until answers come back. Returns false
+// on an oversized frame.
+bool AnalysisServer::submitRequests(const std::shared_ptr<Connection>& connection, ThreadPool& pool) {
+    size_t offset = 0;
+    std::string& input = connection->input;
+    bool valid = true;
+    while (connection->inFlight.load() < MAX_IN_FLIGHT && input.size() - offset >= sizeof(uint32_t)) {
+        uint32_t length;
+        std::memcpy(&length, input.data() + offset, sizeof(length));
+        if (length > ServerProtocol::MAX_FRAME_BYTES) {
+            valid = false;
+            break;
+        }
+        if (input.size() - offset - sizeof(uint32_t) < length) {
+            break; // A partial frame waits for the rest
+        }
+        std::string payload = input.substr(offset + sizeof(uint32_t), length);
+        offset += sizeof(uint32_t) + length;
+        connection->inFlight.fetch_add(1);
+        pool.submit([this, connection, payload = std::move(payload)] { serveRequest(connection, payload); });
+    }
+    input.erase(0, offset);
+    return valid;
+}
+
+// Reads whatever has arrived and submits the complete frames. End of stream only stops the
+// reading, since the requests taken in are still answered. Returns false when the connection
+// should be dropped: a read error or an oversized frame.
+bool AnalysisServer::readRequests(const std::shared_ptr<Connection>& connection, ThreadPool& pool) {
+    char chunk[1 << 16];
+    while (connection->inFlight.load() < MAX_IN_FLIGHT && connection->unsent.load() < MAX_UNSENT_BYTES) {
+        ssize_t received = ::recv(connection->fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received == 0) {
+            connection->readClosed = true;
+            break;
+        }
+        if (received < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection->input.append(chunk, static_cast<size_t>(received));
+        if (!submitRequests(connection, pool)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Writes queued responses until the socket would block. Returns false if the client is gone.
+bool AnalysisServer::writeResponses(Connection& connection) {
+    while (true) {
+        if (connection.sent == connection.sending.size()) {
+            connection.sent = 0;
+            connection.sending.clear();
+            if (connection.sending.capacity() > KEEP_RESPONSE_BYTES) {
+                std::string().swap(connection.sending);
+            }
+            std::lock_guard<std::mutex> lock(connection.queueMutex);
+            if (connection.queued.empty()) {
+                return true;
+            }
+            connection.sending.swap(connection.queued); // queued keeps the emptied buffer
+        }
+        ssize_t written =
+            ::send(connection.fd, connection.sending.data() + connection.sent, connection.sending.size() - connection.sent, 0);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection.sent += static_cast<size_t>(written);
+        connection.unsent.fetch_sub(static_cast<size_t>(written));
+    }
+}
+
+void AnalysisServer::serveRequest(const std::shared_ptr<Connection>& connection, const std::string& payload) {
+    std::string& out = workspace().response;
+    out.clear();
+    ServerProtocol::Request request;
+    if (ServerProtocol::decodeRequest(payload, request)) {
+        handle(request, policy, out);
+    } else {
+        ServerProtocol::encodeResponse(request.requestId, ServerProtocol::ResponseStatus::BAD_REQUEST, 0, SymbolTable(),
+                                       ErrorHandler(), LineIndex(), out);
+    }
+    {
+        std::lock_guard<std::mutex> lock(connection->queueMutex);
+        connection->queued += out;
+        connection->unsent.fetch_add(out.size());
+    }
+    if (out.capacity() > KEEP_RESPONSE_BYTES) {
+        std::string().swap(out);
+    }
+    requestCount.fetch_add(1, std::memory_order_relaxed);
+    // Counted down after the response is queued, so a connection with nothing in flight and
+    // nothing unsent is really done
+    connection->inFlight.fetch_sub(1);
+    wake(); // The poll loop sends the response
+}
+
+void AnalysisServer::run() {
+    ThreadPool pool(threadCount);
+    std::vector<std::shared_ptr<Connection>> connections;
+    std::vector<pollfd> fds;
+    while (!stopRequested.load()) {
+        // Submit the frames left buffered by the MAX_IN_FLIGHT limit, as far as the answers that
+        // came back allow, and send what the workers finished since the last round. A connection
+        // is closed once it fails, or once its client ended the stream and has every answer.
+        size_t kept = 0;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            Connection& connection = *connections[i];
+            bool keep = submitRequests(connections[i], pool) &&
+                        (connection.unsent.load() == 0 || writeResponses(connection)) &&
+                        !(connection.readClosed && connection.inFlight.load() == 0 && connection.unsent.load() == 0);
+            if (keep) {
+                connections[kept++] = std::move(connections[i]);
+            }
+        }
+        connections.resize(kept);
+
+        fds.clear();
+        fds.push_back(pollfd{listenFd, POLLIN, 0});
+        fds.push_back(pollfd{wakePipe[0], POLLIN, 0});
+        for (const auto& connection : connections) {
+            // A connection with too many requests pending or too much output its client has not
+            // read is not read from until that drains. One waiting for nothing but its workers is
+            // left out (a negative fd is ignored), as poll would keep reporting its hangup.
+            short events = 0;
+            if (!connection->readClosed && connection->inFlight.load() < MAX_IN_FLIGHT &&
+                connection->unsent.load() < MAX_UNSENT_BYTES) {
+                events |= POLLIN;
+            }
+            if (connection->unsent.load() > 0) {
+                events |= POLLOUT;
+            }
+            fds.push_back(pollfd{events != 0 ? connection->fd : -1, events, 0});
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char drain[64];
+            while (::read(wakePipe[0], drain, sizeof(drain)) > 0) {
+            }
+        }
+
+        // Existing connections first, so the indices in fds still line up. Writable ones are
+        // written at the top of the next round.
+        kept = 0;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            bool keep = true;
+            const pollfd& polled = fds[i + 2];
+            if ((polled.events & POLLIN) && (polled.revents & (POLLIN | POLLHUP | POLLERR))) {
+                keep = readRequests(connections[i], pool);
+            }
+            if (keep) {
+                connections[kept++] = std::move(connections[i]);
+            }
+        }
+        // Dropped connections close once their last in-flight request has been answered
+        connections.resize(kept);
+
+        if (fds[0].revents & POLLIN) {
+            while (true) {
+                int fd = ::accept(listenFd, nullptr, nullptr);
+                if (fd < 0) {
+                    break;
+                }
+                if (!setNonBlocking(fd)) {
+                    ::close(fd);
+                    continue;
+                }
+                connections.push_back(std::make_shared<Connection>(fd));
+                connectionCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    // Answer the requests already submitted, then send what fits without waiting on a client
+    pool.wait();
+    for (const auto& connection : connections) {
+        writeResponses(*connection);
+    }
+}
+
+#else
+
+struct AnalysisServer::Connection {};
+
+AnalysisServer::AnalysisServer(const std::string& socketPath, size_t threadCount, ErrorPolicy policy)
+    : socketPath(socketPath), threadCount(threadCount), policy(policy), listenFd(-1), wakePipe{-1, -1},
+      stopRequested(false), requestCount(0), connectionCount(0) {}
+
+AnalysisServer::~AnalysisServer() {}
+
+bool AnalysisServer::listen() {
+    std::cerr << "Error: The analysis server needs Unix domain sockets, which this build does not support" << std::endl;
+    return false;
+}
+
+void AnalysisServer::wake() {}
+void AnalysisServer::stop() {}
+void AnalysisServer::run() {}
+
+bool AnalysisServer::submitRequests(const std::shared_ptr<Connection>&, ThreadPool&) {
+    return false;
+}
+
+bool AnalysisServer::readRequests(const std::shared_ptr<Connection>&, ThreadPool&) {
+    return false;
+}
+
+bool AnalysisServer::writeResponses(Connection&) {
+    return false;
+}
+
+void AnalysisServer::serveRequest(const std::shared_ptr<Connection>&, const std::string&) {}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef ANALYSISSERVER_H
+#define ANALYSISSERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "ErrorHandler.h"
+#include "ServerProtocol.h"
+
+class ThreadPool;
+
+// Long-running analyzer listening on a Unix domain socket (see ServerProtocol.h for the frames).
+// One thread polls the listening socket and every connection, cuts complete request frames out
+// of what arrives and hands them to a work-stealing ThreadPool. A worker never touches the socket:
+// it appends the response frame to the connection's output queue and wakes the poll thread, which
+// writes it out as the client reads. Many clients can be connected at once. The server stops
+// reading from a client that has MAX_IN_FLIGHT requests pending or MAX_UNSENT_BYTES of responses
+// it has not read yet, and submits no more than MAX_IN_FLIGHT of its requests at a time (the
+// rest stay in its input buffer), so a client that never reads holds its own buffer and no worker.
+// Each worker keeps its token buffer, line index, symbol table, AST and response buffer between
+// requests, so a warmed-up server analyzes a file without growing any of them again.
+// POSIX only; on Windows listen() fails.
+class AnalysisServer {
+private:
+    struct Connection;
+
+    std::string socketPath;
+    size_t threadCount;
+    ErrorPolicy policy; // Default for requests that do not ask for recovery themselves
+    int listenFd;
+    int wakePipe[2]; // stop() and finished requests wake the poll loop through this pipe
+    std::atomic<bool> stopRequested;
+    std::atomic<uint64_t> requestCount;
+    std::atomic<uint64_t> connectionCount;
+
+    void wake();
+    bool submitRequests(const std::shared_ptr<Connection>& connection, ThreadPool& pool);
+    bool readRequests(const std::shared_ptr<Connection>& connection, ThreadPool& pool);
+    static bool writeResponses(Connection& connection);
+    void serveRequest(const std::shared_ptr<Connection>& connection, const std::string& payload);
+
+public:
+    static const size_t MAX_IN_FLIGHT = 64;          // Per connection
+    static const size_t MAX_UNSENT_BYTES = 16 << 20; // Per connection
+
+    AnalysisServer(const std::string& socketPath, size_t threadCount, ErrorPolicy policy = ErrorPolicy());
+    ~AnalysisServer(); // Closes the socket and removes its file
+
+    AnalysisServer(const AnalysisServer&) = delete;
+    AnalysisServer& operator=(const AnalysisServer&) = delete;
+
+    // Creates the socket, readable and writable by the server's user only (mode 0600): a client can
+    // have the server read any file it can read. A stale socket file left by a crashed server is
+    // replaced, but one that a live server still answers on is not. Returns false (and prints
+    // why) on failure.
+    bool listen();
+
+    // Serves until stop(), then finishes the requests already taken in and sends whatever
+    // responses the clients' sockets accept without waiting
+    void run();
+
+    // Async-signal-safe, so a SIGINT/SIGTERM handler may call it
+    void stop();
+
+    // Analyzes one request and appends the response frame to out. Called by the workers; it is
+    // thread-safe and does not need a running server.
+    static void handle(const ServerProtocol::Request& request, ErrorPolicy defaults, std::string& out);
+
+    uint64_t requestsServed() const { return requestCount.load(std::memory_order_relaxed); }
+    uint64_t connectionsAccepted() const { return connectionCount.load(std::memory_order_relaxed); }
+    size_t threads() const { return threadCount; }
+};
+
+#endif
@@ -0,0 +1,229 @@
+// implementation of BatchAnalyzer.h
+
+#include "BatchAnalyzer.h"
+#include "AnalysisCache.h"
+#include "ThreadPool.h"
+#include "SourceFile.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "TypeInference.h"
+#include "SymbolTable.h"
+#include "ErrorHandler.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+
+BatchAnalyzer::BatchAnalyzer(size_t threadCount, AnalysisCache* cache, OutputFormat format, ErrorPolicy policy)
+    : threadCount(threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threadCount), cache(cache),
+      format(format), policy(policy) {}
+
+std::vector<std::string> BatchAnalyzer::collectFiles(const std::vector<std::string>& inputs) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    for (const std::string& input : inputs) {
+        std::error_code ec;
+        if (!fs::is_directory(input, ec)) {
+            files.push_back(input);
+            continue;
+        }
+        std::vector<std::string> found;
+        for (fs::recursive_directory_iterator it(input, ec), end; it != end; it.increment(ec)) {
+            if (ec) {
+                break;
+            }
+            if (it->is_regular_file(ec) && it->path().extension() == ".py") {
+                found.push_back(it->path().string());
+            }
+        }
+        // Directory iteration order is unspecified, so sort to keep the output deterministic
+        std::sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    return files;
+}
+
+FileReport BatchAnalyzer::analyzeFile(const std::string& path, AnalysisCache* cache, OutputFormat format, ErrorPolicy policy) {
+    FileReport report;
+    report.path = path;
+    std::ostringstream out;
+    if (format == OutputFormat::TABLE) {
+        out << "\n=== " << path << " ===" << std::endl;
+    }
+
+    SourceFile source;
+    bool opened;
+    {
+        Stats::PhaseTimer timer(Stats::Phase::READ);
+        opened = source.open(path);
+    }
+    if (!opened) {
+        report.readFailed = true;
+        if (format == OutputFormat::TABLE) {
+            out << "Error: Failed to open file " << path << std::endl;
+            report.output = out.str();
+        }
+        return report;
+    }
+    report.bytes = source.size();
+    LineIndex lines(source.contents());
+
+    ErrorHandler errorHandler(policy);
+    SymbolTable symbolTable;
+    bool lexicalErrors = false;
+    bool cached = false;
+    // Formats with token records need the tokens back from a cache hit
+    bool wantTokens = format == OutputFormat::NDJSON || format == OutputFormat::CSV || format == OutputFormat::BINARY;
+    std::vector<Token> tokens;
+    if (cache != nullptr) {
+        // A hit reads the results instead of lexing and parsing, so it counts as reading
+        Stats::PhaseTimer timer(Stats::Phase::READ);
+        cached = cache->load(source.contents(), symbolTable, errorHandler, report.tokens, wantTokens ? &tokens : nullptr);
+    }
+    if (cached) {
+        for (const Error& error : errorHandler.getErrors()) {
+            lexicalErrors = lexicalErrors || error.kind == ErrorKind::LEXICAL;
+        }
+    } else {
+        // Without token records or a cache to fill, the compact TokenBuffer is enough
+        bool compact = !wantTokens && cache == nullptr && TokenBuffer::fits(source.contents());
+        TokenBuffer buffer;
+        {
+            Stats::PhaseTimer timer(Stats::Phase::LEX);
+            Lexer lexer(source.contents(), errorHandler);
+            if (compact) {
+                lexer.tokenize(buffer);
+            } else {
+                lexer.tokenize(tokens);
+            }
+        }
+        report.tokens = compact ? buffer.size() : tokens.size();
+        // Same rule as the single-file mode: lexical errors stop the analysis before parsing
+        lexicalErrors = errorHandler.hasErrors();
+        if (!lexicalErrors) {
+            Parser parser = compact ? Parser(buffer, lines, symbolTable, errorHandler)
+                                    : Parser(tokens, lines, symbolTable, errorHandler);
+            {
+                Stats::PhaseTimer timer(Stats::Phase::PARSE);
+                parser.parse();
+            }
+            Stats::PhaseTimer timer(Stats::Phase::INFER);
+            TypeInference(parser.getAst(), symbolTable).run();
+        }
+        if (cache != nullptr) {
+            cache->store(source.contents(), tokens, symbolTable, errorHandler);
+        }
+    }
+    for (const Error& error : errorHandler.getErrors()) {
+        if (error.kind == ErrorKind::LEXICAL) {
+            report.lexicalErrors++;
+        } else {
+            report.syntaxErrors++;
+        }
+    }
+
+    Stats::PhaseTimer timer(Stats::Phase::PRINT);
+    if (format != OutputFormat::TABLE) {
+        OutputWriter writer(format, 0);
+        writer.writeFile(path, source.contents(), lines, wantTokens ? &tokens : nullptr, report.tokens, symbolTable,
+                         errorHandler);
+        report.output = writer.takeContents();
+        return report;
+    }
+    if (!lexicalErrors) {
+        symbolTable.printTable(out);
+    }
+    errorHandler.printErrors(lines, out);
+    report.output = out.str();
+    return report;
+}
+
+BatchSummary BatchAnalyzer::run(const std::vector<std::string>& files, std::ostream& out) {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+
+    std::vector<FileReport> reports(files.size());
+    std::vector<bool> finished(files.size(), false);
+    std::mutex finishedMutex;
+    std::condition_variable reportReady;
+
+    BatchSummary summary;
+    summary.threads = threadCount;
+    size_t hitsBefore = cache != nullptr ? cache->hits() : 0;
+    size_t missesBefore = cache != nullptr ? cache->misses() : 0;
+    if (format == OutputFormat::CSV) {
+        OutputWriter header(format, 64);
+        header.writeHeader();
+        out << header.contents();
+    }
+    {
+        ThreadPool pool(threadCount);
+        for (size_t i = 0; i < files.size(); ++i) {
+            pool.submit([&, i] {
+                FileReport report = analyzeFile(files[i], cache, format, policy);
+                std::lock_guard<std::mutex> lock(finishedMutex);
+                reports[i] = std::move(report);
+                finished[i] = true;
+                reportReady.notify_one();
+            });
+        }
+
+        // Write reports in input order as soon as each one (and everything before it) is done
+        for (size_t i = 0; i < files.size(); ++i) {
+            std::unique_lock<std::mutex> lock(finishedMutex);
+            reportReady.wait(lock, [&] { return finished[i]; });
+            FileReport report = std::move(reports[i]);
+            lock.unlock();
+
+            {
+                Stats::PhaseTimer timer(Stats::Phase::PRINT);
+                out << report.output;
+                if (report.readFailed && format != OutputFormat::TABLE) {
+                    std::cerr << "Error: Failed to open file " << report.path << std::endl;
+                }
+            }
+            summary.files++;
+            summary.unreadableFiles += report.readFailed;
+            summary.filesWithErrors += (report.readFailed || report.lexicalErrors + report.syntaxErrors > 0);
+            summary.lexicalErrors += report.lexicalErrors;
+            summary.syntaxErrors += report.syntaxErrors;
+            summary.tokens += report.tokens;
+            summary.bytes += report.bytes;
+        }
+    }
+
+    summary.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (cache != nullptr) {
+        summary.cacheEnabled = true;
+        summary.cacheHits = cache->hits() - hitsBefore;
+        summary.cacheMisses = cache->misses() - missesBefore;
+    }
+    return summary;
+}
+
+void BatchAnalyzer::printSummary(const BatchSummary& summary, std::ostream& out) {
+    double seconds = summary.seconds > 0 ? summary.seconds : 1e-9;
+    out << "\n--- Batch Summary ---" << std::endl;
+    out << std::left << std::setw(20) << "Files" << summary.files << std::endl;
+    out << std::setw(20) << "Files with errors" << summary.filesWithErrors << std::endl;
+    out << std::setw(20) << "Unreadable files" << summary.unreadableFiles << std::endl;
+    out << std::setw(20) << "Lexical errors" << summary.lexicalErrors << std::endl;
+    out << std::setw(20) << "Syntax errors" << summary.syntaxErrors << std::endl;
+    out << std::setw(20) << "Tokens" << summary.tokens << std::endl;
+    out << std::setw(20) << "Bytes" << summary.bytes << std::endl;
+    out << std::setw(20) << "Threads" << summary.threads << std::endl;
+    if (summary.cacheEnabled) {
+        out << std::setw(20) << "Cache hits" << summary.cacheHits << std::endl;
+        out << std::setw(20) << "Cache misses" << summary.cacheMisses << std::endl;
+    }
+    out << std::setw(20) << "Elapsed (s)" << std::fixed << std::setprecision(3) << summary.seconds << std::endl;
+    out << std::setw(20) << "Files/s" << std::setprecision(1) << static_cast<double>(summary.files) / seconds << std::endl;
+    out << std::setw(20) << "Tokens/s" << static_cast<double>(summary.tokens) / seconds << std::endl;
+    out << "---------------------" << std::endl;
+    out << std::defaultfloat;
+}
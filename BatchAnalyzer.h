@@ -0,0 +1,69 @@
+#ifndef BATCHANALYZER_H
+#define BATCHANALYZER_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include "OutputWriter.h"
+#include "ErrorHandler.h"
+
+class AnalysisCache;
+
+// Result of analyzing one file in batch mode
+struct FileReport {
+    std::string path;
+    bool readFailed = false;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    size_t lexicalErrors = 0;
+    size_t syntaxErrors = 0;
+    std::string output; // Symbol table and errors (or the chosen OutputFormat's records), printed in input order
+};
+
+// Aggregate numbers for a whole batch
+struct BatchSummary {
+    size_t files = 0;
+    size_t filesWithErrors = 0;
+    size_t unreadableFiles = 0;
+    size_t lexicalErrors = 0;
+    size_t syntaxErrors = 0;
+    size_t tokens = 0;
+    size_t bytes = 0;
+    size_t threads = 0;
+    double seconds = 0;
+    bool cacheEnabled = false;
+    size_t cacheHits = 0;
+    size_t cacheMisses = 0;
+};
+
+// Runs Lexer -> Parser -> SymbolTable over many files on a work-stealing ThreadPool.
+// Every file gets its own ErrorHandler and SymbolTable, and reports are written in input order
+// no matter which worker finishes first, so the output is the same for any thread count.
+// With an AnalysisCache, unchanged files are answered from the cache without lexing or parsing.
+class BatchAnalyzer {
+private:
+    size_t threadCount;
+    AnalysisCache* cache; // Not owned; may be null
+    OutputFormat format;
+    ErrorPolicy policy;
+
+public:
+    explicit BatchAnalyzer(size_t threadCount, AnalysisCache* cache = nullptr, OutputFormat format = OutputFormat::TABLE,
+                           ErrorPolicy policy = ErrorPolicy());
+
+    // Expands directories into the .py files below them (sorted), keeping other paths as given
+    static std::vector<std::string> collectFiles(const std::vector<std::string>& inputs);
+
+    // Analyzes a single file; safe to call from several threads at once
+    static FileReport analyzeFile(const std::string& path, AnalysisCache* cache = nullptr,
+                                  OutputFormat format = OutputFormat::TABLE, ErrorPolicy policy = ErrorPolicy());
+
+    // Analyzes every file, streaming each report to out in input order. Outside OutputFormat::TABLE,
+    // unreadable files are reported on std::cerr so they do not break the machine-readable output.
+    BatchSummary run(const std::vector<std::string>& files, std::ostream& out = std::cout);
+
+    static void printSummary(const BatchSummary& summary, std::ostream& out = std::cout);
+};
+
+#endif
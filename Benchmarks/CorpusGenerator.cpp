@@ -0,0 +1,166 @@
+// implementation of CorpusGenerator.h
+
+#include "CorpusGenerator.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+class Generator {
+private:
+    const CorpusShape& shape;
+    std::mt19937 rng;
+    std::vector<std::string> names;
+    size_t declared; // names[0, declared) have been assigned and may be used
+    std::string out;
+
+    bool chance(double probability) {
+        return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < probability;
+    }
+
+    size_t pick(size_t count) {
+        return std::uniform_int_distribution<size_t>(0, count - 1)(rng);
+    }
+
+    void literal() {
+        if (chance(shape.stringDensity)) {
+            static const char* words[] = {"total", "value is", "Hello!!", "done", "result:", "x y z"};
+            out += '"';
+            out += words[pick(6)];
+            out += '"';
+            return;
+        }
+        switch (pick(4)) {
+        case 0: out += std::to_string(pick(1000)); break;
+        case 1: out += std::to_string(pick(100)) + "." + std::to_string(pick(100)); break;
+        case 2: out += pick(2) ? "True" : "False"; break;
+        default: out += std::to_string(pick(10)); break;
+        }
+    }
+
+    void operand() {
+        if (declared > 0 && pick(2) == 0) {
+            out += names[pick(declared)];
+        } else {
+            literal();
+        }
+    }
+
+    void expression(size_t depth) {
+        if (depth == 0 || pick(3) == 0) {
+            operand();
+            return;
+        }
+        static const char* operators[] = {" + ", " - ", " * ", " / ", " % "};
+        bool parens = pick(3) == 0;
+        if (parens) {
+            out += '(';
+        }
+        expression(depth - 1);
+        out += operators[pick(5)];
+        expression(depth - 1);
+        if (parens) {
+            out += ')';
+        }
+    }
+
+    void condition() {
+        static const char* comparisons[] = {" < ", " > ", " <= ", " >= ", " == ", " != "};
+        expression(shape.expressionDepth > 0 ? shape.expressionDepth - 1 : 0);
+        out += comparisons[pick(6)];
+        expression(shape.expressionDepth > 0 ? shape.expressionDepth - 1 : 0);
+    }
+
+    // A statement that fits on one line, usable as a top-level statement or as a body
+    void simpleStatement() {
+        size_t kind = pick(10);
+        if (kind < 6 || declared == 0) {
+            // Assign either a fresh name (declaration) or an existing one
+            bool fresh = declared < names.size() && (declared == 0 || pick(2) == 0);
+            size_t target = fresh ? declared : pick(declared);
+            out += names[target] + " = ";
+            expression(shape.expressionDepth);
+            declared += fresh;
+        } else if (kind < 9) {
+            out += "print(";
+            expression(shape.expressionDepth);
+            out += ')';
+        } else {
+            out += names[pick(declared)] + " = input(\"Enter value: \")";
+        }
+    }
+
+    // The ':' and indented lines of an if/elif/else/while, without the final newline
+    void body() {
+        size_t count = shape.blockStatements > 1 ? 1 + pick(shape.blockStatements) : 1;
+        for (size_t i = 0; i < count; ++i) {
+            out += i == 0 ? ":\n    " : "\n    ";
+            simpleStatement();
+        }
+    }
+
+    // Breaks the statement just written: a stray character, an unclosed string, a missing ')'
+    void injectError(size_t statementStart) {
+        switch (pick(3)) {
+        case 0: out += " $"; break;
+        case 1: out += " \"unterminated"; break;
+        default: out.insert(statementStart, "print(("); break;
+        }
+    }
+
+    void statement() {
+        if (chance(shape.commentDensity)) {
+            out += "# step " + std::to_string(pick(100000)) + "\n";
+        }
+        size_t start = out.size();
+        size_t kind = pick(10);
+        if (kind < 7 || declared == 0) {
+            simpleStatement();
+        } else if (kind < 9) {
+            out += "if ";
+            condition();
+            body();
+            if (pick(2) == 0) {
+                out += "\nelif ";
+                condition();
+                body();
+            }
+            if (pick(2) == 0) {
+                out += "\nelse";
+                body();
+            }
+        } else {
+            out += "while ";
+            condition();
+            body();
+        }
+        if (chance(shape.errorRate)) {
+            injectError(start);
+        }
+        out += '\n';
+    }
+
+public:
+    explicit Generator(const CorpusShape& shape) : shape(shape), rng(shape.seed), declared(0) {
+        static const char* stems[] = {"count", "total", "value", "index", "result", "user_name", "rate", "flag"};
+        for (size_t i = 0; i < std::max<size_t>(1, shape.identifiers); ++i) {
+            names.push_back(std::string(stems[i % 8]) + "_" + std::to_string(i));
+        }
+    }
+
+    std::string run() {
+        out.reserve(shape.statements * 40);
+        for (size_t i = 0; i < shape.statements; ++i) {
+            statement();
+        }
+        return std::move(out);
+    }
+};
+
+} // namespace
+
+std::string generateCorpus(const CorpusShape& shape) {
+    return Generator(shape).run();
+}
@@ -0,0 +1,25 @@
+#ifndef CORPUSGENERATOR_H
+#define CORPUSGENERATOR_H
+
+#include <cstdint>
+#include <string>
+
+// Shape of a synthetic program. The same shape and seed always produce the same text.
+struct CorpusShape {
+    uint32_t seed = 1;
+    size_t statements = 10000;   // Top-level statements (comment lines not counted)
+    size_t identifiers = 64;     // Distinct variable names
+    size_t expressionDepth = 3;  // Maximum nesting of binary operators and parentheses
+    double stringDensity = 0.2;  // Share of literals that are strings
+    double commentDensity = 0.1; // Chance of a comment line before a statement
+    double errorRate = 0.0;      // Chance a statement gets a lexical or syntax error
+    size_t blockStatements = 1;  // Statements in each if/elif/else/while body: 1 to this many
+};
+
+// Emits a program in the grammar the Parser supports: assignments, print/input, if/elif/else
+// and while with indented bodies, arithmetic and comparison expressions.
+// Variables are assigned before they are used, so an error-free shape parses cleanly. Note that
+// the Parser stops at the first syntax error, so errorRate mostly exercises the Lexer.
+std::string generateCorpus(const CorpusShape& shape);
+
+#endif
@@ -0,0 +1,108 @@
+// Parse time of expression-heavy input: deeply nested parentheses (up to 20000 levels, parsed
+// with a raised ErrorPolicy::maxNesting), long operator chains at every precedence level, and
+// plain one-literal assignments for the per-statement baseline. Each shape is lexed once and
+// Parser::parse is timed on the tokens (best of several runs), in nanoseconds per token.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Benchmarks/ExpressionBench.cpp Lexer.cpp LineIndex.cpp Parser.cpp TokenCursor.cpp TokenBuffer.cpp AST.cpp SymbolTable.cpp ErrorHandler.cpp ScanKernels.cpp Stats.cpp -o expressionBench
+// Run:
+//   ./expressionBench [lines]
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Lexer.h"
+#include "Parser.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* const OPERATORS[] = {" or ", " and ", " < ", " == ", " + ", " - ", " * ", " / ", " % "};
+const size_t OPERATOR_COUNT = 9;
+
+const std::string DECLARATIONS = "a = 1\nb = 2.5\nc = 3\n";
+
+// x = ((((a + 1) * 2) - b) ...), depth levels deep
+std::string nested(size_t lines, size_t depth) {
+    std::string line = "x = " + std::string(depth, '(') + "a";
+    for (size_t i = 0; i < depth; ++i) {
+        line += OPERATORS[4 + i % 5];
+        line += std::to_string(i % 10) + ")";
+    }
+    line += '\n';
+    std::string source = DECLARATIONS;
+    for (size_t i = 0; i < lines; ++i) {
+        source += line;
+    }
+    return source;
+}
+
+// x = a or b and c < 1 == ..., operators cycling through every precedence level
+std::string operatorChain(size_t lines, size_t operators) {
+    // As in Python, a bare 'not' can only follow 'and' / 'or', so it is in parentheses here
+    static const char* const operands[] = {"a", "b", "c", "7", "2.5", "-a", "(not b)"};
+    std::string source = DECLARATIONS;
+    for (size_t i = 0; i < lines; ++i) {
+        source += "x = a";
+        for (size_t k = 0; k < operators; ++k) {
+            source += OPERATORS[(i + k * 5) % OPERATOR_COUNT];
+            source += operands[(i + k) % 7];
+        }
+        source += '\n';
+    }
+    return source;
+}
+
+// x = 1, to compare the per-statement cost
+std::string literals(size_t lines) {
+    std::string source = DECLARATIONS;
+    for (size_t i = 0; i < lines; ++i) {
+        source += "x = " + std::to_string(i % 1000) + "\n";
+    }
+    return source;
+}
+
+void run(const std::string& name, const std::string& source) {
+    ErrorHandler lexErrors;
+    std::vector<Token> tokens = Lexer(source, lexErrors).tokenize();
+    LineIndex lines(source);
+    double best = 1e30;
+    size_t nodes = 0;
+    bool clean = true;
+    for (int rep = 0; rep < 5; ++rep) {
+        SymbolTable symbols;
+        ErrorPolicy policy;
+        policy.maxNesting = 1 << 20; // The deepest shape is far past the default limit
+        ErrorHandler errors(policy);
+        Parser parser(tokens, lines, symbols, errors);
+        auto start = Clock::now();
+        parser.parse();
+        best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        nodes = parser.getAst().size();
+        clean = !errors.hasErrors() && !lexErrors.hasErrors();
+    }
+    std::cout << std::left << std::setw(24) << name << std::setw(12) << tokens.size() << std::setw(12) << nodes
+              << std::setw(12) << std::fixed << std::setprecision(2) << best / 1e6 << std::setprecision(2)
+              << best / static_cast<double>(tokens.size()) << (clean ? "" : "  (errors)") << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t lines = argc > 1 ? std::stoul(argv[1]) : 20000;
+    std::cout << std::left << std::setw(24) << "Shape" << std::setw(12) << "Tokens" << std::setw(12) << "Nodes"
+              << std::setw(12) << "Time (ms)" << "ns/token" << std::endl;
+    std::cout << std::string(68, '-') << std::endl;
+    run("literals", literals(lines * 8));
+    run("nested parens x16", nested(lines, 16));
+    run("nested parens x256", nested(lines / 16, 256));
+    run("nested parens x20000", nested(std::max<size_t>(1, lines / 1000), 20000));
+    run("operator chain x8", operatorChain(lines * 2, 8));
+    run("operator chain x64", operatorChain(lines / 4, 64));
+    return 0;
+}
@@ -0,0 +1,140 @@
+// Latency of IncrementalAnalyzer edits against re-running Lexer + Parser on the whole file.
+// For growing synthetic sources, replays an editor-like edit script in the middle of the file
+// (typing into a literal, adding and removing lines, renaming a variable) and reports the time
+// per edit, alone and together with the getSymbolTable() an editor asks for after it. Every result
+// is checked against a from-scratch run (IncrementalAnalyzer::matchesFullAnalysis).
+// The time per edit only grows with the depth of the analyzer's segment tree, logarithmically in
+// the file size; the symbol table query costs about as much as the table it returns. Laying out
+// the whole source, which getSource() and the other queries do on demand, is left out.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Benchmarks/IncrementalBench.cpp IncrementalAnalyzer.cpp Lexer.cpp LineIndex.cpp TokenBuffer.cpp Parser.cpp TokenCursor.cpp AST.cpp SymbolTable.cpp ErrorHandler.cpp ScanKernels.cpp Stats.cpp -o incrementalBench
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "IncrementalAnalyzer.h"
+#include "Lexer.h"
+#include "Parser.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Edit {
+    size_t offset;
+    size_t length;
+    std::string replacement;
+};
+
+// A clean program: a few variables that later lines assign, print and compare
+std::string makeSource(size_t lines) {
+    const char* names[] = {"alpha", "beta", "gamma", "delta"};
+    std::mt19937 rng(42);
+    std::string code;
+    for (const char* name : names) {
+        code += std::string(name) + " = 1\n";
+    }
+    for (size_t i = 0; i < lines; ++i) {
+        std::string a = names[rng() % 4];
+        std::string b = names[rng() % 4];
+        switch (rng() % 4) {
+        case 0: code += a + " = " + b + " + " + std::to_string(i) + "\n"; break;
+        case 1: code += "print(" + a + " * " + b + ")\n"; break;
+        case 2: code += "if " + a + " > " + b + ": " + b + " = " + a + " - 1\n"; break;
+        default: code += "# step " + std::to_string(i) + "\n"; break;
+        }
+    }
+    return code;
+}
+
+// Edits a user might make around the middle of the file, each applied to the result of the last
+std::vector<Edit> makeEditScript(const std::string& code) {
+    size_t line = code.find('\n', code.size() / 2) + 1;
+    std::vector<Edit> edits;
+    // Type a new statement one character at a time, then a literal into it
+    std::string typed = "epsilon = alpha + 12345\n";
+    for (size_t i = 0; i < typed.size(); ++i) {
+        edits.push_back({line + i, 0, typed.substr(i, 1)});
+    }
+    // Change the literal, digit by digit
+    for (size_t i = 0; i < 5; ++i) {
+        edits.push_back({line + typed.size() - 6 + i, 1, std::to_string(9 - i)});
+    }
+    // Rename a use, add and remove a blank line, then delete the whole statement again
+    edits.push_back({line + 10, 5, "gamma"});
+    edits.push_back({line, 0, "\n"});
+    edits.push_back({line, 1, ""});
+    edits.push_back({line, typed.size(), ""});
+    return edits;
+}
+
+double fullAnalysisMicros(const std::string& code) {
+    auto start = Clock::now();
+    ErrorHandler errors;
+    Lexer lexer(code, errors);
+    std::vector<Token> tokens = lexer.tokenize();
+    SymbolTable table;
+    LineIndex lines(code);
+    Parser parser(tokens, lines, table, errors);
+    parser.parse();
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    const size_t lineCounts[] = {1000, 10000, 100000, 500000};
+
+    std::cout << std::left << std::setw(10) << "Lines"
+              << std::setw(16) << "Full us/edit"
+              << std::setw(16) << "Incr us/edit"
+              << std::setw(18) << "+symbols us/edit"
+              << std::setw(12) << "Speedup"
+              << "Relexed tokens/Reparsed per edit" << std::endl;
+    std::cout << std::string(98, '-') << std::endl;
+
+    for (size_t lines : lineCounts) {
+        std::string code = makeSource(lines);
+        std::vector<Edit> edits = makeEditScript(code);
+        IncrementalAnalyzer analyzer(code);
+
+        double incrementalMicros = 0;
+        double withSymbolsMicros = 0;
+        double fullMicros = 0;
+        size_t relexed = 0;
+        size_t reparsed = 0;
+        for (const Edit& edit : edits) {
+            auto start = Clock::now();
+            analyzer.applyEdit(edit.offset, edit.length, edit.replacement);
+            auto edited = Clock::now();
+            analyzer.getSymbolTable();
+            auto queried = Clock::now();
+            incrementalMicros += std::chrono::duration<double, std::micro>(edited - start).count();
+            withSymbolsMicros += std::chrono::duration<double, std::micro>(queried - start).count();
+            relexed += analyzer.getLastEditStats().tokensRelexed;
+            reparsed += analyzer.getLastEditStats().statementsReparsed;
+
+            fullMicros += fullAnalysisMicros(analyzer.getSource());
+            if (!analyzer.matchesFullAnalysis()) {
+                std::cerr << "Mismatch with a full run after an edit at offset " << edit.offset
+                          << " (" << lines << " lines)" << std::endl;
+                return 1;
+            }
+        }
+
+        double count = static_cast<double>(edits.size());
+        std::cout << std::left << std::setw(10) << lines
+                  << std::setw(16) << std::fixed << std::setprecision(1) << fullMicros / count
+                  << std::setw(16) << incrementalMicros / count
+                  << std::setw(18) << withSymbolsMicros / count
+                  << std::setw(12) << std::setprecision(0) << fullMicros / incrementalMicros
+                  << std::setprecision(1) << static_cast<double>(relexed) / count << " / "
+                  << static_cast<double>(reparsed) / count << std::endl;
+    }
+    return 0;
+}
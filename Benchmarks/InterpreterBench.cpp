@@ -0,0 +1,205 @@
+// Benchmark for the bytecode compiler and interpreter (see Compiler.h and Interpreter.h) on
+// loop-heavy scripts: the `while counter < 3` loop of TestScripts/validPython.py scaled up to
+// --iterations, plus variants with an if/else body, a float counter, an 'and' condition and a
+// longer expression per iteration. Reports compile time, run time (min / median over --reps)
+// and nanoseconds per loop iteration, and checks the final value of `counter` every run.
+//
+// Options (all optional):
+//   --iterations N --warmup N --reps N --format table|csv|json
+//
+// Build from the repository root (add -DINTERPRETER_NO_COMPUTED_GOTO to time switch dispatch):
+//   g++ -std=c++17 -O2 -I. Benchmarks/InterpreterBench.cpp Compiler.cpp Interpreter.cpp Bytecode.cpp Lexer.cpp LineIndex.cpp Parser.cpp TokenCursor.cpp TokenBuffer.cpp AST.cpp SymbolTable.cpp ErrorHandler.cpp ScanKernels.cpp Stats.cpp -o interpreterBench
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Compiler.h"
+#include "Interpreter.h"
+#include "Lexer.h"
+#include "Parser.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Scenario {
+    std::string name;
+    std::string source;
+    Value expected; // Final value of counter
+    size_t loopIterations;
+};
+
+std::vector<Scenario> makeScenarios(size_t n) {
+    std::string limit = std::to_string(n);
+    std::vector<Scenario> scenarios;
+    scenarios.push_back({"count",
+                         "counter = 0\n"
+                         "while counter < " + limit + ":\n"
+                         "    counter = counter + 1\n",
+                         Value::fromInt(static_cast<int64_t>(n)), n});
+
+    // Steps of 1 from multiples of 3, else 2: 0 -> 1 -> 3 -> 4 -> 6 ...
+    int64_t stepped = 0;
+    size_t steps = 0;
+    while (stepped < static_cast<int64_t>(n)) {
+        stepped += stepped % 3 == 0 ? 1 : 2;
+        steps++;
+    }
+    scenarios.push_back({"branch",
+                         "counter = 0\n"
+                         "while counter < " + limit + ":\n"
+                         "    if counter % 3 == 0:\n"
+                         "        counter = counter + 1\n"
+                         "    else:\n"
+                         "        counter = counter + 2\n",
+                         Value::fromInt(stepped), steps});
+
+    scenarios.push_back({"float",
+                         "counter = 0.0\n"
+                         "while counter < " + limit + ".0:\n"
+                         "    counter = counter + 0.5\n",
+                         Value::fromFloat(static_cast<double>(n)), 2 * n});
+
+    scenarios.push_back({"and",
+                         "counter = 0\n"
+                         "stop = 0 - 1\n"
+                         "while counter < " + limit + " and counter != stop:\n"
+                         "    counter = counter + 1\n",
+                         Value::fromInt(static_cast<int64_t>(n)), n});
+
+    scenarios.push_back({"expression",
+                         "counter = 0\n"
+                         "step = 1\n"
+                         "while counter < " + limit + ":\n"
+                         "    counter = counter + step * 2 - step + (counter - counter) * 7 % 5\n",
+                         Value::fromInt(static_cast<int64_t>(n)), n});
+    return scenarios;
+}
+
+bool sameValue(const Value& a, const Value& b) {
+    if (a.type != b.type) {
+        return false;
+    }
+    return a.type == ValueType::FLOAT ? a.f == b.f : a.i == b.i;
+}
+
+struct Result {
+    std::string name;
+    size_t iterations;
+    size_t instructions;
+    double compileMicros;
+    std::vector<double> runMillis; // Sorted
+    bool correct;
+
+    double median() const { return runMillis[runMillis.size() / 2]; }
+    double nanosPerIteration() const { return median() * 1e6 / static_cast<double>(iterations); }
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t iterations = 1000000;
+    size_t warmup = 1;
+    size_t reps = 5;
+    std::string format = "table";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--iterations") iterations = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--warmup") warmup = std::stoul(value);
+        else if (arg == "--reps") reps = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--format") format = value;
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Result> results;
+    for (const Scenario& scenario : makeScenarios(iterations)) {
+        ErrorHandler errors;
+        SymbolTable symbols;
+        LineIndex lines(scenario.source);
+        Lexer lexer(scenario.source, errors);
+        std::vector<Token> tokens = lexer.tokenize();
+        Parser parser(tokens, lines, symbols, errors);
+        parser.parse();
+        if (errors.hasErrors()) {
+            std::cerr << scenario.name << ": the script does not parse" << std::endl;
+            errors.printErrors(lines);
+            return 1;
+        }
+
+        BytecodeProgram program;
+        Compiler compiler(parser.getAst(), symbols);
+        auto start = Clock::now();
+        bool compiled = compiler.compile(program);
+        double compileMicros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        if (!compiled) {
+            std::cerr << scenario.name << ": " << compiler.getError().message << std::endl;
+            return 1;
+        }
+
+        std::ostringstream output;
+        std::istringstream input;
+        Interpreter interpreter(program, input, output);
+        Result result{scenario.name, scenario.loopIterations, program.code.size(), compileMicros, {}, true};
+        size_t counter = static_cast<size_t>(symbols.search("counter"));
+        for (size_t i = 0; i < warmup + reps; ++i) {
+            start = Clock::now();
+            bool ok = interpreter.run();
+            double millis = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            result.correct = result.correct && ok && sameValue(interpreter.variable(counter), scenario.expected);
+            if (i >= warmup) {
+                result.runMillis.push_back(millis);
+            }
+        }
+        std::sort(result.runMillis.begin(), result.runMillis.end());
+        results.push_back(result);
+    }
+
+    bool allCorrect = std::all_of(results.begin(), results.end(), [](const Result& r) { return r.correct; });
+#ifdef INTERPRETER_NO_COMPUTED_GOTO
+    const char* dispatch = "switch";
+#else
+    const char* dispatch = "computed-goto";
+#endif
+    if (format == "json") {
+        std::cout << std::fixed << std::setprecision(3) << "{\n  \"dispatch\": \"" << dispatch
+                  << "\",\n  \"iterations\": " << iterations << ",\n  \"reps\": " << reps << ",\n  \"scenarios\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            std::cout << "    {\"name\": \"" << r.name << "\", \"loopIterations\": " << r.iterations
+                      << ", \"instructions\": " << r.instructions << ", \"compileUs\": " << r.compileMicros
+                      << ", \"minMs\": " << r.runMillis.front() << ", \"medianMs\": " << r.median()
+                      << ", \"nsPerIteration\": " << r.nanosPerIteration() << ", \"correct\": "
+                      << (r.correct ? "true" : "false") << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "  ]\n}" << std::endl;
+    } else if (format == "csv") {
+        std::cout << "scenario,loop_iterations,instructions,compile_us,min_ms,median_ms,ns_per_iteration,correct" << std::endl;
+        for (const Result& r : results) {
+            std::cout << std::fixed << std::setprecision(3) << r.name << "," << r.iterations << "," << r.instructions << ","
+                      << r.compileMicros << "," << r.runMillis.front() << "," << r.median() << ","
+                      << r.nanosPerIteration() << "," << (r.correct ? 1 : 0) << std::endl;
+        }
+    } else {
+        std::cout << "Dispatch: " << dispatch << ", " << iterations << " iterations, " << reps << " reps" << std::endl;
+        std::cout << std::left << std::setw(12) << "Scenario" << std::setw(12) << "Loop iters" << std::setw(10)
+                  << "Instrs" << std::setw(12) << "Compile us" << std::setw(12) << "Min ms" << std::setw(12)
+                  << "Median ms" << std::setw(10) << "ns/iter" << "Check" << std::endl;
+        std::cout << std::string(86, '-') << std::endl;
+        for (const Result& r : results) {
+            std::cout << std::fixed << std::setprecision(2) << std::setw(12) << r.name << std::setw(12) << r.iterations
+                      << std::setw(10) << r.instructions << std::setw(12) << r.compileMicros << std::setw(12)
+                      << r.runMillis.front() << std::setw(12) << r.median() << std::setw(10) << r.nanosPerIteration()
+                      << (r.correct ? "OK" : "WRONG") << std::endl;
+        }
+    }
+    return allCorrect ? 0 : 1;
+}
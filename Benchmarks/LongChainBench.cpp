@@ -0,0 +1,128 @@
+// Regression check and timing for operator chains as long as a line allows: a sum of [terms] ones
+// and an 'if' over an 'or' of [orTerms] variables that are not constant, so the condition is
+// compiled into a chain of jumps. A chain needs no parentheses, so ErrorPolicy::maxNesting does not
+// limit it, and every pass after the parser has to handle it without recursing once per operator.
+// The program is generated here rather than kept in TestScripts. Each pass runs once, timed: type
+// inference, compiling and running the tree, then compiling and running it again after Optimizer.
+// The printed output must be the sum and the loop count; exits with 1 if a pass fails or it is not.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Benchmarks/LongChainBench.cpp Compiler.cpp Interpreter.cpp Bytecode.cpp Optimizer.cpp TypeInference.cpp Lexer.cpp LineIndex.cpp Parser.cpp TokenCursor.cpp TokenBuffer.cpp AST.cpp SymbolTable.cpp ErrorHandler.cpp ScanKernels.cpp Stats.cpp -o longChainBench
+// Run:
+//   ./longChainBench [terms] [orTerms]
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Compiler.h"
+#include "Interpreter.h"
+#include "Lexer.h"
+#include "Optimizer.h"
+#include "Parser.h"
+#include "TypeInference.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string makeSource(size_t terms, size_t orTerms) {
+    std::string source = "total = 1";
+    for (size_t i = 1; i < terms; ++i) {
+        source += "+1";
+    }
+    source += "\nprint(total)\n"
+              "x = False\n"
+              "count = 0\n"
+              "while count < 2:\n"
+              "    x = total < count\n"
+              "    count = count + 1\n"
+              "if x";
+    for (size_t i = 1; i < orTerms; ++i) {
+        source += " or x";
+    }
+    source += ":\n"
+              "    print(x)\n"
+              "print(count)\n";
+    return source;
+}
+
+// Runs a pass and prints its time; false if it failed
+bool timed(const std::string& pass, const std::function<bool()>& run) {
+    auto start = Clock::now();
+    bool ok = run();
+    double millis = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << std::left << std::setw(24) << pass << std::setw(12) << std::fixed << std::setprecision(2) << millis
+              << (ok ? "ok" : "FAILED") << std::endl;
+    return ok;
+}
+
+// Compiles and runs the tree; its output must be the expected one
+bool compileAndRun(const Ast& ast, const SymbolTable& symbols, const std::string& expected) {
+    BytecodeProgram program;
+    Compiler compiler(ast, symbols);
+    if (!compiler.compile(program)) {
+        std::cerr << "Compile error: " << compiler.getError().message << std::endl;
+        return false;
+    }
+    std::istringstream input;
+    std::ostringstream output;
+    Interpreter interpreter(program, input, output);
+    if (!interpreter.run()) {
+        std::cerr << "Runtime error: " << interpreter.getError().message << std::endl;
+        return false;
+    }
+    if (output.str() != expected) {
+        std::cerr << "Printed '" << output.str() << "', expected '" << expected << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t terms = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t orTerms = argc > 2 ? std::stoul(argv[2]) : 50000;
+    if (terms == 0 || orTerms == 0) {
+        std::cerr << "Both chains need at least one term" << std::endl;
+        return 1;
+    }
+    std::string source = makeSource(terms, orTerms);
+    std::string expected = std::to_string(terms) + "\n2\n";
+    std::cout << "Sum of " << terms << " terms, 'or' of " << orTerms << " terms (" << source.size() << " bytes)"
+              << std::endl;
+    std::cout << std::left << std::setw(24) << "Pass" << std::setw(12) << "ms" << "Check" << std::endl;
+    std::cout << std::string(42, '-') << std::endl;
+
+    ErrorHandler errors;
+    SymbolTable symbols;
+    LineIndex lines(source);
+    Lexer lexer(source, errors);
+    std::vector<Token> tokens = lexer.tokenize();
+    Parser parser(tokens, lines, symbols, errors);
+    Ast& ast = parser.getAst();
+    bool ok = timed("parse", [&] {
+        parser.parse();
+        return !errors.hasErrors();
+    });
+    if (!ok) {
+        errors.printErrors(lines);
+        return 1;
+    }
+    ok = timed("infer types", [&] {
+        TypeInference(ast, symbols).run();
+        return true;
+    }) && ok;
+    ok = timed("compile and run", [&] { return compileAndRun(ast, symbols, expected); }) && ok;
+    ok = timed("optimize", [&] {
+        Optimizer(ast, symbols).optimize();
+        return true;
+    }) && ok;
+    ok = timed("compile and run again", [&] { return compileAndRun(ast, symbols, expected); }) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+// Speedup of ParallelLexer over the sequential Lexer::tokenize() as the thread count grows.
+// Lexes the given file (or a generated ~64 MB script) and checks that every thread count
+// produces exactly the same tokens and errors as the sequential lexer.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -pthread -I. Benchmarks/ParallelLexBench.cpp ParallelLexer.cpp Lexer.cpp LineIndex.cpp TokenBuffer.cpp ScanKernels.cpp ThreadPool.cpp ErrorHandler.cpp SourceFile.cpp Stats.cpp -o parallelLexBench
+// Run:
+//   ./parallelLexBench [file.py]
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Lexer.h"
+#include "ParallelLexer.h"
+#include "SourceFile.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::string generateSource(size_t targetBytes) {
+    const std::string block =
+        "# generated block\n"
+        "value_a = 10\n"
+        "value_b = value_a * 2 + 3.5\n"
+        "message = \"Hello!! Are you reading this message?\"\n"
+        "if value_b > 20:\n"
+        "    print(\"big\")\n"
+        "while value_a < 3:\n"
+        "    value_a = value_a + 1\n"
+        "broken = 'unterminated\n"
+        "$odd = 1\n";
+    std::string source;
+    source.reserve(targetBytes + block.size());
+    while (source.size() < targetBytes) {
+        source += block;
+    }
+    return source;
+}
+
+bool sameTokens(const std::vector<Token>& a, const std::vector<Token>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const Token& x, const Token& y) {
+        return x.type == y.type && x.lexeme.data() == y.lexeme.data() && x.lexeme.size() == y.lexeme.size() &&
+               x.offset == y.offset;
+    });
+}
+
+bool sameErrors(const ErrorHandler& a, const ErrorHandler& b) {
+    return a.getErrors() == b.getErrors();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SourceFile file;
+    std::string generated;
+    std::string_view source;
+    if (argc > 1) {
+        if (!file.open(argv[1])) {
+            std::cerr << "Error: Failed to open file " << argv[1] << std::endl;
+            return 1;
+        }
+        source = file.contents();
+    } else {
+        generated = generateSource(64 << 20);
+        source = generated;
+    }
+
+    ErrorHandler sequentialErrors;
+    auto start = Clock::now();
+    std::vector<Token> expected = Lexer(source, sequentialErrors).tokenize();
+    double sequentialSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << "Input: " << source.size() << " bytes, " << expected.size() << " tokens" << std::endl;
+    std::cout << std::left << std::setw(10) << "Threads" << std::setw(12) << "Time (ms)" << "Speedup" << std::endl;
+    std::cout << std::string(30, '-') << std::endl;
+    std::cout << std::setw(10) << "seq" << std::setw(12) << std::fixed << std::setprecision(1)
+              << sequentialSeconds * 1000 << "1.00x" << std::endl;
+
+    size_t maxThreads = std::max(8u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ErrorHandler errors;
+        start = Clock::now();
+        std::vector<Token> tokens = ParallelLexer(source, errors, threads).tokenize();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (!sameTokens(tokens, expected) || !sameErrors(errors, sequentialErrors)) {
+            std::cerr << "Mismatch against the sequential lexer with " << threads << " threads" << std::endl;
+            return 1;
+        }
+        std::cout << std::setw(10) << threads << std::setw(12) << std::setprecision(1) << seconds * 1000
+                  << std::setprecision(2) << sequentialSeconds / seconds << "x" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Speedup of ParallelParser over the sequential Parser::parse() as the thread count grows.
+// Lexes the given file (or a generated ~1M statement script with multi-statement blocks, see
+// CorpusGenerator.h) once, then parses the tokens and checks that every thread count produces
+// exactly the same tree, symbol table and errors as the sequential parser.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -pthread -I. -IBenchmarks Benchmarks/ParallelParseBench.cpp Benchmarks/CorpusGenerator.cpp ParallelParser.cpp Parser.cpp TokenCursor.cpp TokenBuffer.cpp AST.cpp SymbolTable.cpp Lexer.cpp LineIndex.cpp ScanKernels.cpp ThreadPool.cpp ErrorHandler.cpp SourceFile.cpp Stats.cpp -o parallelParseBench
+// Run:
+//   ./parallelParseBench [file.py]
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CorpusGenerator.h"
+#include "Lexer.h"
+#include "ParallelParser.h"
+#include "Parser.h"
+#include "SourceFile.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool sameAst(const Ast& a, const Ast& b) {
+    if (a.size() != b.size() || a.getRoot() != b.getRoot()) {
+        return false;
+    }
+    for (NodeId id = 0; id < a.size(); ++id) {
+        const AstNode& x = a.node(id);
+        const AstNode& y = b.node(id);
+        if (x.kind != y.kind || x.op != y.op || x.flags != y.flags || x.firstChild != y.firstChild ||
+            x.lastChild != y.lastChild || x.nextSibling != y.nextSibling || x.line != y.line || x.text != y.text) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sameSymbols(const SymbolTable& a, const SymbolTable& b) {
+    const std::vector<STEntry>& x = a.getEntries();
+    const std::vector<STEntry>& y = b.getEntries();
+    return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin(), [](const STEntry& p, const STEntry& q) {
+        return p.name == q.name && p.dataType == q.dataType && p.size == q.size &&
+               p.lineOfDeclaration == q.lineOfDeclaration && p.linesOfUsage == q.linesOfUsage;
+    });
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    SourceFile file;
+    std::string generated;
+    std::string_view source;
+    if (argc > 1) {
+        if (!file.open(argv[1])) {
+            std::cerr << "Error: Failed to open file " << argv[1] << std::endl;
+            return 1;
+        }
+        source = file.contents();
+    } else {
+        CorpusShape shape;
+        shape.statements = 1000000;
+        shape.blockStatements = 4;
+        generated = generateCorpus(shape);
+        source = generated;
+    }
+
+    ErrorHandler lexErrors;
+    std::vector<Token> tokens = Lexer(source, lexErrors).tokenize();
+    LineIndex lines(source);
+    if (lexErrors.hasErrors()) {
+        std::cerr << "The input has lexical errors, which stop the analysis before parsing" << std::endl;
+        return 1;
+    }
+
+    SymbolTable expectedSymbols;
+    ErrorHandler expectedErrors;
+    auto start = Clock::now();
+    Parser sequential(tokens, lines, expectedSymbols, expectedErrors);
+    sequential.parse();
+    double sequentialSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << "Input: " << source.size() << " bytes, " << tokens.size() << " tokens, "
+              << sequential.getAst().size() << " nodes" << std::endl;
+    std::cout << std::left << std::setw(10) << "Threads" << std::setw(12) << "Time (ms)" << "Speedup" << std::endl;
+    std::cout << std::string(30, '-') << std::endl;
+    std::cout << std::setw(10) << "seq" << std::setw(12) << std::fixed << std::setprecision(1)
+              << sequentialSeconds * 1000 << "1.00x" << std::endl;
+
+    size_t maxThreads = std::max(8u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        SymbolTable symbols;
+        ErrorHandler errors;
+        start = Clock::now();
+        ParallelParser parser(tokens, lines, symbols, errors, threads);
+        parser.parse();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (!sameAst(parser.getAst(), sequential.getAst()) || !sameSymbols(symbols, expectedSymbols) ||
+            errors.getErrors() != expectedErrors.getErrors()) {
+            std::cerr << "Mismatch against the sequential parser with " << threads << " threads" << std::endl;
+            return 1;
+        }
+        std::cout << std::setw(10) << threads << std::setw(12) << std::setprecision(1) << seconds * 1000
+                  << std::setprecision(2) << sequentialSeconds / seconds << "x" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+// Heap allocations made by Parser::parse, counted by replacing the global operator new.
+// Each shape is lexed once, then parsed from a std::vector<Token> and from a TokenBuffer with the
+// Ast reserved up front, so what is left is the symbol table and the parser's stacks growing.
+// Every shape has a twin that wraps each expression in parentheses: the twins build the same
+// nodes and symbols from several times as many tokens, so any allocation made while reading a
+// token (match(), expect(), consume() and the cursor) shows up as a difference between them
+// (their first line grows the parser's stacks to the same depth).
+// Exits with 1 if there is one.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. -IBenchmarks Benchmarks/ParserAllocBench.cpp Benchmarks/CorpusGenerator.cpp Lexer.cpp LineIndex.cpp Parser.cpp TokenCursor.cpp TokenBuffer.cpp AST.cpp SymbolTable.cpp ErrorHandler.cpp ScanKernels.cpp Stats.cpp -o parserAllocBench
+// Run:
+//   ./parserAllocBench [lines]
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "CorpusGenerator.h"
+#include "Lexer.h"
+#include "Parser.h"
+
+namespace {
+
+size_t allocations = 0;
+bool counting = false;
+
+} // namespace
+
+void* operator new(size_t size) {
+    if (counting) {
+        allocations++;
+    }
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+// The last line grows the parser's expression stack deeper than any shape needs, so the
+// parentheses of the twins do not grow it further
+const std::string DECLARATIONS = "a = 1\nb = 2.5\nc = 3\nd = " + std::string(32, '(') + "a + b * 2 < c or not a" +
+                                 std::string(32, ')') + "\n";
+
+// x = <expression>, with the expression wrapped in depth parentheses
+std::string assignments(size_t lines, const std::string& expression, size_t depth) {
+    std::string line = "x = " + std::string(depth, '(') + expression + std::string(depth, ')') + "\n";
+    std::string source = DECLARATIONS;
+    for (size_t i = 0; i < lines; ++i) {
+        source += line;
+    }
+    return source;
+}
+
+// while / if blocks around the same statements
+std::string blocks(size_t lines, size_t depth) {
+    std::string wrap = std::string(depth, '(');
+    std::string unwrap = std::string(depth, ')');
+    std::string source = DECLARATIONS;
+    for (size_t i = 0; i < lines / 4; ++i) {
+        source += "while " + wrap + "a < 10" + unwrap + ":\n";
+        source += "    if " + wrap + "not b" + unwrap + ":\n";
+        source += "        a = " + wrap + "a + 1" + unwrap + "\n";
+        source += "    else:\n        print(" + wrap + "c * 2" + unwrap + ")\n";
+    }
+    return source;
+}
+
+struct Count {
+    size_t tokens = 0;
+    size_t nodes = 0;
+    size_t vectorAllocations = 0;
+    size_t bufferAllocations = 0;
+    bool clean = true;
+};
+
+// Allocations of one parse of the tokens, with the Ast reserved so it does not grow
+template <typename Tokens>
+size_t countParse(const Tokens& tokens, const LineIndex& lines, size_t nodes, bool& clean) {
+    SymbolTable symbols;
+    ErrorHandler errors;
+    Parser parser(tokens, lines, symbols, errors);
+    parser.getAst().reserve(nodes);
+    allocations = 0;
+    counting = true;
+    parser.parse();
+    counting = false;
+    clean = clean && !errors.hasErrors();
+    return allocations;
+}
+
+Count measure(const std::string& source) {
+    Count count;
+    ErrorHandler lexErrors;
+    Lexer lexer(source, lexErrors);
+    std::vector<Token> tokens = lexer.tokenize();
+    TokenBuffer buffer;
+    Lexer(source, lexErrors).tokenize(buffer);
+    LineIndex lines(source);
+    lines.line(source.size()); // Builds the line table before counting
+
+    SymbolTable symbols;
+    ErrorHandler errors;
+    Parser sizing(tokens, lines, symbols, errors);
+    sizing.parse();
+    count.tokens = tokens.size();
+    count.nodes = sizing.getAst().size();
+    count.clean = !lexErrors.hasErrors();
+    count.vectorAllocations = countParse(tokens, lines, count.nodes, count.clean);
+    count.bufferAllocations = countParse(buffer, lines, count.nodes, count.clean);
+    return count;
+}
+
+void printRow(const std::string& name, const Count& count) {
+    std::cout << std::left << std::setw(26) << name << std::setw(10) << count.tokens << std::setw(10) << count.nodes
+              << std::setw(16) << count.vectorAllocations << std::setw(16) << count.bufferAllocations
+              << std::fixed << std::setprecision(4)
+              << static_cast<double>(count.vectorAllocations) / static_cast<double>(count.tokens)
+              << (count.clean ? "" : "  (errors)") << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t lines = argc > 1 ? std::stoul(argv[1]) : 20000;
+    const size_t depth = 8;
+
+    struct Shape {
+        std::string name;
+        std::string plain;
+        std::string wrapped;
+    };
+    std::vector<Shape> shapes = {
+        {"literal", assignments(lines, "7", 0), assignments(lines, "7", depth)},
+        {"operators", assignments(lines, "a + b * 2 < c or not a", 0),
+         assignments(lines, "a + b * 2 < c or not a", depth)},
+        {"blocks", blocks(lines, 0), blocks(lines, depth)},
+    };
+
+    std::cout << std::left << std::setw(26) << "Shape" << std::setw(10) << "Tokens" << std::setw(10) << "Nodes"
+              << std::setw(16) << "Allocs (vector)" << std::setw(16) << "Allocs (buffer)" << "Allocs/token" << std::endl;
+    std::cout << std::string(88, '-') << std::endl;
+
+    bool perToken = false;
+    for (const Shape& shape : shapes) {
+        Count plain = measure(shape.plain);
+        Count wrapped = measure(shape.wrapped);
+        printRow(shape.name, plain);
+        printRow(shape.name + " in " + std::to_string(depth) + " parens", wrapped);
+        perToken = perToken || wrapped.vectorAllocations != plain.vectorAllocations ||
+                   wrapped.bufferAllocations != plain.bufferAllocations;
+    }
+
+    CorpusShape corpusShape;
+    corpusShape.statements = lines;
+    corpusShape.blockStatements = 4;
+    printRow("generated corpus", measure(generateCorpus(corpusShape)));
+
+    std::cout << std::endl;
+    if (perToken) {
+        std::cout << "The parenthesized shapes allocate more: reading tokens allocates" << std::endl;
+        return 1;
+    }
+    std::cout << "Same allocations with and without the parentheses: no allocation per token read" << std::endl;
+    return 0;
+}
@@ -0,0 +1,236 @@
+// Regression benchmark for the analysis phases on a seeded synthetic corpus (see CorpusGenerator.h).
+// Times Lexer::tokenize, Parser::parse (on pre-lexed tokens), TypeInference::run (on the parsed
+// tree) and the SymbolTable operations the parser performs (replayed on their own) separately. Lexing and parsing are timed both with a
+// std::vector<Token> and with a struct-of-arrays TokenBuffer, whose memory per token is reported. Each phase gets warmup runs, then timed
+// repetitions summarized as min / median / p99 / mean, in a table, CSV or JSON.
+//
+// Options (all optional):
+//   --statements N --identifiers N --depth N --strings F --comments F --errors F --block N --seed N
+//   --warmup N --reps N --format table|csv|json --emit FILE (also writes the corpus to FILE)
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. -IBenchmarks Benchmarks/PhaseBench.cpp Benchmarks/CorpusGenerator.cpp Lexer.cpp LineIndex.cpp Parser.cpp TokenCursor.cpp TokenBuffer.cpp AST.cpp SymbolTable.cpp TypeInference.cpp ErrorHandler.cpp ScanKernels.cpp Stats.cpp -o phaseBench
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CorpusGenerator.h"
+#include "AnalysisCache.h" // ANALYZER_VERSION only
+#include "Lexer.h"
+#include "Parser.h"
+#include "ScanKernels.h"
+#include "TypeInference.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct PhaseResult {
+    std::string name;
+    std::vector<double> micros; // Sorted
+    size_t items;               // Tokens (or symbol operations) handled per run
+
+    double percentile(double p) const {
+        size_t rank = static_cast<size_t>(p * static_cast<double>(micros.size()) + 0.999999);
+        return micros[std::min(micros.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+    double mean() const {
+        double sum = 0;
+        for (double m : micros) {
+            sum += m;
+        }
+        return sum / static_cast<double>(micros.size());
+    }
+};
+
+PhaseResult measure(const std::string& name, size_t warmup, size_t reps, size_t items, const std::function<void()>& run) {
+    for (size_t i = 0; i < warmup; ++i) {
+        run();
+    }
+    PhaseResult result{name, {}, items};
+    for (size_t i = 0; i < reps; ++i) {
+        auto start = Clock::now();
+        run();
+        result.micros.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    std::sort(result.micros.begin(), result.micros.end());
+    return result;
+}
+
+// Keeps the optimizer from dropping work whose result is otherwise unused
+volatile size_t sink;
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    CorpusShape shape;
+    size_t warmup = 3;
+    size_t reps = 20;
+    std::string format = "table";
+    std::string emitPath;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--statements") shape.statements = std::stoul(value);
+        else if (arg == "--identifiers") shape.identifiers = std::stoul(value);
+        else if (arg == "--depth") shape.expressionDepth = std::stoul(value);
+        else if (arg == "--strings") shape.stringDensity = std::stod(value);
+        else if (arg == "--comments") shape.commentDensity = std::stod(value);
+        else if (arg == "--errors") shape.errorRate = std::stod(value);
+        else if (arg == "--block") shape.blockStatements = std::stoul(value);
+        else if (arg == "--seed") shape.seed = static_cast<uint32_t>(std::stoul(value));
+        else if (arg == "--warmup") warmup = std::stoul(value);
+        else if (arg == "--reps") reps = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--format") format = value;
+        else if (arg == "--emit") emitPath = value;
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::string corpus = generateCorpus(shape);
+    if (!emitPath.empty()) {
+        std::ofstream(emitPath, std::ios::binary) << corpus;
+    }
+
+    // Lex once up front so the parser and symbol table phases get the same input every run
+    ErrorHandler lexErrors;
+    Lexer lexer(corpus, lexErrors);
+    std::vector<Token> tokens = lexer.tokenize();
+    ErrorHandler bufferErrors;
+    Lexer bufferLexer(corpus, bufferErrors);
+    TokenBuffer buffer;
+    bufferLexer.tokenize(buffer);
+
+    std::vector<PhaseResult> results;
+    results.push_back(measure("lex", warmup, reps, tokens.size(), [&] {
+        ErrorHandler errors;
+        Lexer timedLexer(corpus, errors);
+        sink = timedLexer.tokenize().size();
+    }));
+    results.push_back(measure("lex-soa", warmup, reps, tokens.size(), [&] {
+        ErrorHandler errors;
+        Lexer timedLexer(corpus, errors);
+        TokenBuffer timedBuffer;
+        timedLexer.tokenize(timedBuffer);
+        sink = timedBuffer.size();
+    }));
+    // The parser's line numbers come from a LineIndex, built on its first lookup inside the timed run
+    results.push_back(measure("lines", warmup, reps, corpus.size(), [&] {
+        LineIndex index(corpus);
+        sink = index.lineCount();
+    }));
+    results.push_back(measure("parse", warmup, reps, tokens.size(), [&] {
+        ErrorHandler errors;
+        SymbolTable table;
+        LineIndex lines(corpus);
+        Parser parser(tokens, lines, table, errors);
+        parser.parse();
+        sink = parser.getAst().size();
+    }));
+    results.push_back(measure("parse-soa", warmup, reps, tokens.size(), [&] {
+        ErrorHandler errors;
+        SymbolTable table;
+        LineIndex lines(corpus);
+        Parser parser(buffer, lines, table, errors);
+        parser.parse();
+        sink = parser.getAst().size();
+    }));
+
+    // Inference rewrites the same types every run, so one parse serves them all
+    ErrorHandler parseErrors;
+    SymbolTable parsedTable;
+    LineIndex parsedLines(corpus);
+    Parser parsed(tokens, parsedLines, parsedTable, parseErrors);
+    parsed.parse();
+    results.push_back(measure("infer", warmup, reps, parsed.getAst().size(), [&] {
+        TypeInference inference(parsed.getAst(), parsedTable);
+        inference.run();
+        sink = inference.evaluationCount();
+    }));
+
+    // Memory per token of both layouts, by capacity
+    double vectorBytesPerToken = static_cast<double>(tokens.capacity() * sizeof(Token)) / static_cast<double>(tokens.size());
+    double bufferBytesPerToken = static_cast<double>(buffer.memoryBytes()) / static_cast<double>(buffer.size());
+
+    // The parser's symbol table traffic: an assignment target is looked up and then declared or
+    // used, every other identifier is looked up and used
+    size_t identifierCount = 0;
+    LineIndex lines(corpus);
+    for (const Token& token : tokens) {
+        identifierCount += token.type == TokenType::IDENTIFIER;
+    }
+    results.push_back(measure("symbols", warmup, reps, identifierCount, [&] {
+        SymbolTable table;
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            if (tokens[i].type != TokenType::IDENTIFIER) {
+                continue;
+            }
+            SymbolTable::SymTabPos pos = table.search(tokens[i].lexeme);
+            if (pos != SymbolTable::SymTabPos::NOT_FOUND) {
+                table.addLineOfUsage(pos, lines.line(tokens[i].offset));
+            } else if (i + 1 < tokens.size() && tokens[i + 1].type == TokenType::ASSIGN) {
+                table.insert(tokens[i].lexeme, "dynamic", 0, 0, lines.line(tokens[i].offset));
+            }
+        }
+        sink = table.getEntries().size();
+    }));
+
+    if (format == "json") {
+        std::cout << "{\n  \"analyzerVersion\": " << ANALYZER_VERSION << ",\n  \"isa\": \""
+                  << ScanKernels::isaName(ScanKernels::activeIsa()) << "\",\n  \"corpus\": {\"seed\": " << shape.seed
+                  << ", \"statements\": " << shape.statements << ", \"identifiers\": " << shape.identifiers
+                  << ", \"depth\": " << shape.expressionDepth << ", \"strings\": " << shape.stringDensity
+                  << ", \"comments\": " << shape.commentDensity << ", \"errors\": " << shape.errorRate
+                  << ", \"block\": " << shape.blockStatements
+                  << ", \"bytes\": " << corpus.size() << ", \"tokens\": " << tokens.size()
+                  << ", \"lexicalErrors\": " << lexErrors.getErrors().size() << "},\n  \"bytesPerToken\": {\"vector\": "
+                  << vectorBytesPerToken << ", \"tokenBuffer\": " << bufferBytesPerToken << "},\n  \"warmup\": " << warmup
+                  << ",\n  \"reps\": " << reps << ",\n  \"phases\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const PhaseResult& r = results[i];
+            std::cout << std::fixed << std::setprecision(2) << "    {\"name\": \"" << r.name << "\", \"items\": " << r.items
+                      << ", \"minUs\": " << r.micros.front() << ", \"medianUs\": " << r.percentile(0.5)
+                      << ", \"p99Us\": " << r.percentile(0.99) << ", \"meanUs\": " << r.mean()
+                      << ", \"itemsPerSec\": " << static_cast<double>(r.items) / r.percentile(0.5) * 1e6 << "}"
+                      << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "  ]\n}" << std::endl;
+    } else if (format == "csv") {
+        std::cout << "phase,items,min_us,median_us,p99_us,mean_us,items_per_sec" << std::endl;
+        for (const PhaseResult& r : results) {
+            std::cout << std::fixed << std::setprecision(2) << r.name << "," << r.items << "," << r.micros.front() << ","
+                      << r.percentile(0.5) << "," << r.percentile(0.99) << "," << r.mean() << ","
+                      << static_cast<double>(r.items) / r.percentile(0.5) * 1e6 << std::endl;
+        }
+    } else {
+        std::cout << "Corpus: " << corpus.size() << " bytes, " << tokens.size() << " tokens, "
+                  << identifierCount << " identifiers, " << lexErrors.getErrors().size() << " lexical errors (seed "
+                  << shape.seed << ")" << std::endl;
+        std::cout << std::fixed << std::setprecision(1) << "Bytes per token: " << vectorBytesPerToken
+                  << " as std::vector<Token>, " << bufferBytesPerToken << " as TokenBuffer" << std::endl;
+        std::cout << std::left << std::setw(10) << "Phase"
+                  << std::setw(12) << "Min us"
+                  << std::setw(12) << "Median us"
+                  << std::setw(12) << "p99 us"
+                  << std::setw(12) << "Mean us"
+                  << "M items/s" << std::endl;
+        std::cout << std::string(68, '-') << std::endl;
+        for (const PhaseResult& r : results) {
+            std::cout << std::left << std::setw(10) << r.name << std::fixed << std::setprecision(1)
+                      << std::setw(12) << r.micros.front()
+                      << std::setw(12) << r.percentile(0.5)
+                      << std::setw(12) << r.percentile(0.99)
+                      << std::setw(12) << r.mean()
+                      << std::setprecision(2) << static_cast<double>(r.items) / r.percentile(0.5) << std::endl;
+        }
+    }
+    return 0;
+}
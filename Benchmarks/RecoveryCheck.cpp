@@ -0,0 +1,100 @@
+// Regression check for --all-errors (ErrorPolicy::recover) on TestScripts/recoveryPython.py, a
+// copy of errorPython.py without its lexical errors. Its first statement leaves a '(' open, which
+// the lexer gives up on at the next statement (see Lexer.h), so every statement's first error is
+// still reported: the six below, at the same lines and columns, whether the parser reads a
+// std::vector<Token>, a TokenBuffer or tokens pulled from the lexer as it goes.
+// Prints each error found; exits with 1 if any list differs from the expected one.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Benchmarks/RecoveryCheck.cpp Lexer.cpp LineIndex.cpp Parser.cpp TokenCursor.cpp TokenBuffer.cpp AST.cpp SymbolTable.cpp ErrorHandler.cpp ScanKernels.cpp Stats.cpp -o recoveryCheck
+// Run:
+//   ./recoveryCheck [TestScripts/recoveryPython.py]
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Lexer.h"
+#include "Parser.h"
+#include "TokenBuffer.h"
+
+namespace {
+
+struct Expected {
+    size_t line;
+    size_t column;
+    ErrorCode code;
+};
+
+const Expected EXPECTED[] = {
+    {5, 44, ErrorCode::EXPECTED_TOKEN},        // print( never closed
+    {8, 10, ErrorCode::EXPECTED_TOKEN},        // if without ':'
+    {15, 4, ErrorCode::EXPECTED_EXPRESSION},   // if = 5
+    {18, 9, ErrorCode::EXPECTED_EXPRESSION},   // x = 10 +
+    {21, 6, ErrorCode::EXPECTED_EXPRESSION},   // while:
+    {26, 1, ErrorCode::UNDECLARED_IDENTIFIER}, // another_var == 3
+};
+
+// Prints the errors of one run and compares them with EXPECTED
+bool matches(const std::string& mode, const ErrorHandler& errors, const LineIndex& lines) {
+    const std::vector<Error>& found = errors.getErrors();
+    bool ok = found.size() == sizeof(EXPECTED) / sizeof(EXPECTED[0]);
+    std::cout << mode << ": " << found.size() << " errors" << std::endl;
+    for (size_t i = 0; i < found.size(); ++i) {
+        size_t line = lines.line(found[i].offset);
+        size_t column = lines.column(found[i].offset);
+        bool same = i < sizeof(EXPECTED) / sizeof(EXPECTED[0]) && EXPECTED[i].line == line &&
+                    EXPECTED[i].column == column && EXPECTED[i].code == found[i].code;
+        ok = ok && same;
+        std::cout << "  " << (same ? "ok      " : "WRONG   ") << "L" << line << ":" << column << " "
+                  << found[i].message() << std::endl;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "TestScripts/recoveryPython.py";
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    std::string source = contents.str();
+
+    ErrorPolicy policy;
+    policy.recover = true;
+    LineIndex lines(source);
+    bool ok = true;
+    {
+        ErrorHandler errors(policy);
+        SymbolTable symbols;
+        Lexer lexer(source, errors);
+        std::vector<Token> tokens = lexer.tokenize();
+        Parser(tokens, lines, symbols, errors).parse();
+        ok = matches("vector", errors, lines) && ok;
+    }
+    {
+        ErrorHandler errors(policy);
+        SymbolTable symbols;
+        TokenBuffer tokens;
+        Lexer lexer(source, errors);
+        lexer.tokenize(tokens);
+        Parser(tokens, lines, symbols, errors).parse();
+        ok = matches("TokenBuffer", errors, lines) && ok;
+    }
+    {
+        ErrorHandler errors(policy);
+        SymbolTable symbols;
+        Lexer lexer(source, errors);
+        Parser(lexer, lines, symbols, errors).parse();
+        ok = matches("streaming", errors, lines) && ok;
+    }
+    std::cout << (ok ? "Recovery OK" : "Recovery FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+// Bytes-per-cycle benchmark for the Lexer's scan kernels (ScanKernels.h).
+// Each kernel is run over a buffer made of runs of matching bytes separated by a byte that
+// stops the run, for several run lengths, once per instruction set available on this machine.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Benchmarks/ScanKernelBench.cpp ScanKernels.cpp -o scanKernelBench
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ScanKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t readCycles() { return __rdtsc(); } // TSC ticks, which track nominal-frequency cycles
+#else
+static uint64_t readCycles() {
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+#endif
+
+namespace {
+
+const size_t bufferSize = 16 << 20;
+const int repetitions = 5;
+
+// Fills a buffer with runs of `fill` bytes of the given length, each followed by `stop`
+std::string makeBuffer(const std::string& fill, char stop, size_t runLength) {
+    std::string buffer;
+    buffer.reserve(bufferSize);
+    size_t next = 0;
+    while (buffer.size() < bufferSize) {
+        for (size_t i = 0; i < runLength && buffer.size() < bufferSize; ++i) {
+            buffer += fill[next++ % fill.size()];
+        }
+        buffer += stop;
+    }
+    return buffer;
+}
+
+struct Workload {
+    const char* name;
+    std::string fill;
+    char stop;
+};
+
+// Walks the whole buffer one run at a time, the way the Lexer calls the kernels
+template <typename Scan>
+size_t walk(const std::string& buffer, Scan scan) {
+    const char* p = buffer.data();
+    const char* end = p + buffer.size();
+    size_t runs = 0;
+    while (p < end) {
+        p = scan(p, end) + 1; // step over the stop byte
+        ++runs;
+    }
+    return runs;
+}
+
+size_t runKernel(const ScanKernels::KernelSet& kernels, int workload, const std::string& buffer) {
+    switch (workload) {
+        case 0: return walk(buffer, kernels.skipBlanks);
+        case 1: return walk(buffer, kernels.findLineEnd);
+        case 2: return walk(buffer, kernels.skipIdentifier);
+        case 3: return walk(buffer, kernels.skipDigits);
+        default:
+            return walk(buffer, [&](const char* p, const char* end) { return kernels.findStringEnd(p, end, '"'); });
+    }
+}
+
+} // namespace
+
+int main() {
+    const Workload workloads[] = {
+        {"blanks", " \t ", 'x'},
+        {"comment", "comment text # more ", '\n'},
+        {"identifier", "declared_Value_42", '='},
+        {"digits", "0123456789", '.'},
+        {"string", "Hello, are you reading this? ", '"'},
+    };
+    const size_t runLengths[] = {4, 16, 64, 1024};
+    const ScanKernels::Isa isas[] = {ScanKernels::Isa::Scalar, ScanKernels::Isa::SSE2, ScanKernels::Isa::AVX2};
+
+    std::cout << "Active instruction set: " << ScanKernels::isaName(ScanKernels::activeIsa()) << std::endl;
+    std::cout << std::left << std::setw(12) << "Kernel" << std::setw(10) << "Run len"
+              << std::setw(10) << "ISA" << std::setw(14) << "Bytes/cycle" << "Speedup" << std::endl;
+    std::cout << std::string(56, '-') << std::endl;
+
+    for (int w = 0; w < 5; ++w) {
+        for (size_t runLength : runLengths) {
+            std::string buffer = makeBuffer(workloads[w].fill, workloads[w].stop, runLength);
+            double scalarRate = 0;
+            size_t expectedRuns = 0;
+            for (ScanKernels::Isa isa : isas) {
+                if (isa != ScanKernels::Isa::Scalar && &ScanKernels::kernelsFor(isa) == &ScanKernels::kernelsFor(ScanKernels::Isa::Scalar)) {
+                    continue; // Not available on this machine
+                }
+                const ScanKernels::KernelSet& kernels = ScanKernels::kernelsFor(isa);
+                uint64_t best = UINT64_MAX;
+                size_t runs = 0;
+                for (int r = 0; r < repetitions; ++r) {
+                    uint64_t start = readCycles();
+                    runs = runKernel(kernels, w, buffer);
+                    uint64_t cycles = readCycles() - start;
+                    if (cycles < best) best = cycles;
+                }
+                if (isa == ScanKernels::Isa::Scalar) {
+                    expectedRuns = runs;
+                } else if (runs != expectedRuns) {
+                    std::cerr << "Mismatch: " << ScanKernels::isaName(isa) << " " << workloads[w].name
+                              << " found " << runs << " runs, scalar found " << expectedRuns << std::endl;
+                    return 1;
+                }
+                double rate = static_cast<double>(buffer.size()) / static_cast<double>(best);
+                if (isa == ScanKernels::Isa::Scalar) scalarRate = rate;
+                std::cout << std::left << std::setw(12) << workloads[w].name << std::setw(10) << runLength
+                          << std::setw(10) << ScanKernels::isaName(isa)
+                          << std::setw(14) << std::fixed << std::setprecision(3) << rate
+                          << std::setprecision(2) << rate / scalarRate << "x" << std::endl;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,252 @@
+// Load generator for the analysis server (parser --serve SOCKET, see AnalysisServer.h).
+// Opens --clients connections, each sending --requests inline-source requests with up to
+// --pipeline of them outstanding at once, and reports throughput and request latency
+// percentiles (send to complete response). The sources are --files seeded synthetic programs
+// (see CorpusGenerator.h), and the first answer for each is checked against an in-process run.
+//
+// Options (all optional except --socket):
+//   --socket PATH --clients N --requests N --pipeline N --files N --statements N --errors F
+//   --seed N --all-errors 0|1 --format table|json
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -pthread -I. -IBenchmarks Benchmarks/ServerLoadBench.cpp Benchmarks/CorpusGenerator.cpp ServerProtocol.cpp Lexer.cpp LineIndex.cpp TokenBuffer.cpp Parser.cpp TokenCursor.cpp AST.cpp SymbolTable.cpp TypeInference.cpp ErrorHandler.cpp ScanKernels.cpp Stats.cpp -o serverLoadBench
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "CorpusGenerator.h"
+#include "ServerProtocol.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "TypeInference.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Expected {
+    size_t tokens;
+    std::vector<STEntry> symbols;
+    std::vector<ServerProtocol::ResponseError> errors;
+};
+
+// What the server should answer, computed the same way it does
+Expected analyzeLocally(const std::string& source, ErrorPolicy policy) {
+    Expected expected;
+    ErrorHandler errorHandler(policy);
+    SymbolTable symbolTable;
+    LineIndex lines(source);
+    Lexer lexer(source, errorHandler);
+    std::vector<Token> tokens = lexer.tokenize();
+    if (!errorHandler.hasErrors()) {
+        Parser parser(tokens, lines, symbolTable, errorHandler);
+        parser.parse();
+        TypeInference(parser.getAst(), symbolTable).run();
+    }
+    expected.tokens = tokens.size();
+    expected.symbols = symbolTable.getEntries();
+    for (const Error& error : errorHandler.getErrors()) {
+        // Offsets are not sent, only the line and column they resolve to
+        Error sent = error;
+        sent.offset = 0;
+        expected.errors.push_back({sent, static_cast<uint32_t>(lines.line(error.offset)),
+                                   static_cast<uint32_t>(lines.column(error.offset))});
+    }
+    return expected;
+}
+
+bool matches(const ServerProtocol::Response& response, const Expected& expected) {
+    if (response.status != ServerProtocol::ResponseStatus::OK || response.tokenCount != expected.tokens ||
+        response.errors.size() != expected.errors.size() || response.symbols.size() != expected.symbols.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < expected.errors.size(); ++i) {
+        const ServerProtocol::ResponseError& a = response.errors[i];
+        const ServerProtocol::ResponseError& b = expected.errors[i];
+        if (!(a.error == b.error) || a.line != b.line || a.column != b.column) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < expected.symbols.size(); ++i) {
+        const STEntry& a = response.symbols[i];
+        const STEntry& b = expected.symbols[i];
+        if (a.name != b.name || a.dataType != b.dataType || a.lineOfDeclaration != b.lineOfDeclaration ||
+            a.linesOfUsage != b.linesOfUsage) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct ClientResult {
+    std::vector<double> micros;
+    size_t bytesSent = 0;
+    size_t failures = 0;
+    std::string error;
+};
+
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(p * static_cast<double>(sorted.size()) + 0.999999);
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string socketPath;
+    size_t clients = 8;
+    size_t requests = 500;
+    size_t pipeline = 1;
+    size_t fileCount = 16;
+    bool allErrors = false;
+    std::string format = "table";
+    CorpusShape shape;
+    shape.statements = 200;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--socket") socketPath = value;
+        else if (arg == "--clients") clients = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--requests") requests = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--pipeline") pipeline = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--files") fileCount = std::max<size_t>(1, std::stoul(value));
+        else if (arg == "--statements") shape.statements = std::stoul(value);
+        else if (arg == "--errors") shape.errorRate = std::stod(value);
+        else if (arg == "--seed") shape.seed = static_cast<uint32_t>(std::stoul(value));
+        else if (arg == "--all-errors") allErrors = value != "0";
+        else if (arg == "--format") format = value;
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (socketPath.empty()) {
+        std::cerr << "Usage: serverLoadBench --socket PATH [options]" << std::endl;
+        return 1;
+    }
+
+    // The sources and the answers expected for them; each client cycles through the sources
+    std::vector<std::string> sources;
+    std::vector<Expected> expected;
+    ErrorPolicy policy;
+    policy.recover = allErrors;
+    for (size_t i = 0; i < fileCount; ++i) {
+        CorpusShape fileShape = shape;
+        fileShape.seed = shape.seed + static_cast<uint32_t>(i);
+        sources.push_back(generateCorpus(fileShape));
+        expected.push_back(analyzeLocally(sources.back(), policy));
+    }
+    std::vector<std::atomic<bool>> verified(fileCount);
+    std::atomic<size_t> mismatches(0);
+
+    std::vector<ClientResult> results(clients);
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (size_t c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            ClientResult& result = results[c];
+            int fd = ServerProtocol::connectTo(socketPath);
+            if (fd < 0) {
+                result.error = "cannot connect to " + socketPath;
+                return;
+            }
+            std::vector<Clock::time_point> sentAt(requests);
+            std::string frame;
+            std::string payload;
+            ServerProtocol::Response response;
+            size_t sent = 0;
+            size_t received = 0;
+            auto send = [&] {
+                ServerProtocol::Request request;
+                request.requestId = static_cast<uint32_t>(sent);
+                request.kind = ServerProtocol::RequestKind::SOURCE;
+                request.flags = allErrors ? ServerProtocol::RECOVER : 0;
+                request.text = sources[(c + sent) % fileCount];
+                frame.clear();
+                ServerProtocol::encodeRequest(request, frame);
+                sentAt[sent] = Clock::now();
+                result.bytesSent += frame.size();
+                sent++;
+                return ServerProtocol::writeAll(fd, frame);
+            };
+            while (received < requests) {
+                while (sent < requests && sent - received < pipeline) {
+                    if (!send()) {
+                        result.error = "send failed";
+                        ::close(fd);
+                        return;
+                    }
+                }
+                if (!ServerProtocol::readFrame(fd, payload) || !ServerProtocol::decodeResponse(payload, response) ||
+                    response.requestId >= requests) {
+                    result.error = "bad or missing response";
+                    break;
+                }
+                auto now = Clock::now();
+                result.micros.push_back(std::chrono::duration<double, std::micro>(now - sentAt[response.requestId]).count());
+                received++;
+
+                size_t file = (c + response.requestId) % fileCount;
+                if (response.status != ServerProtocol::ResponseStatus::OK) {
+                    result.failures++;
+                } else if (!verified[file].exchange(true) && !matches(response, expected[file])) {
+                    mismatches++;
+                }
+            }
+            ::close(fd);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> micros;
+    size_t bytesSent = 0;
+    size_t failures = 0;
+    for (const ClientResult& result : results) {
+        if (!result.error.empty()) {
+            std::cerr << "Client error: " << result.error << std::endl;
+            return 1;
+        }
+        micros.insert(micros.end(), result.micros.begin(), result.micros.end());
+        bytesSent += result.bytesSent;
+        failures += result.failures;
+    }
+    std::sort(micros.begin(), micros.end());
+    double perSecond = static_cast<double>(micros.size()) / seconds;
+    double megabytesPerSecond = static_cast<double>(bytesSent) / seconds / 1e6;
+
+    if (format == "json") {
+        std::cout << std::fixed << std::setprecision(2) << "{\"clients\": " << clients << ", \"requests\": " << micros.size()
+                  << ", \"pipeline\": " << pipeline << ", \"files\": " << fileCount << ", \"statements\": "
+                  << shape.statements << ", \"seconds\": " << seconds << ", \"requestsPerSec\": " << perSecond
+                  << ", \"mbPerSec\": " << megabytesPerSecond << ", \"p50Us\": " << percentile(micros, 0.5)
+                  << ", \"p90Us\": " << percentile(micros, 0.9) << ", \"p99Us\": " << percentile(micros, 0.99)
+                  << ", \"p999Us\": " << percentile(micros, 0.999) << ", \"maxUs\": " << micros.back()
+                  << ", \"failures\": " << failures << ", \"mismatches\": " << mismatches.load() << "}" << std::endl;
+    } else {
+        std::cout << clients << " clients x " << requests << " requests (pipeline " << pipeline << "), " << fileCount
+                  << " sources of " << shape.statements << " statements" << std::endl;
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << std::left << std::setw(20) << "Requests/s" << perSecond << std::endl;
+        std::cout << std::setw(20) << "MB/s sent" << megabytesPerSecond << std::endl;
+        std::cout << std::setw(20) << "p50 latency (us)" << percentile(micros, 0.5) << std::endl;
+        std::cout << std::setw(20) << "p90 latency (us)" << percentile(micros, 0.9) << std::endl;
+        std::cout << std::setw(20) << "p99 latency (us)" << percentile(micros, 0.99) << std::endl;
+        std::cout << std::setw(20) << "p99.9 latency (us)" << percentile(micros, 0.999) << std::endl;
+        std::cout << std::setw(20) << "Max latency (us)" << micros.back() << std::endl;
+        std::cout << std::setw(20) << "Failed requests" << failures << std::endl;
+        std::cout << std::setw(20) << "Verification" << (mismatches.load() == 0 ? "OK" : "MISMATCH") << std::endl;
+    }
+    return mismatches.load() == 0 && failures == 0 ? 0 : 1;
+}
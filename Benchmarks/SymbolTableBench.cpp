@@ -0,0 +1,105 @@
+// Scaling benchmark for SymbolTable lookups.
+// For a growing number of distinct identifiers, fills a SymbolTable and then performs the
+// lookup pattern the Parser produces (search + addLineOfUsage per identifier use), comparing
+// the hash index against the linear scan SymbolTable::search used to do.
+//
+// Build from the repository root:
+//   g++ -std=c++17 -O2 -I. Benchmarks/SymbolTableBench.cpp SymbolTable.cpp Stats.cpp -o symbolTableBench
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "SymbolTable.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// The previous SymbolTable::search: compare against every entry in declaration order
+SymbolTable::SymTabPos linearSearch(const std::vector<STEntry>& entries, std::string_view name) {
+    for (auto i = 0u; i < entries.size(); ++i) {
+        if (name == entries.at(i).name) {
+            return static_cast<SymbolTable::SymTabPos>(i);
+        }
+    }
+    return SymbolTable::SymTabPos::NOT_FOUND;
+}
+
+std::vector<std::string> makeNames(size_t count) {
+    std::vector<std::string> names;
+    names.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        names.push_back("generated_var_" + std::to_string(i));
+    }
+    return names;
+}
+
+} // namespace
+
+int main() {
+    const size_t symbolCounts[] = {100, 1000, 5000, 10000, 20000, 50000};
+    const size_t lookups = 200000;
+
+    std::cout << std::left << std::setw(10) << "Symbols"
+              << std::setw(18) << "Linear ns/lookup"
+              << std::setw(18) << "Hashed ns/lookup"
+              << "Speedup" << std::endl;
+    std::cout << std::string(54, '-') << std::endl;
+
+    for (size_t count : symbolCounts) {
+        std::vector<std::string> names = makeNames(count);
+        SymbolTable table;
+        for (size_t i = 0; i < count; ++i) {
+            table.insert(names[i], "dynamic", 0, 0, i + 1);
+        }
+
+        // Same random sequence of uses for both, with 10% undeclared names to exercise misses
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<size_t> pick(0, count + count / 10);
+        std::vector<std::string> queries;
+        queries.reserve(lookups);
+        for (size_t i = 0; i < lookups; ++i) {
+            size_t n = pick(rng);
+            queries.push_back(n < count ? names[n] : "undeclared_" + std::to_string(n));
+        }
+
+        // The linear scan gets slow quickly, so it only runs a sample of the queries
+        size_t linearLookups = count >= 10000 ? lookups / 20 : lookups;
+        size_t linearFound = 0;
+        auto start = Clock::now();
+        for (size_t i = 0; i < linearLookups; ++i) {
+            linearFound += linearSearch(table.getEntries(), queries[i]) != SymbolTable::SymTabPos::NOT_FOUND;
+        }
+        double linearNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(linearLookups);
+
+        start = Clock::now();
+        for (size_t i = 0; i < lookups; ++i) {
+            SymbolTable::SymTabPos pos = table.search(queries[i]);
+            if (pos != SymbolTable::SymTabPos::NOT_FOUND) {
+                table.addLineOfUsage(pos, i);
+            }
+        }
+        double hashedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(lookups);
+
+        // Both must agree on the shared prefix of queries
+        size_t hashedPrefix = 0;
+        for (size_t i = 0; i < linearLookups; ++i) {
+            hashedPrefix += table.search(queries[i]) != SymbolTable::SymTabPos::NOT_FOUND;
+        }
+        if (hashedPrefix != linearFound) {
+            std::cerr << "Mismatch at " << count << " symbols: linear found " << linearFound
+                      << ", hashed found " << hashedPrefix << std::endl;
+            return 1;
+        }
+
+        std::cout << std::left << std::setw(10) << count
+                  << std::setw(18) << std::fixed << std::setprecision(1) << linearNs
+                  << std::setw(18) << hashedNs
+                  << std::setprecision(0) << linearNs / hashedNs << "x" << std::endl;
+    }
+    return 0;
+}
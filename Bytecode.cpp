@@ -0,0 +1,359 @@
+// implementation of Bytecode.h
+
+#include "Bytecode.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+
+namespace {
+
+// Python's repr of a float: the shortest digits that read back as the same value, in fixed
+// notation for exponents -4..15 and scientific notation otherwise
+void appendFloat(std::string& out, double f) {
+    if (std::isnan(f)) {
+        out += "nan";
+        return;
+    }
+    if (std::isinf(f)) {
+        out += f < 0 ? "-inf" : "inf";
+        return;
+    }
+    char buffer[32];
+    for (int precision = 1; precision <= 17; ++precision) {
+        std::snprintf(buffer, sizeof(buffer), "%.*e", precision - 1, f);
+        if (std::strtod(buffer, nullptr) == f) {
+            break;
+        }
+    }
+
+    // buffer is [-]d[.ddd]e(+|-)xx
+    const char* p = buffer;
+    if (*p == '-') {
+        out += '-';
+        ++p;
+    }
+    std::string digits;
+    for (; *p != 'e'; ++p) {
+        if (*p != '.') {
+            digits += *p;
+        }
+    }
+    int exponent = std::atoi(p + 1);
+
+    if (exponent >= -4 && exponent < 16) {
+        if (exponent < 0) {
+            out += "0.";
+            out.append(static_cast<size_t>(-exponent - 1), '0');
+            out += digits;
+        } else {
+            size_t whole = static_cast<size_t>(exponent) + 1;
+            if (digits.size() <= whole) {
+                out += digits;
+                out.append(whole - digits.size(), '0');
+                out += ".0";
+            } else {
+                out.append(digits, 0, whole);
+                out += '.';
+                out.append(digits, whole, std::string::npos);
+            }
+        }
+    } else {
+        out += digits[0];
+        if (digits.size() > 1) {
+            out += '.';
+            out.append(digits, 1, std::string::npos);
+        }
+        std::snprintf(buffer, sizeof(buffer), "e%c%02d", exponent < 0 ? '-' : '+', std::abs(exponent));
+        out += buffer;
+    }
+}
+
+// bool and int both keep their value in Value::i
+bool isIntLike(const Value& v) { return v.type == ValueType::BOOL || v.type == ValueType::INT; }
+bool isNumber(const Value& v) { return isIntLike(v) || v.type == ValueType::FLOAT; }
+double asDouble(const Value& v) { return v.type == ValueType::FLOAT ? v.f : static_cast<double>(v.i); }
+
+// Python's %: a non-zero result takes the sign of the divisor
+int64_t pythonMod(int64_t x, int64_t y) {
+    if (y == -1) {
+        return 0; // INT64_MIN % -1 would trap
+    }
+    int64_t r = x % y;
+    return r != 0 && (r < 0) != (y < 0) ? r + y : r;
+}
+
+double pythonMod(double x, double y) {
+    double r = std::fmod(x, y);
+    if (r == 0) {
+        return std::copysign(0.0, y);
+    }
+    return (r < 0) != (y < 0) ? r + y : r;
+}
+
+const char* operatorSymbol(Opcode op) {
+    switch (op) {
+        case Opcode::ADD: return "+";
+        case Opcode::SUB: return "-";
+        case Opcode::MUL: return "*";
+        case Opcode::DIV: return "/";
+        case Opcode::MOD: return "%";
+        case Opcode::EQ: return "==";
+        case Opcode::NE: return "!=";
+        case Opcode::LT: return "<";
+        case Opcode::LE: return "<=";
+        case Opcode::GT: return ">";
+        case Opcode::GE: return ">=";
+        case Opcode::NEG: return "-";
+        case Opcode::POS: return "+";
+        default: return "?";
+    }
+}
+
+template <typename T>
+bool compareWith(Opcode comparison, const T& x, const T& y) {
+    switch (comparison) {
+        case Opcode::EQ: return x == y;
+        case Opcode::NE: return x != y;
+        case Opcode::LT: return x < y;
+        case Opcode::LE: return x <= y;
+        case Opcode::GT: return x > y;
+        default: return x >= y;
+    }
+}
+
+} // namespace
+
+const char* valueTypeName(ValueType type) {
+    switch (type) {
+        case ValueType::BOOL: return "bool";
+        case ValueType::INT: return "int";
+        case ValueType::FLOAT: return "float";
+        case ValueType::STR: return "str";
+        default: return "unbound";
+    }
+}
+
+void appendValue(std::string& out, const Value& value) {
+    switch (value.type) {
+        case ValueType::BOOL:
+            out += value.i ? "True" : "False";
+            break;
+        case ValueType::INT:
+            out += std::to_string(value.i);
+            break;
+        case ValueType::FLOAT:
+            appendFloat(out, value.f);
+            break;
+        case ValueType::STR:
+            out.append(value.s, value.length);
+            break;
+        default:
+            out += "<unbound>";
+            break;
+    }
+}
+
+const char* opcodeName(Opcode op) {
+    switch (op) {
+#define BYTECODE_NAME(name) case Opcode::name: return #name;
+        BYTECODE_OPCODES(BYTECODE_NAME)
+#undef BYTECODE_NAME
+    }
+    return "UNKNOWN";
+}
+
+bool parseLiteral(TokenType type, std::string_view text, std::deque<std::string>& strings, Value& value) {
+    switch (type) {
+        case TokenType::INTEGER_LITERAL: {
+            int64_t number = 0;
+            auto result = std::from_chars(text.data(), text.data() + text.size(), number);
+            value = Value::fromInt(number);
+            return result.ec == std::errc();
+        }
+        case TokenType::FLOAT_LITERAL:
+            value = Value::fromFloat(std::strtod(std::string(text).c_str(), nullptr));
+            return true;
+        case TokenType::STRING_LITERAL:
+            strings.emplace_back(text);
+            value = Value::fromString(strings.back());
+            return true;
+        default:
+            value = Value::fromBool(text == "True");
+            return true;
+    }
+}
+
+bool isTruthy(const Value& value) {
+    switch (value.type) {
+        case ValueType::FLOAT: return value.f != 0;
+        case ValueType::STR: return value.length != 0;
+        default: return value.i != 0;
+    }
+}
+
+bool applyUnary(Opcode op, const Value& x, Value& result, std::string& error) {
+    if (op == Opcode::NOT) {
+        result = Value::fromBool(!isTruthy(x));
+    } else if (isIntLike(x)) {
+        result = Value::fromInt(op == Opcode::NEG ? wrapSub(0, x.i) : x.i);
+    } else if (x.type == ValueType::FLOAT) {
+        result = Value::fromFloat(op == Opcode::NEG ? -x.f : x.f);
+    } else {
+        error = std::string("TypeError: bad operand type for unary ") + operatorSymbol(op) + ": '" +
+                valueTypeName(x.type) + "'";
+        return false;
+    }
+    return true;
+}
+
+bool applyBinary(Opcode op, const Value& x, const Value& y, std::deque<std::string>& strings, Value& result,
+                 std::string& error) {
+    if (isNumber(x) && isNumber(y)) {
+        bool ints = isIntLike(x) && isIntLike(y);
+        switch (op) {
+            case Opcode::ADD:
+                result = ints ? Value::fromInt(wrapAdd(x.i, y.i)) : Value::fromFloat(asDouble(x) + asDouble(y));
+                return true;
+            case Opcode::SUB:
+                result = ints ? Value::fromInt(wrapSub(x.i, y.i)) : Value::fromFloat(asDouble(x) - asDouble(y));
+                return true;
+            case Opcode::MUL:
+                result = ints ? Value::fromInt(wrapMul(x.i, y.i)) : Value::fromFloat(asDouble(x) * asDouble(y));
+                return true;
+            case Opcode::DIV:
+                if (asDouble(y) == 0) {
+                    error = "ZeroDivisionError: division by zero";
+                    return false;
+                }
+                result = Value::fromFloat(asDouble(x) / asDouble(y));
+                return true;
+            default: // MOD
+                if (asDouble(y) == 0) {
+                    error = ints ? "ZeroDivisionError: integer modulo by zero" : "ZeroDivisionError: float modulo";
+                    return false;
+                }
+                result = ints ? Value::fromInt(pythonMod(x.i, y.i)) : Value::fromFloat(pythonMod(asDouble(x), asDouble(y)));
+                return true;
+        }
+    }
+    if (op == Opcode::ADD && x.type == ValueType::STR && y.type == ValueType::STR) {
+        std::string text(x.s, x.length);
+        text.append(y.s, y.length);
+        strings.push_back(std::move(text));
+        result = Value::fromString(strings.back());
+        return true;
+    }
+    if (op == Opcode::MUL && ((x.type == ValueType::STR && isIntLike(y)) || (isIntLike(x) && y.type == ValueType::STR))) {
+        const Value& text = x.type == ValueType::STR ? x : y;
+        int64_t count = x.type == ValueType::STR ? y.i : x.i;
+        if (count > 0 && static_cast<uint64_t>(count) * text.length > UINT32_MAX) {
+            error = "MemoryError: string too long";
+            return false;
+        }
+        std::string repeated;
+        for (int64_t i = 0; i < count; ++i) {
+            repeated.append(text.s, text.length);
+        }
+        strings.push_back(std::move(repeated));
+        result = Value::fromString(strings.back());
+        return true;
+    }
+    if (op == Opcode::MOD && x.type == ValueType::STR) {
+        error = "TypeError: string formatting with % is not supported";
+        return false;
+    }
+    error = std::string("TypeError: unsupported operand type(s) for ") + operatorSymbol(op) + ": '" +
+            valueTypeName(x.type) + "' and '" + valueTypeName(y.type) + "'";
+    return false;
+}
+
+bool applyComparison(Opcode op, const Value& x, const Value& y, bool& result, std::string& error) {
+    if (isIntLike(x) && isIntLike(y)) {
+        result = compareWith(op, x.i, y.i);
+    } else if (isNumber(x) && isNumber(y)) {
+        result = compareWith(op, asDouble(x), asDouble(y));
+    } else if (x.type == ValueType::STR && y.type == ValueType::STR) {
+        result = compareWith(op, std::string_view(x.s, x.length), std::string_view(y.s, y.length));
+    } else if (op == Opcode::EQ || op == Opcode::NE) {
+        result = op == Opcode::NE; // Values of unrelated types are never equal
+    } else {
+        error = std::string("TypeError: '") + operatorSymbol(op) + "' not supported between instances of '" +
+                valueTypeName(x.type) + "' and '" + valueTypeName(y.type) + "'";
+        return false;
+    }
+    return true;
+}
+
+void BytecodeProgram::clear() {
+    code.clear();
+    lines.clear();
+    variableNames.clear();
+    constants.clear();
+    constantStrings.clear();
+    registerCount = 0;
+}
+
+void BytecodeProgram::disassemble(std::ostream& out) const {
+    // Variables by name, constants by value, temporaries as t0, t1, ...
+    auto describe = [&](uint32_t reg) {
+        if (reg < firstConstant()) {
+            return variableNames[reg];
+        }
+        if (reg < firstTemporary()) {
+            const Value& constant = constants[reg - firstConstant()];
+            std::string text;
+            appendValue(text, constant);
+            return constant.type == ValueType::STR ? "\"" + text + "\"" : text;
+        }
+        return "t" + std::to_string(reg - firstTemporary());
+    };
+
+    out << "\n--- Bytecode ---" << std::endl;
+    out << std::left << std::setw(20) << "Instructions" << code.size() << " (" << code.size() * sizeof(Instruction)
+        << " bytes)" << std::endl;
+    out << std::setw(20) << "Registers" << registerCount << " (" << variableNames.size() << " variables, "
+        << constants.size() << " constants, " << registerCount - firstTemporary() << " temporaries)" << std::endl;
+    out << std::string(60, '-') << std::endl;
+    for (size_t pc = 0; pc < code.size(); ++pc) {
+        const Instruction& in = code[pc];
+        out << std::right << std::setw(6) << pc << "  " << std::left << std::setw(16) << opcodeName(in.op());
+        switch (in.op()) {
+            case Opcode::MOVE:
+            case Opcode::NEG:
+            case Opcode::POS:
+            case Opcode::NOT:
+                out << describe(in.a()) << ", " << describe(in.b);
+                break;
+            case Opcode::INPUT:
+                out << describe(in.a());
+                if (in.b != NO_REGISTER) {
+                    out << ", " << describe(in.b);
+                }
+                break;
+            case Opcode::PRINT:
+                out << describe(in.b);
+                break;
+            case Opcode::JUMP:
+                out << "-> " << in.a();
+                break;
+            case Opcode::JUMP_IF_TRUE:
+            case Opcode::JUMP_IF_FALSE:
+                out << describe(in.b) << " -> " << in.a();
+                break;
+            case Opcode::HALT:
+                break;
+            default:
+                if (in.op() >= Opcode::JUMP_IF_EQ) {
+                    out << describe(in.b) << ", " << describe(in.c) << " -> " << in.a();
+                } else {
+                    out << describe(in.a()) << ", " << describe(in.b) << ", " << describe(in.c);
+                }
+                break;
+        }
+        out << "  [line " << lines[pc] << "]" << std::endl;
+    }
+    out << std::string(60, '-') << std::endl;
+}
@@ -0,0 +1,144 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Token.h"
+
+// Register bytecode for running validated programs (see Compiler.h and Interpreter.h).
+// Every operand is a register of one flat frame laid out as
+//   [variables][constants][temporaries]
+// where variable i is the identifier at SymbolTable position i, and the constants are loaded
+// once before the run, so instructions never need a separate load step.
+
+enum class ValueType : uint8_t { UNBOUND, BOOL, INT, FLOAT, STR };
+
+// A run-time value. BOOL keeps 0 or 1 in i, so it takes part in arithmetic like an int does in
+// Python. STR points at characters owned by the program (literals) or the interpreter.
+struct Value {
+    ValueType type;
+    uint32_t length; // STR only
+    union {
+        int64_t i;
+        double f;
+        const char* s;
+    };
+
+    Value() : type(ValueType::UNBOUND), length(0), i(0) {}
+
+    static Value fromBool(bool b) { Value v; v.type = ValueType::BOOL; v.i = b; return v; }
+    static Value fromInt(int64_t i) { Value v; v.type = ValueType::INT; v.i = i; return v; }
+    static Value fromFloat(double f) { Value v; v.type = ValueType::FLOAT; v.f = f; return v; }
+    static Value fromString(const std::string& s) {
+        Value v;
+        v.type = ValueType::STR;
+        v.length = static_cast<uint32_t>(s.size());
+        v.s = s.data();
+        return v;
+    }
+};
+
+// Python's name for the type, as used in error messages
+const char* valueTypeName(ValueType type);
+// Appends the value as print() shows it (floats as Python's shortest repr, e.g. 20.5, 1e+16).
+// For literals this is also source text that parseLiteral reads back as the same value.
+void appendValue(std::string& out, const Value& value);
+
+// Ints are 64-bit and wrap around instead of growing like Python's
+inline int64_t wrapAdd(int64_t x, int64_t y) { return static_cast<int64_t>(static_cast<uint64_t>(x) + static_cast<uint64_t>(y)); }
+inline int64_t wrapSub(int64_t x, int64_t y) { return static_cast<int64_t>(static_cast<uint64_t>(x) - static_cast<uint64_t>(y)); }
+inline int64_t wrapMul(int64_t x, int64_t y) { return static_cast<int64_t>(static_cast<uint64_t>(x) * static_cast<uint64_t>(y)); }
+
+// Opcodes, listed once so the enum, the names and the interpreter's jump table stay in step.
+// a is the destination register (or the jump target), b and c the source registers.
+#define BYTECODE_OPCODES(X)                                                              \
+    X(MOVE)          /* a = b */                                                         \
+    X(ADD) X(SUB) X(MUL) X(DIV) X(MOD)           /* a = b op c */                        \
+    X(EQ) X(NE) X(LT) X(LE) X(GT) X(GE)          /* a = b op c, a bool */                \
+    X(NEG) X(POS) X(NOT)                         /* a = op b */                          \
+    X(INPUT)         /* a = input(b), b is NO_REGISTER without a prompt */               \
+    X(PRINT)         /* print(b) */                                                      \
+    X(JUMP)          /* goto a */                                                        \
+    X(JUMP_IF_TRUE) X(JUMP_IF_FALSE)             /* goto a if b is truthy / falsy */     \
+    X(JUMP_IF_EQ) X(JUMP_IF_NE) X(JUMP_IF_LT) X(JUMP_IF_LE) X(JUMP_IF_GT) X(JUMP_IF_GE)  \
+    X(JUMP_IF_NOT_LT) X(JUMP_IF_NOT_LE) X(JUMP_IF_NOT_GT) X(JUMP_IF_NOT_GE)             \
+                     /* goto a if (not) b op c; fused so a loop test is one dispatch */  \
+    X(HALT)
+
+enum class Opcode : uint8_t {
+#define BYTECODE_ENUM(name) name,
+    BYTECODE_OPCODES(BYTECODE_ENUM)
+#undef BYTECODE_ENUM
+};
+
+const char* opcodeName(Opcode op);
+
+// Operator semantics, shared by the interpreter and the optimizer so a folded constant is
+// always what the program would have computed. Each returns false, with Python's message, where
+// Python would raise; new strings are stored in strings.
+
+// The value of a literal's text (a lexeme, or text written by appendValue); false if an
+// integer does not fit in 64 bits
+bool parseLiteral(TokenType type, std::string_view text, std::deque<std::string>& strings, Value& value);
+bool isTruthy(const Value& value);
+bool applyUnary(Opcode op, const Value& x, Value& result, std::string& error);  // NEG, POS, NOT
+bool applyBinary(Opcode op, const Value& x, const Value& y, std::deque<std::string>& strings, Value& result,
+                 std::string& error);                                              // ADD..MOD
+bool applyComparison(Opcode op, const Value& x, const Value& y, bool& result, std::string& error); // EQ..GE
+
+const uint32_t NO_REGISTER = UINT16_MAX;
+const uint32_t MAX_REGISTERS = UINT16_MAX;   // Register numbers are 16 bits, NO_REGISTER excluded
+const uint32_t MAX_INSTRUCTIONS = 1u << 24;  // Jump targets are 24 bits
+
+// 8 bytes: the opcode and a share one word
+struct Instruction {
+    uint32_t word; // Opcode in the low 8 bits, a in the high 24
+    uint16_t b;
+    uint16_t c;
+
+    Instruction(Opcode op, uint32_t a, uint32_t b, uint32_t c)
+        : word(static_cast<uint32_t>(op) | (a << 8)), b(static_cast<uint16_t>(b)), c(static_cast<uint16_t>(c)) {}
+
+    Opcode op() const { return static_cast<Opcode>(word & 0xFF); }
+    uint32_t a() const { return word >> 8; }
+    void setA(uint32_t a) { word = (word & 0xFF) | (a << 8); }
+};
+
+// A compile or run-time failure, with the line of the statement or expression at fault
+struct ExecutionError {
+    std::string message;
+    size_t line = 0;
+};
+
+// A compiled program. The STR constants point into constantStrings, so it can be moved but
+// not copied.
+struct BytecodeProgram {
+    std::vector<Instruction> code;
+    std::vector<uint32_t> lines;             // Source line of each instruction
+    std::vector<std::string> variableNames;  // By register (= SymbolTable position)
+    std::vector<Value> constants;            // Loaded into the registers after the variables
+    std::deque<std::string> constantStrings; // Storage of the STR constants
+    uint32_t registerCount = 0;
+
+    BytecodeProgram() = default;
+    BytecodeProgram(BytecodeProgram&&) = default;
+    BytecodeProgram& operator=(BytecodeProgram&&) = default;
+    BytecodeProgram(const BytecodeProgram&) = delete;
+    BytecodeProgram& operator=(const BytecodeProgram&) = delete;
+
+    uint32_t firstConstant() const { return static_cast<uint32_t>(variableNames.size()); }
+    uint32_t firstTemporary() const { return firstConstant() + static_cast<uint32_t>(constants.size()); }
+
+    void clear();
+
+    // Prints the register layout and one instruction per line
+    void disassemble(std::ostream& out = std::cout) const;
+};
+
+#endif
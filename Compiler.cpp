@@ -0,0 +1,476 @@
+// implementation of Compiler.h
+
+#include "Compiler.h"
+
+#include <algorithm>
+
+namespace {
+
+Opcode binaryOpcode(TokenType op) {
+    switch (op) {
+        case TokenType::PLUS: return Opcode::ADD;
+        case TokenType::MINUS: return Opcode::SUB;
+        case TokenType::MULTIPLY: return Opcode::MUL;
+        case TokenType::DIVIDE: return Opcode::DIV;
+        case TokenType::MODULO: return Opcode::MOD;
+        case TokenType::EQUAL_EQUAL: return Opcode::EQ;
+        case TokenType::NOT_EQUAL: return Opcode::NE;
+        case TokenType::LESS_THAN: return Opcode::LT;
+        case TokenType::LESS_EQUAL: return Opcode::LE;
+        case TokenType::GREATER_THAN: return Opcode::GT;
+        case TokenType::GREATER_EQUAL: return Opcode::GE;
+        default: return Opcode::HALT;
+    }
+}
+
+bool isComparison(TokenType op) {
+    return op == TokenType::EQUAL_EQUAL || op == TokenType::NOT_EQUAL || op == TokenType::LESS_THAN ||
+           op == TokenType::LESS_EQUAL || op == TokenType::GREATER_THAN || op == TokenType::GREATER_EQUAL;
+}
+
+// The branch taken when `left op right` is jumpWhen. == and != are each other's negation for
+// every type, but the orderings are not (NaN), so those have their own "not" forms.
+Opcode branchOpcode(TokenType op, bool jumpWhen) {
+    switch (op) {
+        case TokenType::EQUAL_EQUAL: return jumpWhen ? Opcode::JUMP_IF_EQ : Opcode::JUMP_IF_NE;
+        case TokenType::NOT_EQUAL: return jumpWhen ? Opcode::JUMP_IF_NE : Opcode::JUMP_IF_EQ;
+        case TokenType::LESS_THAN: return jumpWhen ? Opcode::JUMP_IF_LT : Opcode::JUMP_IF_NOT_LT;
+        case TokenType::LESS_EQUAL: return jumpWhen ? Opcode::JUMP_IF_LE : Opcode::JUMP_IF_NOT_LE;
+        case TokenType::GREATER_THAN: return jumpWhen ? Opcode::JUMP_IF_GT : Opcode::JUMP_IF_NOT_GT;
+        default: return jumpWhen ? Opcode::JUMP_IF_GE : Opcode::JUMP_IF_NOT_GE;
+    }
+}
+
+std::string constantKey(const AstNode& node) {
+    std::string key(1, static_cast<char>(node.op));
+    key += node.text;
+    return key;
+}
+
+} // namespace
+
+Compiler::Compiler(const Ast& ast, const SymbolTable& symbolTable)
+    : ast(ast), symbolTable(symbolTable), program(nullptr), nextTemporary(0), line(0), failed(false) {}
+
+// Keeps the first error; compilation carries on so the caller gets one consistent message
+void Compiler::fail(const std::string& message) {
+    if (!failed) {
+        failed = true;
+        error.message = message;
+        error.line = line;
+    }
+}
+
+size_t Compiler::emit(Opcode op, uint32_t a, uint32_t b, uint32_t c) {
+    program->code.emplace_back(op, a, b, c);
+    program->lines.push_back(line);
+    return program->code.size() - 1;
+}
+
+void Compiler::patch(const std::vector<size_t>& jumps, size_t target) {
+    for (size_t jump : jumps) {
+        program->code[jump].setA(static_cast<uint32_t>(target));
+    }
+}
+
+uint32_t Compiler::allocateTemporary() {
+    if (nextTemporary >= MAX_REGISTERS) {
+        fail("expression needs more than " + std::to_string(MAX_REGISTERS) + " registers");
+        return 0;
+    }
+    uint32_t reg = nextTemporary++;
+    program->registerCount = std::max(program->registerCount, nextTemporary);
+    return reg;
+}
+
+void Compiler::addConstants() {
+    ast.walk(ast.getRoot(), [&](NodeId id, size_t) {
+        const AstNode& node = ast.node(id);
+        if (node.kind != NodeKind::Literal) {
+            return true;
+        }
+        std::string key = constantKey(node);
+        if (constantRegisters.count(key) != 0) {
+            return true;
+        }
+        line = static_cast<uint32_t>(node.line);
+        Value value;
+        if (!parseLiteral(node.op, node.text, program->constantStrings, value)) {
+            fail("integer literal too large: " + std::string(node.text));
+        }
+        if (program->firstTemporary() >= MAX_REGISTERS) {
+            fail("program needs more than " + std::to_string(MAX_REGISTERS) + " registers");
+            return false;
+        }
+        constantRegisters.emplace(std::move(key), program->firstTemporary());
+        program->constants.push_back(value);
+        return true;
+    });
+}
+
+uint32_t Compiler::variableRegister(const AstNode& node) {
+    SymbolTable::SymTabPos pos = symbolTable.search(node.text);
+    if (pos == SymbolTable::SymTabPos::NOT_FOUND) {
+        fail("name '" + std::string(node.text) + "' is not in the symbol table");
+        return 0;
+    }
+    return static_cast<uint32_t>(pos);
+}
+
+bool Compiler::compile(BytecodeProgram& out) {
+    program = &out;
+    program->clear();
+    constantRegisters.clear();
+    error = ExecutionError();
+    failed = false;
+    line = 0;
+
+    for (const STEntry& entry : symbolTable.getEntries()) {
+        program->variableNames.push_back(entry.name);
+    }
+    if (program->variableNames.size() >= MAX_REGISTERS) {
+        fail("program has more than " + std::to_string(MAX_REGISTERS) + " variables");
+        return false;
+    }
+    addConstants();
+    nextTemporary = program->firstTemporary();
+    program->registerCount = nextTemporary;
+
+    if (ast.getRoot() != NO_NODE) {
+        compileStatement(ast.getRoot());
+    }
+    emit(Opcode::HALT, 0);
+    if (program->code.size() > MAX_INSTRUCTIONS) {
+        fail("program needs more than " + std::to_string(MAX_INSTRUCTIONS) + " instructions");
+    }
+    return !failed;
+}
+
+// Compiles from an explicit stack: the frame on top is revisited after each of its blocks
+void Compiler::compileStatement(NodeId root) {
+    size_t base = statementStack.size();
+    startStatement(root, true);
+    while (statementStack.size() > base) {
+        StatementFrame& frame = statementStack.back();
+        NodeKind kind = ast.node(frame.id).kind;
+        if (kind == NodeKind::If) {
+            nextBranch();
+            continue;
+        }
+        if (kind == NodeKind::While) {
+            finishWhile();
+            continue;
+        }
+        if (frame.child == NO_NODE) { // The block is done
+            bool statement = frame.statement;
+            statementStack.pop_back();
+            if (statement) {
+                nextTemporary = program->firstTemporary();
+            }
+            continue;
+        }
+        NodeId child = frame.child;
+        frame.child = ast.node(child).nextSibling;
+        startStatement(child, true);
+    }
+}
+
+void Compiler::startStatement(NodeId id, bool statement) {
+    const AstNode& node = ast.node(id);
+    line = static_cast<uint32_t>(node.line);
+    switch (node.kind) {
+        case NodeKind::Program:
+        case NodeKind::Block:
+            statementStack.push_back({id, node.firstChild, 0, 0, statement});
+            return;
+        case NodeKind::Assign: {
+            uint32_t variable = variableRegister(node);
+            uint32_t value = compileExpression(node.firstChild, variable);
+            if (value != variable) {
+                line = static_cast<uint32_t>(node.line);
+                emit(Opcode::MOVE, variable, value);
+            }
+            break;
+        }
+        case NodeKind::ExprStmt:
+            compileExpression(node.firstChild);
+            break;
+        case NodeKind::Print: {
+            uint32_t value = compileExpression(node.firstChild);
+            line = static_cast<uint32_t>(node.line);
+            emit(Opcode::PRINT, 0, value);
+            break;
+        }
+        case NodeKind::If:
+            // Children: condition, block, then (condition, block) per elif, then the else block
+            statementStack.push_back({id, node.firstChild, blockJumps.size(), blockJumps.size(), statement});
+            openBranch();
+            return;
+        case NodeKind::While: {
+            // The condition sits after the body: one jump in, then one branch per iteration
+            NodeId condition = node.firstChild;
+            NodeId body = condition == NO_NODE ? NO_NODE : ast.node(condition).nextSibling;
+            if (body == NO_NODE) {
+                fail("incomplete 'while' statement");
+                break;
+            }
+            size_t entry = emit(Opcode::JUMP, 0);
+            statementStack.push_back({id, condition, entry, here(), statement});
+            startStatement(body, false);
+            return;
+        }
+        case NodeKind::For:
+            fail("'for' loops cannot be run");
+            break;
+        default:
+            fail(std::string("cannot run a ") + nodeKindName(node.kind) + " statement");
+            break;
+    }
+    nextTemporary = program->firstTemporary(); // No temporary outlives its statement
+}
+
+// Closes the branch whose block was just compiled, then opens the next one
+void Compiler::nextBranch() {
+    StatementFrame& frame = statementStack.back();
+    if (frame.child != NO_NODE) {
+        line = static_cast<uint32_t>(ast.node(frame.id).line);
+        size_t toEnd = emit(Opcode::JUMP, 0);
+        patchBlockJumps(frame.nextStart, here());
+        blockJumps.push_back(toEnd);
+    } else {
+        patchBlockJumps(frame.nextStart, here());
+    }
+    openBranch();
+}
+
+// Compiles the condition of the next branch and pushes its block, or ends the if
+void Compiler::openBranch() {
+    StatementFrame& frame = statementStack.back();
+    NodeId child = frame.child;
+    if (child == NO_NODE) {
+        patchBlockJumps(frame.jumpStart, here());
+        bool statement = frame.statement;
+        statementStack.pop_back();
+        if (statement) {
+            nextTemporary = program->firstTemporary();
+        }
+        return;
+    }
+    NodeId block = ast.node(child).nextSibling;
+    frame.nextStart = blockJumps.size();
+    if (block == NO_NODE) { // The else block
+        frame.child = NO_NODE;
+        startStatement(child, false);
+        return;
+    }
+    frame.child = ast.node(block).nextSibling;
+    std::vector<size_t> toNext = compileBranch(child, false);
+    blockJumps.insert(blockJumps.end(), toNext.begin(), toNext.end());
+    startStatement(block, false);
+}
+
+// Patches the jumps from start on in blockJumps and drops them
+void Compiler::patchBlockJumps(size_t start, size_t target) {
+    for (size_t i = start; i < blockJumps.size(); ++i) {
+        program->code[blockJumps[i]].setA(static_cast<uint32_t>(target));
+    }
+    blockJumps.resize(start);
+}
+
+void Compiler::finishWhile() {
+    StatementFrame frame = statementStack.back();
+    statementStack.pop_back();
+    patch({frame.jumpStart}, here());
+    patch(compileBranch(frame.child, true), frame.nextStart);
+    if (frame.statement) {
+        nextTemporary = program->firstTemporary();
+    }
+}
+
+// Compiles from an explicit stack: a frame is revisited after each operand, with value holding
+// the register of the operand just finished
+uint32_t Compiler::compileExpression(NodeId root, uint32_t rootTarget) {
+    size_t base = expressionStack.size();
+    expressionStack.push_back({root, rootTarget, 0, 0, 0, 0, 0});
+    uint32_t value = 0;
+    while (expressionStack.size() > base) {
+        ExpressionFrame& frame = expressionStack.back();
+        if (frame.id == NO_NODE) {
+            fail("incomplete expression");
+            value = 0;
+            expressionStack.pop_back();
+            continue;
+        }
+        const AstNode& node = ast.node(frame.id);
+        switch (node.kind) {
+            case NodeKind::Literal:
+                value = constantRegisters[constantKey(node)];
+                break;
+            case NodeKind::Name:
+                value = variableRegister(node);
+                break;
+            case NodeKind::Input: {
+                if (frame.step == 0) {
+                    frame.mark = nextTemporary;
+                    if (node.firstChild != NO_NODE) {
+                        frame.step = 1;
+                        expressionStack.push_back({node.firstChild, NO_REGISTER, 0, 0, 0, 0, 0});
+                        continue;
+                    }
+                    value = NO_REGISTER; // No prompt
+                }
+                nextTemporary = frame.mark;
+                uint32_t result = frame.target != NO_REGISTER ? frame.target : allocateTemporary();
+                line = static_cast<uint32_t>(node.line);
+                emit(Opcode::INPUT, result, value);
+                value = result;
+                break;
+            }
+            case NodeKind::Unary: {
+                if (frame.step == 0) {
+                    frame.mark = nextTemporary;
+                    frame.step = 1;
+                    expressionStack.push_back({node.firstChild, NO_REGISTER, 0, 0, 0, 0, 0});
+                    continue;
+                }
+                nextTemporary = frame.mark;
+                uint32_t result = frame.target != NO_REGISTER ? frame.target : allocateTemporary();
+                Opcode op = node.op == TokenType::MINUS ? Opcode::NEG : node.op == TokenType::PLUS ? Opcode::POS : Opcode::NOT;
+                line = static_cast<uint32_t>(node.line);
+                emit(op, result, value);
+                value = result;
+                break;
+            }
+            case NodeKind::Binary: {
+                NodeId rightId = node.firstChild == NO_NODE ? NO_NODE : ast.node(node.firstChild).nextSibling;
+                if (node.op == TokenType::AND || node.op == TokenType::OR) {
+                    // 'and' / 'or' give back the operand that decided them. The result gets its own
+                    // temporary: the caller's target may be a variable the right operand still reads.
+                    if (frame.step == 0) {
+                        frame.result = allocateTemporary();
+                        frame.step = 1;
+                        expressionStack.push_back({node.firstChild, NO_REGISTER, 0, 0, 0, 0, 0});
+                        continue;
+                    }
+                    uint32_t result = frame.result;
+                    if (frame.step == 1) {
+                        line = static_cast<uint32_t>(node.line);
+                        if (value != result) {
+                            emit(Opcode::MOVE, result, value);
+                        }
+                        frame.skip = emit(node.op == TokenType::AND ? Opcode::JUMP_IF_FALSE : Opcode::JUMP_IF_TRUE, 0, result);
+                        nextTemporary = result + 1;
+                        frame.step = 2;
+                        expressionStack.push_back({rightId, result, 0, 0, 0, 0, 0});
+                        continue;
+                    }
+                    if (value != result) {
+                        line = static_cast<uint32_t>(node.line);
+                        emit(Opcode::MOVE, result, value);
+                    }
+                    nextTemporary = result + 1;
+                    patch({frame.skip}, here());
+                    value = result;
+                    break;
+                }
+                if (frame.step == 0) {
+                    frame.mark = nextTemporary;
+                    frame.step = 1;
+                    expressionStack.push_back({node.firstChild, NO_REGISTER, 0, 0, 0, 0, 0});
+                    continue;
+                }
+                if (frame.step == 1) {
+                    frame.left = value;
+                    frame.step = 2;
+                    expressionStack.push_back({rightId, NO_REGISTER, 0, 0, 0, 0, 0});
+                    continue;
+                }
+                nextTemporary = frame.mark;
+                // Both operands are read before the result is written, so it may reuse either register
+                uint32_t result = frame.target != NO_REGISTER ? frame.target : allocateTemporary();
+                line = static_cast<uint32_t>(node.line);
+                emit(binaryOpcode(node.op), result, frame.left, value);
+                value = result;
+                break;
+            }
+            default:
+                fail(std::string("cannot evaluate a ") + nodeKindName(node.kind) + " node");
+                value = 0;
+                break;
+        }
+        expressionStack.pop_back();
+    }
+    return value;
+}
+
+// Also from an explicit stack. Every frame's jumps are appended to one list, so those of the
+// frame on top are always at its end.
+std::vector<size_t> Compiler::compileBranch(NodeId root, bool rootJumpWhen) {
+    std::vector<size_t> jumps;
+    size_t base = conditionStack.size();
+    conditionStack.push_back({root, rootJumpWhen, 0, 0, 0});
+    while (conditionStack.size() > base) {
+        ConditionFrame& frame = conditionStack.back();
+        if (frame.id == NO_NODE) {
+            fail("incomplete condition");
+            conditionStack.pop_back();
+            continue;
+        }
+        const AstNode& node = ast.node(frame.id);
+        bool jumpWhen = frame.jumpWhen;
+        if (node.kind == NodeKind::Unary && node.op == TokenType::NOT) {
+            frame.id = node.firstChild;
+            frame.jumpWhen = !jumpWhen;
+            continue;
+        }
+        NodeId rightId = node.firstChild == NO_NODE ? NO_NODE : ast.node(node.firstChild).nextSibling;
+        if (node.kind == NodeKind::Binary && node.firstChild != NO_NODE &&
+            (node.op == TokenType::AND || node.op == TokenType::OR)) {
+            bool isAnd = node.op == TokenType::AND;
+            if (jumpWhen != isAnd) {
+                // 'and' jumping when false, 'or' jumping when true: either operand can decide
+                if (frame.step < 2) {
+                    NodeId operand = frame.step == 0 ? node.firstChild : rightId;
+                    frame.step++;
+                    conditionStack.push_back({operand, jumpWhen, 0, 0, 0});
+                    continue;
+                }
+            } else if (frame.step == 0) {
+                // Otherwise the left operand can only rule the jump out
+                frame.skipStart = jumps.size();
+                frame.step = 1;
+                conditionStack.push_back({node.firstChild, !jumpWhen, 0, 0, 0});
+                continue;
+            } else if (frame.step == 1) {
+                frame.rightStart = jumps.size();
+                frame.step = 2;
+                conditionStack.push_back({rightId, jumpWhen, 0, 0, 0});
+                continue;
+            } else {
+                for (size_t i = frame.skipStart; i < frame.rightStart; ++i) {
+                    program->code[jumps[i]].setA(static_cast<uint32_t>(here()));
+                }
+                jumps.erase(jumps.begin() + static_cast<std::ptrdiff_t>(frame.skipStart),
+                            jumps.begin() + static_cast<std::ptrdiff_t>(frame.rightStart));
+            }
+            conditionStack.pop_back();
+            continue;
+        }
+
+        uint32_t mark = nextTemporary;
+        if (node.kind == NodeKind::Binary && node.firstChild != NO_NODE && isComparison(node.op)) {
+            uint32_t left = compileExpression(node.firstChild);
+            uint32_t right = compileExpression(rightId);
+            nextTemporary = mark;
+            line = static_cast<uint32_t>(node.line);
+            jumps.push_back(emit(branchOpcode(node.op, jumpWhen), 0, left, right));
+        } else {
+            uint32_t value = compileExpression(frame.id);
+            nextTemporary = mark;
+            line = static_cast<uint32_t>(node.line);
+            jumps.push_back(emit(jumpWhen ? Opcode::JUMP_IF_TRUE : Opcode::JUMP_IF_FALSE, 0, value));
+        }
+        conditionStack.pop_back();
+    }
+    return jumps;
+}
@@ -0,0 +1,93 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AST.h"
+#include "Bytecode.h"
+#include "SymbolTable.h"
+
+// Compiles the tree of an error-free parse into register bytecode (see Bytecode.h).
+// Variables live in the registers numbered by their SymbolTable position; each distinct literal
+// gets one constant register; temporaries are reused statement by statement. An assignment
+// writes its result straight into the variable, so `counter = counter + 1` is one ADD.
+// Conditions of if/elif/while compile to fused compare-and-branch instructions, with 'and',
+// 'or' and 'not' turned into jumps, and loops test at the bottom (one branch per iteration).
+class Compiler {
+private:
+    // An expression being compiled, revisited once per operand
+    struct ExpressionFrame {
+        NodeId id;
+        uint32_t target; // Where a computed result should go, NO_REGISTER for a temporary
+        uint32_t mark;   // nextTemporary on reaching the node
+        uint32_t left;   // Register of the left operand, once compiled
+        uint32_t result; // 'and' / 'or': the register of the value
+        size_t skip;     // 'and' / 'or': the jump past the right operand
+        uint8_t step;    // Operands done so far
+    };
+    // A block, if or while whose blocks are being compiled, revisited after each of them
+    struct StatementFrame {
+        NodeId id;
+        NodeId child;     // Block: the next statement; If: the child after the block being compiled
+        size_t jumpStart; // If: where its jumps to the end start in blockJumps; While: the jump in
+        size_t nextStart; // If: where the branch's jumps to the next one start; While: the loop's top
+        bool statement;   // Compiled as a statement (not as the block of an if or while)
+    };
+    // A condition being compiled into jumps taken when it is jumpWhen
+    struct ConditionFrame {
+        NodeId id;
+        bool jumpWhen;
+        uint8_t step;
+        size_t skipStart;  // Where the jumps of a left operand that rules the jump out start
+        size_t rightStart; // and end
+    };
+
+    const Ast& ast;
+    const SymbolTable& symbolTable;
+    BytecodeProgram* program;
+    std::unordered_map<std::string, uint32_t> constantRegisters; // Literal type + text -> register
+    uint32_t nextTemporary;
+    uint32_t line; // Of the node being compiled, recorded with each instruction
+    ExecutionError error;
+    bool failed;
+    // Expressions and conditions nest as deep as an operator chain is long, and blocks as deep as
+    // ErrorPolicy::maxNesting allows, so they are compiled from these stacks rather than by recursion
+    std::vector<StatementFrame> statementStack;
+    std::vector<size_t> blockJumps; // Jumps of the ifs on statementStack, patched when they are done
+    std::vector<ExpressionFrame> expressionStack;
+    std::vector<ConditionFrame> conditionStack;
+
+    void fail(const std::string& message);
+    size_t emit(Opcode op, uint32_t a, uint32_t b = 0, uint32_t c = 0);
+    size_t here() const { return program->code.size(); }
+    void patch(const std::vector<size_t>& jumps, size_t target);
+    uint32_t allocateTemporary();
+
+    void addConstants(); // Gives every literal in the tree its register
+    uint32_t variableRegister(const AstNode& node);
+
+    void compileStatement(NodeId id);
+    // Compiles a one-line statement, or pushes the frame of a block, if or while
+    void startStatement(NodeId id, bool statement);
+    void nextBranch();
+    void openBranch();
+    void patchBlockJumps(size_t start, size_t target);
+    void finishWhile();
+    // Returns the register holding the value; target, if given, is where a computed result
+    // should go (names and constants are returned as they are)
+    uint32_t compileExpression(NodeId id, uint32_t target = NO_REGISTER);
+    // Emits jumps taken when the condition is jumpWhen, and returns them for patching; falls
+    // through otherwise
+    std::vector<size_t> compileBranch(NodeId id, bool jumpWhen);
+
+public:
+    Compiler(const Ast& ast, const SymbolTable& symbolTable);
+
+    // Replaces program with the compiled tree. False if it cannot be compiled (see getError).
+    bool compile(BytecodeProgram& program);
+    const ExecutionError& getError() const { return error; }
+};
+
+#endif
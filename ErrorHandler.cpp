@@ -1,26 +1,132 @@
 #include "ErrorHandler.h"
+#include "Stats.h"
 
-void ErrorHandler::reportError(const std::string& message, int lineNumber, int columnNumber, const std::string& type) {
-    errors.emplace_back(message, lineNumber, columnNumber, type);
+namespace {
+
+// Name of an expected token type as shown in "Expected ..." messages
+const char* expectedTypeName(TokenType type) {
+    switch (type) {
+        case TokenType::IDENTIFIER: return "IDENTIFIER";
+        case TokenType::ASSIGN: return "ASSIGN (=)";
+        case TokenType::LPAREN: return "LPAREN";
+        case TokenType::RPAREN: return "RPAREN";
+        case TokenType::COLON: return "COLON";
+        case TokenType::NEWLINE: return "NEWLINE";
+        case TokenType::INDENT: return "INDENT";
+        case TokenType::DEDENT: return "DEDENT";
+        case TokenType::END_OF_FILE: return "END_OF_FILE";
+        case TokenType::IF: return "IF";
+        case TokenType::ELSE: return "ELSE";
+        case TokenType::ELIF: return "ELIF";
+        case TokenType::WHILE: return "WHILE";
+        case TokenType::FOR: return "FOR";
+        case TokenType::PRINT: return "PRINT";
+        case TokenType::INPUT: return "INPUT";
+        case TokenType::PLUS: return "PLUS (+)";
+        case TokenType::MINUS: return "MINUS (-)";
+        case TokenType::MULTIPLY: return "MULTIPLY (*)";
+        case TokenType::DIVIDE: return "DIVIDE (/)";
+        case TokenType::MODULO: return "MODULO (%)";
+        case TokenType::EQUAL_EQUAL: return "EQUAL_EQUAL (==)";
+        case TokenType::NOT_EQUAL: return "NOT_EQUAL (!=)";
+        case TokenType::LESS_THAN: return "LESS_THAN (<)";
+        case TokenType::LESS_EQUAL: return "LESS_EQUAL (<=)";
+        case TokenType::GREATER_THAN: return "GREATER_THAN (>)";
+        case TokenType::GREATER_EQUAL: return "GREATER_EQUAL (>=)";
+        case TokenType::AND: return "AND";
+        case TokenType::OR: return "OR";
+        case TokenType::NOT: return "NOT";
+        case TokenType::INTEGER_LITERAL: return "INTEGER_LITERAL";
+        case TokenType::FLOAT_LITERAL: return "FLOAT_LITERAL";
+        case TokenType::STRING_LITERAL: return "STRING_LITERAL";
+        case TokenType::BOOLEAN_LITERAL: return "BOOLEAN_LITERAL";
+        // can add more cases
+        default: return "UNKNOWN_EXPECTED_TYPE";
+    }
+}
+
+} // namespace
+
+std::string Error::message() const {
+    switch (code) {
+        case ErrorCode::UNKNOWN_CHARACTER:
+            return "Unknown character: '" + detail + "'";
+        case ErrorCode::UNEXPECTED_CHARACTER:
+            return "Unexpected character: '" + detail + "'";
+        case ErrorCode::UNTERMINATED_STRING:
+            return "Unterminated string literal.";
+        case ErrorCode::INCONSISTENT_DEDENT:
+            return "Unindent does not match any outer indentation level.";
+        case ErrorCode::EXPECTED_TOKEN:
+            return std::string("Expected ") + expectedTypeName(expected) + " but found '" + detail + "' (type: " +
+                   std::to_string(static_cast<int>(found)) + ")";
+        case ErrorCode::UNEXPECTED_TOKEN:
+            return "Unexpected token at start of statement: '" + detail + "'";
+        case ErrorCode::EXPECTED_EXPRESSION:
+            return "Expected an expression, literal, identifier, '(', or 'input()' call, but found '" + detail + "'";
+        case ErrorCode::UNDECLARED_IDENTIFIER:
+            return "Undeclared identifier: " + detail;
+        case ErrorCode::FOR_NOT_SUPPORTED:
+            return "Simple 'for' loop syntax `for IDENTIFIER in ITERABLE` not fully implemented. Expected 'in' followed by iterable.";
+        case ErrorCode::EXPECTED_LOOP:
+            return "Internal error: Expected 'while' or 'for'.";
+        case ErrorCode::UNEXPECTED_INDENT:
+            return "Unexpected indent.";
+        case ErrorCode::EXPECTED_BLOCK:
+            return "Expected an indented block but found '" + detail + "'";
+        case ErrorCode::TOO_DEEPLY_NESTED:
+            return "Blocks and parentheses nested more than " + detail + " deep (see --max-nesting)";
+        case ErrorCode::MESSAGE:
+            return detail;
+    }
+    return detail;
+}
+
+void ErrorHandler::reportError(ErrorKind kind, ErrorCode code, std::string_view detail, size_t offset,
+                               TokenType expected, TokenType found) {
+    Stats::countError(kind);
     hasErrorsFlag = true;
+    if (limitReached()) {
+        droppedCount++;
+        return;
+    }
+    errors.emplace_back(kind, code, detail, offset, expected, found);
+}
+
+void ErrorHandler::appendErrors(const ErrorHandler& other, size_t delta) {
+    for (const Error& err : other.errors) {
+        if (limitReached()) {
+            droppedCount++;
+            continue;
+        }
+        errors.push_back(err);
+        errors.back().offset += delta;
+    }
+    droppedCount += other.droppedCount;
+    hasErrorsFlag = hasErrorsFlag || other.hasErrorsFlag;
 }
 
 bool ErrorHandler::hasErrors() const {
     return hasErrorsFlag;
 }
 
-void ErrorHandler::printErrors() const {
+void ErrorHandler::printErrors(const LineIndex& lines, std::ostream& out) const {
     if (!errors.empty()) {
-        std::cerr << "\n--- Errors Encountered ---" << std::endl;
+        out << "\n--- Errors Encountered ---" << '\n';
         for (const auto& err : errors) {
-            std::cerr << err.type << " Error at Line " << err.lineNumber
-                      << ", Column " << err.columnNumber << ": " << err.message << std::endl;
+            out << err.typeName() << " Error at Line " << lines.line(err.offset)
+                      << ", Column " << lines.column(err.offset) << ": " << err.message() << '\n';
+        }
+        if (droppedCount > 0) {
+            out << "Stopped at the limit of " << policy.maxErrors << " errors (" << droppedCount
+                << " more not shown)." << '\n';
         }
-        std::cerr << "--------------------------" << std::endl;
+        out << "--------------------------" << '\n';
     }
 }
 
 void ErrorHandler::clearErrors() {
     errors.clear();
     hasErrorsFlag = false;
-}
\ No newline at end of file
+    droppedCount = 0;
+}
@@ -1,32 +1,101 @@
 #ifndef ERRORHANDLER_H
 #define ERRORHANDLER_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 
+#include "Token.h"
+#include "LineIndex.h"
+
+enum class ErrorKind : uint8_t { LEXICAL, SYNTAX };
+
+// What went wrong; Error::message() turns the code and its detail into text
+enum class ErrorCode : uint8_t {
+    UNKNOWN_CHARACTER,     // detail: the character
+    UNEXPECTED_CHARACTER,  // detail: the character
+    UNTERMINATED_STRING,
+    INCONSISTENT_DEDENT,   // a line's indentation matches none of the open blocks
+    EXPECTED_TOKEN,        // expected/found: token types, detail: the lexeme found
+    UNEXPECTED_TOKEN,      // at the start of a statement; detail: the lexeme
+    EXPECTED_EXPRESSION,   // detail: the lexeme found
+    UNDECLARED_IDENTIFIER, // detail: the name
+    FOR_NOT_SUPPORTED,
+    EXPECTED_LOOP,
+    UNEXPECTED_INDENT,     // an indented line that does not start a block
+    EXPECTED_BLOCK,        // nothing indented after a ':' and a newline; detail: the lexeme found
+    TOO_DEEPLY_NESTED,     // past ErrorPolicy::maxNesting; detail: the limit
+    MESSAGE                // detail is the whole message
+};
+
+// Compact error record: the message text, line and column are only worked out when it is printed
 struct Error {
-    std::string message;
-    int lineNumber;
-    int columnNumber;
-    std::string type; // "Lexical" or "Syntax"
+    ErrorKind kind;
+    ErrorCode code;
+    TokenType expected;
+    TokenType found;
+    std::string detail; // Usually a short lexeme, so it stays in the string's inline buffer
+    size_t offset;      // Where in the source, like Token::offset
+
+    Error(ErrorKind kind, ErrorCode code, std::string_view detail, size_t offset,
+          TokenType expected = TokenType::UNKNOWN, TokenType found = TokenType::UNKNOWN)
+        : kind(kind), code(code), expected(expected), found(found), detail(detail), offset(offset) {}
+
+    std::string message() const;
+    const char* typeName() const { return kind == ErrorKind::LEXICAL ? "Lexical" : "Syntax"; }
+
+    bool operator==(const Error& other) const {
+        return kind == other.kind && code == other.code && expected == other.expected && found == other.found &&
+               detail == other.detail && offset == other.offset;
+    }
+};
 
-    Error(const std::string& msg, int line, int col, const std::string& type)
-        : message(msg), lineNumber(line), columnNumber(col), type(type) {}
+// How much of a file to check. By default the parser stops after the first statement with an
+// error. With recover set it skips to the next statement and keeps going, so one run reports
+// every error; maxErrors (0 = no limit) bounds the work on badly broken input. The next statement
+// is the next token in column 1 after a physical line break, found from offsets, so recovery does
+// not rely on NEWLINE tokens. A '(' or '[' that is never closed ends its line where the next line
+// starts a statement in column 1 (see Lexer.h): the missing bracket is reported at the end of its
+// own line and parsing resumes at that statement.
+// maxNesting bounds how deeply blocks and parentheses may nest (CPython's tokenizer allows 200
+// parentheses); it is at least 1. The parser and every pass after it walk blocks and expressions
+// over explicit stacks, so a raised limit costs heap memory in proportion to the nesting but cannot
+// overflow the native stack.
+struct ErrorPolicy {
+    bool recover = false;
+    size_t maxErrors = 0;
+    size_t maxNesting = 200;
 };
 
 class ErrorHandler {
 private:
     std::vector<Error> errors;
     bool hasErrorsFlag;
+    ErrorPolicy policy;
+    size_t droppedCount; // Errors past policy.maxErrors
 
 public:
-    ErrorHandler() : hasErrorsFlag(false) {}
+    explicit ErrorHandler(ErrorPolicy policy = ErrorPolicy()) : hasErrorsFlag(false), policy(policy), droppedCount(0) {}
 
-    void reportError(const std::string& message, int lineNumber, int columnNumber, const std::string& type);
+    void reportError(ErrorKind kind, ErrorCode code, std::string_view detail, size_t offset,
+                     TokenType expected = TokenType::UNKNOWN, TokenType found = TokenType::UNKNOWN);
+    // Copies another handler's errors with their offsets moved by delta (the other handler saw
+    // a piece of the source starting there). They are not counted again in the run statistics
+    // (see Stats.h).
+    void appendErrors(const ErrorHandler& other, size_t delta);
     bool hasErrors() const;
-    void printErrors() const;
+    size_t errorCount() const { return errors.size(); }
+    size_t reportedCount() const { return errors.size() + droppedCount; } // Including dropped ones
+    const ErrorPolicy& getPolicy() const { return policy; }
+    // True once maxErrors errors have been reported; later ones are only counted
+    bool limitReached() const { return policy.maxErrors != 0 && errors.size() >= policy.maxErrors; }
+    size_t droppedErrors() const { return droppedCount; }
+    // lines indexes the source the errors were found in
+    void printErrors(const LineIndex& lines, std::ostream& out = std::cerr) const;
+    const std::vector<Error>& getErrors() const { return errors; }
     void clearErrors(); // To allow parsing multiple files or attempts
 };
 
-#endif
\ No newline at end of file
+#endif
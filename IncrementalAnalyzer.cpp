@@ -0,0 +1,679 @@
+// implementation of IncrementalAnalyzer.h
+
+#include "IncrementalAnalyzer.h"
+#include "Lexer.h"
+#include "Parser.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+// Whether tokens[i] starts a segment: a token in column 1 after a NEWLINE or DEDENT, which leaves
+// no block or bracket open, other than 'elif' / 'else', which continue an 'if' (see Lexer.h).
+// For i == 0 the caller knows what comes before.
+bool startsSegment(const std::vector<Token>& tokens, size_t i, std::string_view text) {
+    const Token& token = tokens[i];
+    return !isLayoutToken(token.type) && token.type != TokenType::END_OF_FILE && token.type != TokenType::ELIF &&
+           token.type != TokenType::ELSE && (token.offset == 0 || text[token.offset - 1] == '\n') &&
+           (i == 0 || isLayoutToken(tokens[i - 1].type));
+}
+
+// Points a lexeme that views into the size bytes at from at the same bytes at to. Lexemes that are
+// string literals ("EOF", or "" for an unexpected character) are left alone.
+void rebase(std::string_view& lexeme, const char* from, size_t size, const char* to) {
+    uintptr_t at = reinterpret_cast<uintptr_t>(lexeme.data());
+    uintptr_t base = reinterpret_cast<uintptr_t>(from);
+    if (at >= base && at <= base + size) {
+        lexeme = std::string_view(to + (at - base), lexeme.size());
+    }
+}
+
+} // namespace
+
+void IncrementalAnalyzer::Totals::add(const Totals& other) {
+    segments += other.segments;
+    bytes += other.bytes;
+    tokens += other.tokens;
+    lexicalErrors += other.lexicalErrors;
+    unparsable += other.unparsable;
+    lines += other.lines;
+    uses += other.uses;
+}
+
+IncrementalAnalyzer::IncrementalAnalyzer(std::string code)
+    : root(NO_SEGMENT), nameIds(0), failingReaders(BySourceOrder{&segments}), built(false), symbolsBuilt(false) {
+    ErrorHandler errors;
+    Lexer lexer(code, errors);
+    std::vector<Token> tokens = lexer.tokenize();
+    tokens.pop_back();
+    std::vector<uint32_t> made = makeSegments(code, tokens, errors.getErrors());
+    for (uint32_t id : made) {
+        root = join(root, id);
+    }
+    label(0, made.size());
+    for (uint32_t id : made) {
+        index(id, true);
+    }
+}
+
+const IncrementalAnalyzer::Totals& IncrementalAnalyzer::totals(uint32_t tree) const {
+    static const Totals none;
+    return tree == NO_SEGMENT ? none : segments[tree].subtree;
+}
+
+// What the segments before a segment in the tree hold together. Labels increase in source order,
+// so they lead the way down to it.
+IncrementalAnalyzer::Totals IncrementalAnalyzer::before(uint32_t id) const {
+    Totals sum;
+    uint64_t target = segments[id].label;
+    uint32_t at = root;
+    while (at != id) {
+        const Segment& segment = segments[at];
+        if (target < segment.label) {
+            at = segment.left;
+        } else {
+            sum.add(totals(segment.left));
+            sum.add(segment.own);
+            at = segment.right;
+        }
+    }
+    sum.add(totals(segments[id].left));
+    return sum;
+}
+
+void IncrementalAnalyzer::update(uint32_t id) {
+    Segment& segment = segments[id];
+    segment.subtree = segment.own;
+    for (uint32_t child : {segment.left, segment.right}) {
+        if (child != NO_SEGMENT) {
+            segment.subtree.add(segments[child].subtree);
+        }
+    }
+}
+
+// Joins two trees, every segment of left coming before every one of right. The recursion follows
+// one path down each tree; with random priorities its length is logarithmic in the segment count.
+uint32_t IncrementalAnalyzer::join(uint32_t left, uint32_t right) {
+    if (left == NO_SEGMENT || right == NO_SEGMENT) {
+        return left == NO_SEGMENT ? right : left;
+    }
+    if (segments[left].priority > segments[right].priority) {
+        uint32_t joined = join(segments[left].right, right);
+        segments[left].right = joined;
+        update(left);
+        return left;
+    }
+    uint32_t joined = join(left, segments[right].left);
+    segments[right].left = joined;
+    update(right);
+    return right;
+}
+
+// Splits a tree into its first count segments and the rest (recursing as join() does)
+void IncrementalAnalyzer::split(uint32_t tree, size_t count, uint32_t& left, uint32_t& right) {
+    if (tree == NO_SEGMENT) {
+        left = right = NO_SEGMENT;
+        return;
+    }
+    Segment& segment = segments[tree];
+    size_t leftCount = totals(segment.left).segments;
+    if (count <= leftCount) {
+        uint32_t rest;
+        split(segment.left, count, left, rest);
+        segment.left = rest;
+        right = tree;
+    } else {
+        uint32_t first;
+        split(segment.right, count - leftCount - 1, first, right);
+        segment.right = first;
+        left = tree;
+    }
+    update(tree);
+}
+
+uint32_t IncrementalAnalyzer::segmentAt(size_t index) const {
+    uint32_t id = root;
+    while (true) {
+        size_t leftCount = totals(segments[id].left).segments;
+        if (index == leftCount) {
+            return id;
+        }
+        if (index < leftCount) {
+            id = segments[id].left;
+        } else {
+            index -= leftCount + 1;
+            id = segments[id].right;
+        }
+    }
+}
+
+// The index of the segment holding the byte at offset, which must be in the source; start is set
+// to the offset where that segment starts
+size_t IncrementalAnalyzer::locate(size_t offset, size_t& start) const {
+    uint32_t id = root;
+    size_t index = 0;
+    start = 0;
+    while (true) {
+        const Segment& segment = segments[id];
+        const Totals& before = totals(segment.left);
+        if (offset < before.bytes) {
+            id = segment.left;
+            continue;
+        }
+        offset -= before.bytes;
+        index += before.segments;
+        start += before.bytes;
+        if (offset < segment.text.size()) {
+            return index;
+        }
+        offset -= segment.text.size();
+        index++;
+        start += segment.text.size();
+        id = segment.right;
+    }
+}
+
+// Labels the segments [first, first + count) evenly between the segments around them. When
+// the labels there are used up, more segments on either side are relabeled with them, as many as
+// it takes to leave a gap of at least RELABELED_GAP.
+void IncrementalAnalyzer::label(size_t first, size_t count) {
+    const uint64_t RELABELED_GAP = uint64_t(1) << 16;
+    size_t total = totals(root).segments;
+    size_t begin = first;
+    size_t end = first + count;
+    size_t widenBy = 1;
+    while (true) {
+        uint64_t low = begin == 0 ? 0 : segments[segmentAt(begin - 1)].label;
+        uint64_t high = end == total ? UINT64_MAX : segments[segmentAt(end)].label;
+        uint64_t gap = (high - low) / (end - begin + 1);
+        bool widened = begin < first || end > first + count;
+        if (gap >= (widened ? RELABELED_GAP : 1) || (begin == 0 && end == total)) {
+            for (size_t i = begin; i < end; i++) {
+                segments[segmentAt(i)].label = low + gap * (i - begin + 1);
+            }
+            return;
+        }
+        begin = begin > widenBy ? begin - widenBy : 0;
+        end = std::min(total, end + widenBy);
+        widenBy *= 2;
+    }
+}
+
+std::vector<uint32_t> IncrementalAnalyzer::inOrder() const {
+    std::vector<uint32_t> order;
+    order.reserve(totals(root).segments);
+    std::vector<uint32_t> pending;
+    uint32_t id = root;
+    while (id != NO_SEGMENT || !pending.empty()) {
+        if (id != NO_SEGMENT) {
+            pending.push_back(id);
+            id = segments[id].left;
+        } else {
+            order.push_back(pending.back());
+            id = segments[pending.back()].right;
+            pending.pop_back();
+        }
+    }
+    return order;
+}
+
+uint32_t IncrementalAnalyzer::newSegment() {
+    uint32_t id;
+    if (freeSegments.empty()) {
+        id = static_cast<uint32_t>(segments.size());
+        segments.emplace_back();
+    } else {
+        id = freeSegments.back();
+        freeSegments.pop_back();
+    }
+    segments[id].priority = static_cast<uint32_t>(random());
+    return id;
+}
+
+// Frees every segment of a tree taken out of the source
+void IncrementalAnalyzer::release(uint32_t tree) {
+    std::vector<uint32_t> pending;
+    if (tree != NO_SEGMENT) {
+        pending.push_back(tree);
+    }
+    while (!pending.empty()) {
+        uint32_t id = pending.back();
+        pending.pop_back();
+        for (uint32_t child : {segments[id].left, segments[id].right}) {
+            if (child != NO_SEGMENT) {
+                pending.push_back(child);
+            }
+        }
+        segments[id] = Segment();
+        freeSegments.push_back(id);
+    }
+}
+
+// Cuts lexed text (without its END_OF_FILE) into new, parsed segments, not yet in the tree. The
+// text must start where a segment can: at the start of the source or of a statement.
+std::vector<uint32_t> IncrementalAnalyzer::makeSegments(const std::string& text, const std::vector<Token>& tokens,
+                                                        const std::vector<Error>& errors) {
+    std::vector<uint32_t> made;
+    size_t token = 0;
+    size_t error = 0;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t next = std::min(token + 1, tokens.size());
+        while (next < tokens.size() && !startsSegment(tokens, next, text)) {
+            next++;
+        }
+        size_t end = next < tokens.size() ? tokens[next].offset : text.size();
+
+        uint32_t id = newSegment();
+        Segment& segment = segments[id];
+        segment.text.assign(text, start, end - start);
+        segment.tokens.assign(tokens.begin() + token, tokens.begin() + next);
+        for (Token& moved : segment.tokens) {
+            moved.offset -= start;
+            rebase(moved.lexeme, text.data() + start, end - start, segment.text.data());
+        }
+        while (error < errors.size() && (errors[error].offset < end || end == text.size())) {
+            segment.lexicalErrors.push_back(errors[error++]);
+            segment.lexicalErrors.back().offset -= start;
+        }
+        size_t openBrackets = 0;
+        for (const Token& kept : segment.tokens) {
+            if (kept.type == TokenType::LPAREN || kept.type == TokenType::LBRACKET) {
+                openBrackets++;
+            } else if ((kept.type == TokenType::RPAREN || kept.type == TokenType::RBRACKET) && openBrackets > 0) {
+                openBrackets--;
+            }
+        }
+        segment.bracketOpen = openBrackets > 0;
+        parse(segment);
+        segment.own.segments = 1;
+        segment.own.bytes = segment.text.size();
+        segment.own.tokens = segment.tokens.size();
+        segment.own.lexicalErrors = segment.lexicalErrors.size();
+        segment.own.unparsable = segment.parses ? 0 : 1;
+        segment.own.lines = static_cast<size_t>(std::count(segment.text.begin(), segment.text.end(), '\n'));
+        segment.own.uses = segment.uses.size();
+        segment.subtree = segment.own;
+        made.push_back(id);
+
+        token = next;
+        start = end;
+    }
+    return made;
+}
+
+// Parses a segment on its own. Whether a statement parses only depends on what follows it through
+// the check for 'elif' / 'else', and no segment starts with those, so END_OF_FILE stands in for it.
+// In a segment that parses every identifier is either assigned (followed by '=') or read; they are
+// kept as its uses.
+void IncrementalAnalyzer::parse(Segment& segment) {
+    segment.tokens.push_back(
+        Token(TokenType::END_OF_FILE, syntheticLexeme(TokenType::END_OF_FILE), segment.text.size()));
+    LineIndex segmentLines(segment.text);
+    SymbolTable scratch;
+    ErrorHandler errors;
+    Parser parser(segment.tokens, segmentLines, scratch, errors);
+    segment.parses = parser.parsePiece(0, segment.tokens.size() - 1);
+    segment.tokens.pop_back();
+    lastEdit.statementsReparsed++;
+    if (!segment.parses) {
+        return;
+    }
+    uint32_t line = 0;
+    size_t counted = 0;
+    for (size_t i = 0; i < segment.tokens.size(); i++) {
+        const Token& token = segment.tokens[i];
+        if (token.type == TokenType::IDENTIFIER) {
+            line += static_cast<uint32_t>(
+                std::count(segment.text.begin() + counted, segment.text.begin() + token.offset, '\n'));
+            counted = token.offset;
+            bool assigns = i + 1 < segment.tokens.size() && segment.tokens[i + 1].type == TokenType::ASSIGN;
+            segment.uses.push_back(NameUse{token.lexeme, line, 0, !assigns});
+        }
+    }
+}
+
+// Adds the names of a segment that parses to the index, or takes them out. Adding also sets the
+// name id of each of its uses.
+void IncrementalAnalyzer::index(uint32_t id, bool add) {
+    Segment& segment = segments[id];
+    // Stable, so the first use of every name stays first among its uses
+    std::vector<uint32_t> byName(segment.uses.size());
+    std::iota(byName.begin(), byName.end(), 0);
+    std::stable_sort(byName.begin(), byName.end(),
+                     [&](uint32_t a, uint32_t b) { return segment.uses[a].name < segment.uses[b].name; });
+    for (size_t i = 0; i < byName.size();) {
+        const NameUse& first = segment.uses[byName[i]];
+        auto [entry, inserted] = names.try_emplace(std::string(first.name), &segments);
+        NameUses& nameUses = entry->second;
+        if (inserted) {
+            if (freeNameIds.empty()) {
+                nameUses.id = nameIds++;
+            } else {
+                nameUses.id = freeNameIds.back();
+                freeNameIds.pop_back();
+            }
+        }
+        SegmentSet& set = first.reads ? nameUses.readers : nameUses.assigners;
+        if (add) {
+            set.insert(id);
+        } else {
+            set.erase(id);
+        }
+        size_t next = i;
+        for (; next < byName.size() && segment.uses[byName[next]].name == first.name; next++) {
+            segment.uses[byName[next]].nameId = nameUses.id;
+        }
+        refreshFailing(nameUses);
+        if (nameUses.readers.empty() && nameUses.assigners.empty()) {
+            freeNameIds.push_back(nameUses.id);
+            names.erase(entry);
+        }
+        i = next;
+    }
+}
+
+void IncrementalAnalyzer::refreshFailing(NameUses& uses) {
+    uint32_t failing = NO_SEGMENT;
+    if (!uses.readers.empty() &&
+        (uses.assigners.empty() || segments[*uses.assigners.begin()].label > segments[*uses.readers.begin()].label)) {
+        failing = *uses.readers.begin();
+    }
+    if (failing != uses.failing) {
+        if (uses.failing != NO_SEGMENT) {
+            failingReaders.erase(failingReaders.find(uses.failing));
+        }
+        if (failing != NO_SEGMENT) {
+            failingReaders.insert(failing);
+        }
+        uses.failing = failing;
+    }
+}
+
+// The segment a full run stops at: the first one that does not parse, or that reads a name no
+// earlier segment assigns. NO_SEGMENT if there is none.
+uint32_t IncrementalAnalyzer::firstFailing() const {
+    uint32_t failing = failingReaders.empty() ? NO_SEGMENT : *failingReaders.begin();
+    if (totals(root).unparsable == 0) {
+        return failing;
+    }
+    uint32_t id = root;
+    while (totals(segments[id].left).unparsable > 0 || segments[id].parses) {
+        const Segment& segment = segments[id];
+        id = totals(segment.left).unparsable > 0 ? segment.left : segment.right;
+    }
+    return failing != NO_SEGMENT && segments[failing].label < segments[id].label ? failing : id;
+}
+
+// The names among those a segment uses that a full run has declared when it reaches the segment:
+// those some earlier segment uses. Their lines are left 0.
+SymbolTable IncrementalAnalyzer::declaredBefore(uint32_t id) const {
+    SymbolTable declared;
+    uint64_t label = segments[id].label;
+    auto earlier = [&](const SegmentSet& set) { return !set.empty() && segments[*set.begin()].label < label; };
+    for (const Token& token : segments[id].tokens) {
+        if (token.type != TokenType::IDENTIFIER) {
+            continue;
+        }
+        auto found = names.find(std::string(token.lexeme));
+        if (found != names.end() && (earlier(found->second.assigners) || earlier(found->second.readers))) {
+            declared.insert(token.lexeme, "dynamic", 0, 0, 0);
+        }
+    }
+    return declared;
+}
+
+void IncrementalAnalyzer::applyEdit(size_t offset, size_t length, std::string_view replacement) {
+    lastEdit = EditStats();
+    built = false;
+    symbolsBuilt = false;
+    size_t size = totals(root).bytes;
+    size_t count = totals(root).segments;
+    offset = std::min(offset, size);
+    length = std::min(length, size - offset);
+
+    // The segments [first, end) to re-lex: from the one holding the byte before the edit (the edit
+    // may change what its first line starts with) to the one holding the byte after it (whose first
+    // line the edit may join to the line before). Segments are never empty.
+    size_t first = 0;
+    size_t end = 0;
+    size_t regionStart = 0;
+    if (count > 0) {
+        first = locate(offset > 0 ? offset - 1 : 0, regionStart);
+        size_t lastStart;
+        end = locate(std::min(offset + length, size - 1), lastStart) + 1;
+    }
+    // A segment that ends with a bracket open was cut there because the next line starts a
+    // statement; once the edit changes that line the lexer may join it to that segment instead
+    if (first > 0 && segments[segmentAt(first - 1)].bracketOpen) {
+        first--;
+        regionStart -= segments[segmentAt(first)].text.size();
+    }
+
+    // Widen the region until its text starts a statement and ends with every line and bracket
+    // closed: by the segment before, or by twice as many segments after as the last time
+    std::string text;
+    std::vector<Token> tokens;
+    ErrorHandler errors;
+    size_t widenBy = 1;
+    while (true) {
+        text.clear();
+        for (size_t i = first; i < end; i++) {
+            text += segments[segmentAt(i)].text;
+        }
+        text.replace(offset - regionStart, length, replacement);
+        errors.clearErrors();
+        Lexer lexer(text, errors);
+        tokens = lexer.tokenize();
+        tokens.pop_back();
+        bool startsClean = first == 0 || (!tokens.empty() && tokens[0].offset == 0 && startsSegment(tokens, 0, text));
+        bool endsClean = end == count || (lexer.bracketDepth() == 0 && (text.empty() || text.back() == '\n'));
+        if (startsClean && endsClean) {
+            break;
+        }
+        if (!startsClean) {
+            first--;
+            regionStart -= segments[segmentAt(first)].text.size();
+        }
+        if (!endsClean) {
+            end = std::min(count, end + widenBy);
+            widenBy *= 2;
+        }
+    }
+    lastEdit.linesRelexed = static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) +
+                            (text.empty() || text.back() == '\n' ? 0 : 1);
+    lastEdit.tokensRelexed = tokens.size();
+
+    // Swap the new segments in for the old ones
+    for (size_t i = first; i < end; i++) {
+        index(segmentAt(i), false);
+    }
+    uint32_t before;
+    uint32_t region;
+    uint32_t after;
+    split(root, first, before, region);
+    split(region, end - first, region, after);
+    release(region);
+    std::vector<uint32_t> made = makeSegments(text, tokens, errors.getErrors());
+    root = before;
+    for (uint32_t id : made) {
+        root = join(root, id);
+    }
+    root = join(root, after);
+    label(first, made.size());
+    for (uint32_t id : made) {
+        index(id, true);
+    }
+}
+
+// Lays the segments out into the whole results. Without lexical errors the statement a full run
+// stops at is parsed the way a full run parses it, for its errors.
+void IncrementalAnalyzer::build() const {
+    if (built) {
+        return;
+    }
+    built = true;
+    const Totals& all = totals(root);
+    fullSource.clear();
+    fullSource.reserve(all.bytes); // Never reallocated below, so lexemes can view into it
+    fullTokens.clear();
+    fullTokens.reserve(all.tokens + 1);
+    lexicalErrors.clear();
+    syntaxErrors.clear();
+
+    for (uint32_t id : inOrder()) {
+        const Segment& segment = segments[id];
+        size_t base = fullSource.size();
+        fullSource += segment.text;
+        for (Token token : segment.tokens) {
+            token.offset += base;
+            rebase(token.lexeme, segment.text.data(), segment.text.size(), fullSource.data() + base);
+            fullTokens.push_back(token);
+        }
+        for (Error error : segment.lexicalErrors) {
+            error.offset += base;
+            lexicalErrors.push_back(error);
+        }
+    }
+    fullTokens.push_back(
+        Token(TokenType::END_OF_FILE, syntheticLexeme(TokenType::END_OF_FILE), fullSource.size()));
+    lines.reset(fullSource);
+    uint32_t failing = firstFailing();
+    if (!lexicalErrors.empty() || failing == NO_SEGMENT) {
+        return;
+    }
+
+    SymbolTable declared = declaredBefore(failing);
+    ErrorHandler errors;
+    Parser parser(fullTokens, lines, declared, errors);
+    size_t position = before(failing).tokens;
+    size_t end = position + segments[failing].tokens.size();
+    while (position < end && !errors.hasErrors()) {
+        parser.parseTopLevelStatementAt(position);
+        position = parser.tokenPosition();
+    }
+    syntaxErrors = errors.getErrors();
+}
+
+const std::string& IncrementalAnalyzer::getSource() const {
+    build();
+    return fullSource;
+}
+
+const std::vector<Token>& IncrementalAnalyzer::getTokens() const {
+    build();
+    return fullTokens;
+}
+
+const std::vector<Error>& IncrementalAnalyzer::getErrors() const {
+    build();
+    return lexicalErrors.empty() ? syntaxErrors : lexicalErrors;
+}
+
+// In a full run every identifier before the statement it stops at declares its name or adds a
+// usage, so the segments before that one are walked in order, past every subtree without uses.
+// The statement it stops at is parsed on its own, from the names declared before it.
+const SymbolTable& IncrementalAnalyzer::getSymbolTable() const {
+    if (symbolsBuilt) {
+        return symbolTable;
+    }
+    symbolsBuilt = true;
+    symbolTable.clear();
+    if (hasLexicalErrors()) {
+        return symbolTable;
+    }
+
+    uint32_t failing = firstFailing();
+    entryOfName.assign(nameIds, -1);
+    uint64_t stopAt = failing == NO_SEGMENT ? UINT64_MAX : segments[failing].label;
+    size_t line = 1; // The first line of the next segment walked
+    std::vector<uint32_t> pending;
+    uint32_t id = root;
+    while (true) {
+        // Down the left side; a subtree without uses only moves the line on
+        for (; id != NO_SEGMENT; id = segments[id].left) {
+            if (totals(id).uses == 0) {
+                line += totals(id).lines;
+                break;
+            }
+            pending.push_back(id);
+        }
+        if (pending.empty() || segments[pending.back()].label >= stopAt) {
+            break;
+        }
+        const Segment& segment = segments[pending.back()];
+        pending.pop_back();
+        for (const NameUse& use : segment.uses) {
+            int& entry = entryOfName[use.nameId];
+            if (entry < 0) {
+                symbolTable.insert(use.name, "dynamic", 0, 0, line + use.line);
+                entry = static_cast<int>(symbolTable.getEntries().size() - 1);
+            } else {
+                symbolTable.addLineOfUsage(static_cast<SymbolTable::SymTabPos>(entry), line + use.line);
+            }
+        }
+        line += segment.own.lines;
+        id = segment.right;
+    }
+    if (failing == NO_SEGMENT) {
+        return symbolTable;
+    }
+
+    const Segment& segment = segments[failing];
+    SymbolTable found = declaredBefore(failing);
+    std::vector<Token> tokens = segment.tokens;
+    tokens.push_back(Token(TokenType::END_OF_FILE, syntheticLexeme(TokenType::END_OF_FILE), segment.text.size()));
+    LineIndex segmentLines(segment.text);
+    ErrorHandler errors;
+    Parser parser(tokens, segmentLines, found, errors);
+    size_t position = 0;
+    while (position < segment.tokens.size() && !errors.hasErrors()) {
+        parser.parseTopLevelStatementAt(position);
+        position = parser.tokenPosition();
+    }
+    size_t base = before(failing).lines; // The parser counted lines from 1 in the segment
+    for (const STEntry& entry : found.getEntries()) {
+        SymbolTable::SymTabPos pos = symbolTable.search(entry.name);
+        if (pos == SymbolTable::SymTabPos::NOT_FOUND) {
+            symbolTable.insert(entry.name, entry.dataType, entry.size, entry.dimension, entry.lineOfDeclaration + base);
+            pos = static_cast<SymbolTable::SymTabPos>(symbolTable.getEntries().size() - 1);
+        }
+        for (size_t usage : entry.linesOfUsage) {
+            symbolTable.addLineOfUsage(pos, usage + base);
+        }
+    }
+    return symbolTable;
+}
+
+bool IncrementalAnalyzer::matchesFullAnalysis() const {
+    build();
+    ErrorHandler errors;
+    Lexer lexer(fullSource, errors);
+    std::vector<Token> expectedTokens = lexer.tokenize();
+    bool sameTokens = std::equal(expectedTokens.begin(), expectedTokens.end(), fullTokens.begin(), fullTokens.end(),
+        [](const Token& a, const Token& b) {
+            return a.type == b.type && a.lexeme == b.lexeme && a.offset == b.offset;
+        });
+    if (!sameTokens) {
+        return false;
+    }
+    if (errors.hasErrors() || !lexicalErrors.empty()) {
+        return errors.getErrors() == lexicalErrors;
+    }
+
+    LineIndex fullLines(fullSource);
+    SymbolTable fullTable;
+    Parser parser(expectedTokens, fullLines, fullTable, errors);
+    parser.parse();
+    const std::vector<STEntry>& expected = fullTable.getEntries();
+    const std::vector<STEntry>& actual = getSymbolTable().getEntries();
+    return errors.getErrors() == syntaxErrors &&
+           std::equal(expected.begin(), expected.end(), actual.begin(), actual.end(), [](const STEntry& a, const STEntry& b) {
+               return a.name == b.name && a.dataType == b.dataType && a.size == b.size && a.dimension == b.dimension &&
+                      a.lineOfDeclaration == b.lineOfDeclaration && a.linesOfUsage == b.linesOfUsage;
+           });
+}
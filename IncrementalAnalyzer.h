@@ -0,0 +1,172 @@
+#ifndef INCREMENTALANALYZER_H
+#define INCREMENTALANALYZER_H
+
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Token.h"
+#include "ErrorHandler.h"
+#include "LineIndex.h"
+#include "SymbolTable.h"
+
+// Keeps the tokens, errors and symbol table of one source up to date across small edits
+// (editor or watch-mode use). An edit costs time in proportion to the statements it touches, plus
+// a logarithmic term in the file's size; nothing before or after them is moved or renumbered:
+//  - The source is held as a sequence of segments: a top-level statement, which starts with a
+//    token in column 1 where no block or bracket is open (see Lexer.h), and the blank and comment
+//    lines after it. A segment owns its text, tokens and lexical errors, with offsets from its own
+//    start. Segments sit in a balanced tree that sums their bytes, so the ones an edit touches are
+//    found in logarithmic time, and carry labels that increase through the source, so two of them
+//    are put in order in constant time.
+//  - An edit re-lexes the segments it touches (and the one before, if it touches the first line of
+//    one or that one ends with a bracket the lexer gave up on, or more after, while a bracket is
+//    left open), splits the result into segments again and puts them in the tree in place of the
+//    old ones.
+//  - Each new segment is parsed on its own, once, as a piece (see Parser::parsePiece): whether a
+//    statement parses does not depend on what follows it. To the symbol table a segment that parses
+//    only matters through the names it assigns and the names it reads before assigning them. These
+//    are indexed by name, so the first statement a full run stops at (the first segment that does
+//    not parse, or that reads a name no earlier segment assigns) is known after every edit.
+//  - A segment that parses keeps its identifiers with their lines counted from its own first line,
+//    and the tree sums line breaks, so a segment's lines are found without renumbering the rest.
+// Absolute offsets and line numbers are only worked out when asked for, and kept until the next
+// edit. getSymbolTable() adds the segments' first lines to their own uses and skips every subtree
+// without one, so it costs about as much as the table it returns. getSource(), getTokens() and
+// getErrors() lay out the whole source, tokens and errors, which costs as much as a full run's
+// output. Like LineIndex, an analyzer must therefore not be read from several threads at once.
+//
+// The results always equal a from-scratch Lexer + Parser run; matchesFullAnalysis() checks that.
+class IncrementalAnalyzer {
+public:
+    // What the last applyEdit() had to redo
+    struct EditStats {
+        size_t linesRelexed = 0;
+        size_t tokensRelexed = 0;
+        size_t statementsReparsed = 0; // Segments parsed again
+    };
+
+private:
+    static const uint32_t NO_SEGMENT = UINT32_MAX;
+
+    // What a segment, or a subtree of them, holds
+    struct Totals {
+        size_t segments = 0;
+        size_t bytes = 0;
+        size_t tokens = 0;
+        size_t lexicalErrors = 0;
+        size_t unparsable = 0; // Segments that do not parse on their own
+        size_t lines = 0;      // Line breaks
+        size_t uses = 0;       // Identifiers in segments that parse
+
+        void add(const Totals& other);
+    };
+    struct NameUse {
+        std::string_view name; // Views into the segment's text
+        uint32_t line;         // Line breaks before it in the segment
+        uint32_t nameId;       // NameUses::id, set when the segment is indexed
+        bool reads;            // Not followed by '='
+    };
+    struct Segment {
+        // Tree links: in source order, with every segment's priority above its children's. First,
+        // with the subtree totals, so a walk down the tree reads one cache line per segment.
+        uint32_t left = NO_SEGMENT;
+        uint32_t right = NO_SEGMENT;
+        uint32_t priority = 0;
+        bool parses = false;
+        bool bracketOpen = false; // Ends with a bracket the lexer gave up on (see Lexer.h)
+        Totals subtree;
+        uint64_t label = 0; // Greater than the label of every segment before it
+        Totals own;
+        std::string text;
+        std::vector<Token> tokens;        // Offsets from the start of text; END_OF_FILE is not kept
+        std::vector<Error> lexicalErrors; // Offsets from the start of text too
+        std::vector<NameUse> uses;        // If it parses: its identifiers, in source order
+    };
+    struct BySourceOrder {
+        const std::deque<Segment>* segments;
+        bool operator()(uint32_t a, uint32_t b) const { return (*segments)[a].label < (*segments)[b].label; }
+    };
+    using SegmentSet = std::set<uint32_t, BySourceOrder>;
+    // The segments that parse and use a name: those whose first use of it assigns it, and those
+    // whose first use reads it
+    struct NameUses {
+        SegmentSet assigners;
+        SegmentSet readers;
+        uint32_t failing = NO_SEGMENT; // The first reader, unless an assigner comes before it
+        uint32_t id = 0;               // Small and reused once the name is gone
+
+        explicit NameUses(const std::deque<Segment>* segments)
+            : assigners(BySourceOrder{segments}), readers(BySourceOrder{segments}) {}
+    };
+
+    std::deque<Segment> segments; // Never moves a segment, so token lexemes can view into its text
+    std::vector<uint32_t> freeSegments;
+    uint32_t root;
+    std::mt19937 random; // Tree priorities
+    std::unordered_map<std::string, NameUses> names;
+    uint32_t nameIds; // Name ids handed out so far
+    std::vector<uint32_t> freeNameIds;
+    std::multiset<uint32_t, BySourceOrder> failingReaders; // Every NameUses::failing that is set
+    EditStats lastEdit;
+
+    // The whole results, built on demand (see the class comment)
+    mutable bool built;
+    mutable bool symbolsBuilt;
+    mutable std::string fullSource;
+    mutable std::vector<Token> fullTokens;
+    mutable std::vector<Error> lexicalErrors;
+    mutable std::vector<Error> syntaxErrors;
+    mutable LineIndex lines;
+    mutable SymbolTable symbolTable;
+    mutable std::vector<int> entryOfName; // By name id while the table is filled; -1 until declared
+
+    const Totals& totals(uint32_t tree) const;
+    Totals before(uint32_t id) const;
+    void update(uint32_t id);
+    uint32_t join(uint32_t left, uint32_t right);
+    void split(uint32_t tree, size_t count, uint32_t& left, uint32_t& right);
+    uint32_t segmentAt(size_t index) const;
+    size_t locate(size_t offset, size_t& start) const; // Index of the segment holding a byte
+    std::vector<uint32_t> inOrder() const;
+    void label(size_t first, size_t count);
+    uint32_t newSegment();
+    void release(uint32_t tree);
+
+    std::vector<uint32_t> makeSegments(const std::string& text, const std::vector<Token>& tokens,
+                                       const std::vector<Error>& errors);
+    void parse(Segment& segment);
+    void index(uint32_t id, bool add);
+    void refreshFailing(NameUses& uses);
+    uint32_t firstFailing() const;
+    SymbolTable declaredBefore(uint32_t id) const;
+    void build() const;
+
+public:
+    explicit IncrementalAnalyzer(std::string code);
+    // The name index points into the analyzer
+    IncrementalAnalyzer(const IncrementalAnalyzer&) = delete;
+    IncrementalAnalyzer& operator=(const IncrementalAnalyzer&) = delete;
+
+    // Replaces length bytes at offset with replacement and brings all results up to date
+    void applyEdit(size_t offset, size_t length, std::string_view replacement);
+
+    const std::string& getSource() const;
+    const std::vector<Token>& getTokens() const;
+    bool hasLexicalErrors() const { return totals(root).lexicalErrors > 0; }
+    // The lexical errors if there are any (the parser does not run then), else the syntax errors
+    const std::vector<Error>& getErrors() const;
+    // Only meaningful without lexical errors, as in a full run. Does not lay out the source.
+    const SymbolTable& getSymbolTable() const;
+    const EditStats& getLastEditStats() const { return lastEdit; }
+
+    // Re-analyzes the current source from scratch and compares every token, error and symbol
+    bool matchesFullAnalysis() const;
+};
+
+#endif
@@ -0,0 +1,400 @@
+// implementation of Interpreter.h
+
+#include "Interpreter.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#if defined(__GNUC__) && !defined(INTERPRETER_NO_COMPUTED_GOTO)
+#define INTERPRETER_COMPUTED_GOTO
+#endif
+
+namespace {
+
+const size_t OUTPUT_FLUSH_BYTES = 1 << 16;
+const size_t STRING_COLLECT_BYTES = 1 << 20; // Least stringBytes at which collectStrings runs
+
+} // namespace
+
+Interpreter::Interpreter(const BytecodeProgram& program, std::istream& in, std::ostream& out)
+    : program(program), in(in), out(out) {}
+
+void Interpreter::flushOutput() {
+    out.write(output.data(), static_cast<std::streamsize>(output.size()));
+    out.flush();
+    output.clear();
+}
+
+bool Interpreter::fail(const Instruction* at, const std::string& message) {
+    error.message = message;
+    error.line = program.lines[static_cast<size_t>(at - program.code.data())];
+    return false;
+}
+
+// Only variables can be unbound: assigned in a branch that did not run
+bool Interpreter::checkBound(const Instruction* at, uint32_t reg) {
+    if (registers[reg].type != ValueType::UNBOUND) {
+        return true;
+    }
+    std::string name = reg < program.firstConstant() ? program.variableNames[reg] : "?";
+    return fail(at, "NameError: name '" + name + "' is not defined");
+}
+
+void Interpreter::addedString() {
+    stringBytes += strings.back().size() + sizeof(std::string);
+    if (stringBytes >= collectAt) {
+        collectStrings();
+    }
+}
+
+// Moves the strings a register refers to into a new deque and drops the rest. A string short
+// enough to be stored inside the std::string object moves with it, so every register is repointed.
+void Interpreter::collectStrings() {
+    std::unordered_map<const char*, size_t> index; // data() of each string to its position
+    index.reserve(strings.size());
+    for (size_t i = 0; i < strings.size(); ++i) {
+        index.emplace(strings[i].data(), i);
+    }
+    std::vector<const char*> moved(strings.size(), nullptr); // New data() of the kept strings
+    std::deque<std::string> kept;
+    stringBytes = 0;
+    for (Value& value : registers) {
+        if (value.type != ValueType::STR) {
+            continue;
+        }
+        auto found = index.find(value.s);
+        if (found == index.end()) {
+            continue; // A constant
+        }
+        const char*& data = moved[found->second];
+        if (data == nullptr) {
+            kept.push_back(std::move(strings[found->second]));
+            data = kept.back().data();
+            stringBytes += kept.back().size() + sizeof(std::string);
+        }
+        value.s = data;
+    }
+    strings.swap(kept);
+    collectAt = std::max(STRING_COLLECT_BYTES, 2 * stringBytes);
+}
+
+bool Interpreter::binarySlow(const Instruction* at) {
+    if (!checkBound(at, at->b) || !checkBound(at, at->c)) {
+        return false;
+    }
+    Value result;
+    std::string message;
+    Opcode op = at->op();
+    size_t stored = strings.size();
+    if (op >= Opcode::EQ && op <= Opcode::GE) {
+        bool truth;
+        if (!applyComparison(op, registers[at->b], registers[at->c], truth, message)) {
+            return fail(at, message);
+        }
+        result = Value::fromBool(truth);
+    } else if (!applyBinary(op, registers[at->b], registers[at->c], strings, result, message)) {
+        return fail(at, message);
+    }
+    registers[at->a()] = result;
+    if (strings.size() != stored) {
+        addedString();
+    }
+    return true;
+}
+
+bool Interpreter::unarySlow(const Instruction* at) {
+    if (!checkBound(at, at->b)) {
+        return false;
+    }
+    Value result;
+    std::string message;
+    if (!applyUnary(at->op(), registers[at->b], result, message)) {
+        return fail(at, message);
+    }
+    registers[at->a()] = result;
+    return true;
+}
+
+// comparison is one of EQ..GE
+bool Interpreter::compareSlow(const Instruction* at, Opcode comparison, bool& result) {
+    if (!checkBound(at, at->b) || !checkBound(at, at->c)) {
+        return false;
+    }
+    std::string message;
+    return applyComparison(comparison, registers[at->b], registers[at->c], result, message) || fail(at, message);
+}
+
+bool Interpreter::truthSlow(const Instruction* at, bool& result) {
+    if (!checkBound(at, at->b)) {
+        return false;
+    }
+    result = isTruthy(registers[at->b]);
+    return true;
+}
+
+bool Interpreter::print(const Instruction* at) {
+    if (!checkBound(at, at->b)) {
+        return false;
+    }
+    appendValue(output, registers[at->b]);
+    output += '\n';
+    if (output.size() >= OUTPUT_FLUSH_BYTES) {
+        flushOutput();
+    }
+    return true;
+}
+
+bool Interpreter::input(const Instruction* at) {
+    if (at->b != NO_REGISTER) {
+        if (!checkBound(at, at->b)) {
+            return false;
+        }
+        appendValue(output, registers[at->b]);
+    }
+    flushOutput(); // The prompt and everything before it must show before blocking on input
+    std::string line;
+    if (!std::getline(in, line)) {
+        return fail(at, "EOFError: EOF when reading a line");
+    }
+    strings.push_back(std::move(line));
+    registers[at->a()] = Value::fromString(strings.back());
+    addedString();
+    return true;
+}
+
+bool Interpreter::run() {
+    registers.assign(program.registerCount, Value());
+    std::copy(program.constants.begin(), program.constants.end(),
+              registers.begin() + static_cast<std::ptrdiff_t>(program.firstConstant()));
+    strings.clear();
+    stringBytes = 0;
+    collectAt = STRING_COLLECT_BYTES;
+    output.clear();
+    error = ExecutionError();
+    if (program.code.empty()) {
+        return true;
+    }
+
+    const Instruction* const code = program.code.data();
+    const Instruction* pc = code;
+    Value* const r = registers.data();
+    bool ok = true;
+
+#ifdef INTERPRETER_COMPUTED_GOTO
+    static void* const handlers[] = {
+#define BYTECODE_LABEL(name) &&op_##name,
+        BYTECODE_OPCODES(BYTECODE_LABEL)
+#undef BYTECODE_LABEL
+    };
+#define HANDLER(name) op_##name:
+#define DISPATCH() goto *handlers[pc->word & 0xFF]
+    DISPATCH();
+#else
+#define HANDLER(name) case Opcode::name:
+#define DISPATCH() continue
+    for (;;) {
+        switch (pc->op()) {
+#endif
+
+// Handlers with an int/int (and float/float) fast path; everything else goes to binarySlow
+#define ARITHMETIC(name, intResult, floatResult)                                        \
+    HANDLER(name) {                                                                     \
+        const Value& x = r[pc->b];                                                      \
+        const Value& y = r[pc->c];                                                      \
+        if (x.type == ValueType::INT && y.type == ValueType::INT) {                     \
+            r[pc->a()] = Value::fromInt(intResult);                                     \
+        } else if (x.type == ValueType::FLOAT && y.type == ValueType::FLOAT) {          \
+            r[pc->a()] = Value::fromFloat(floatResult);                                 \
+        } else if (!binarySlow(pc)) {                                                   \
+            goto failed;                                                                \
+        }                                                                               \
+        ++pc;                                                                           \
+        DISPATCH();                                                                     \
+    }
+
+#define COMPARE(x, y, comparison, OP)                                                   \
+    bool result;                                                                        \
+    if (x.type == ValueType::INT && y.type == ValueType::INT) {                         \
+        result = x.i OP y.i;                                                            \
+    } else if (x.type == ValueType::FLOAT && y.type == ValueType::FLOAT) {              \
+        result = x.f OP y.f;                                                            \
+    } else if (!compareSlow(pc, Opcode::comparison, result)) {                          \
+        goto failed;                                                                    \
+    }
+
+#define COMPARISON(name, OP)                                                            \
+    HANDLER(name) {                                                                     \
+        const Value& x = r[pc->b];                                                      \
+        const Value& y = r[pc->c];                                                      \
+        COMPARE(x, y, name, OP)                                                         \
+        r[pc->a()] = Value::fromBool(result);                                           \
+        ++pc;                                                                           \
+        DISPATCH();                                                                     \
+    }
+
+#define COMPARE_AND_BRANCH(name, comparison, OP, when)                                  \
+    HANDLER(name) {                                                                     \
+        const Value& x = r[pc->b];                                                      \
+        const Value& y = r[pc->c];                                                      \
+        COMPARE(x, y, comparison, OP)                                                   \
+        pc = result == when ? code + pc->a() : pc + 1;                                  \
+        DISPATCH();                                                                     \
+    }
+
+    HANDLER(MOVE) {
+        const Value& x = r[pc->b];
+        if (x.type == ValueType::UNBOUND) {
+            checkBound(pc, pc->b);
+            goto failed;
+        }
+        r[pc->a()] = x;
+        ++pc;
+        DISPATCH();
+    }
+
+    ARITHMETIC(ADD, wrapAdd(x.i, y.i), x.f + y.f)
+    ARITHMETIC(SUB, wrapSub(x.i, y.i), x.f - y.f)
+    ARITHMETIC(MUL, wrapMul(x.i, y.i), x.f * y.f)
+
+    HANDLER(DIV) {
+        const Value& x = r[pc->b];
+        const Value& y = r[pc->c];
+        if (x.type == ValueType::INT && y.type == ValueType::INT && y.i != 0) {
+            r[pc->a()] = Value::fromFloat(static_cast<double>(x.i) / static_cast<double>(y.i));
+        } else if (x.type == ValueType::FLOAT && y.type == ValueType::FLOAT && y.f != 0) {
+            r[pc->a()] = Value::fromFloat(x.f / y.f);
+        } else if (!binarySlow(pc)) {
+            goto failed;
+        }
+        ++pc;
+        DISPATCH();
+    }
+
+    HANDLER(MOD) {
+        const Value& x = r[pc->b];
+        const Value& y = r[pc->c];
+        if (x.type == ValueType::INT && y.type == ValueType::INT && y.i > 0) {
+            int64_t m = x.i % y.i;
+            r[pc->a()] = Value::fromInt(m < 0 ? m + y.i : m);
+        } else if (!binarySlow(pc)) {
+            goto failed;
+        }
+        ++pc;
+        DISPATCH();
+    }
+
+    COMPARISON(EQ, ==)
+    COMPARISON(NE, !=)
+    COMPARISON(LT, <)
+    COMPARISON(LE, <=)
+    COMPARISON(GT, >)
+    COMPARISON(GE, >=)
+
+    HANDLER(NEG) {
+        const Value& x = r[pc->b];
+        if (x.type == ValueType::INT) {
+            r[pc->a()] = Value::fromInt(wrapSub(0, x.i));
+        } else if (!unarySlow(pc)) {
+            goto failed;
+        }
+        ++pc;
+        DISPATCH();
+    }
+
+    HANDLER(POS) {
+        if (!unarySlow(pc)) {
+            goto failed;
+        }
+        ++pc;
+        DISPATCH();
+    }
+
+    HANDLER(NOT) {
+        const Value& x = r[pc->b];
+        if (x.type == ValueType::BOOL) {
+            r[pc->a()] = Value::fromBool(x.i == 0);
+        } else if (!unarySlow(pc)) {
+            goto failed;
+        }
+        ++pc;
+        DISPATCH();
+    }
+
+    HANDLER(INPUT) {
+        if (!input(pc)) {
+            goto failed;
+        }
+        ++pc;
+        DISPATCH();
+    }
+
+    HANDLER(PRINT) {
+        if (!print(pc)) {
+            goto failed;
+        }
+        ++pc;
+        DISPATCH();
+    }
+
+    HANDLER(JUMP) {
+        pc = code + pc->a();
+        DISPATCH();
+    }
+
+    HANDLER(JUMP_IF_TRUE) {
+        const Value& x = r[pc->b];
+        bool truth;
+        if (x.type == ValueType::BOOL) {
+            truth = x.i != 0;
+        } else if (!truthSlow(pc, truth)) {
+            goto failed;
+        }
+        pc = truth ? code + pc->a() : pc + 1;
+        DISPATCH();
+    }
+
+    HANDLER(JUMP_IF_FALSE) {
+        const Value& x = r[pc->b];
+        bool truth;
+        if (x.type == ValueType::BOOL) {
+            truth = x.i != 0;
+        } else if (!truthSlow(pc, truth)) {
+            goto failed;
+        }
+        pc = truth ? pc + 1 : code + pc->a();
+        DISPATCH();
+    }
+
+    COMPARE_AND_BRANCH(JUMP_IF_EQ, EQ, ==, true)
+    COMPARE_AND_BRANCH(JUMP_IF_NE, NE, !=, true)
+    COMPARE_AND_BRANCH(JUMP_IF_LT, LT, <, true)
+    COMPARE_AND_BRANCH(JUMP_IF_LE, LE, <=, true)
+    COMPARE_AND_BRANCH(JUMP_IF_GT, GT, >, true)
+    COMPARE_AND_BRANCH(JUMP_IF_GE, GE, >=, true)
+    COMPARE_AND_BRANCH(JUMP_IF_NOT_LT, LT, <, false)
+    COMPARE_AND_BRANCH(JUMP_IF_NOT_LE, LE, <=, false)
+    COMPARE_AND_BRANCH(JUMP_IF_NOT_GT, GT, >, false)
+    COMPARE_AND_BRANCH(JUMP_IF_NOT_GE, GE, >=, false)
+
+    HANDLER(HALT) {
+        goto finished;
+    }
+
+#ifndef INTERPRETER_COMPUTED_GOTO
+        }
+    }
+#endif
+
+#undef ARITHMETIC
+#undef COMPARE
+#undef COMPARISON
+#undef COMPARE_AND_BRANCH
+#undef HANDLER
+#undef DISPATCH
+
+failed:
+    ok = false;
+finished:
+    flushOutput();
+    return ok;
+}
@@ -0,0 +1,58 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Bytecode.h"
+
+// Runs a BytecodeProgram. The dispatch loop jumps straight from one handler to the next through
+// a table of label addresses (computed goto) when the compiler supports it, and falls back to a
+// switch otherwise or when built with -DINTERPRETER_NO_COMPUTED_GOTO. Each handler tries the
+// int/int case first and leaves every other type combination to out-of-line code, which uses
+// the operator semantics of Bytecode.h.
+// Strings built at run time (concatenation, input()) are reclaimed once no register refers to
+// them: when they add up to twice what was still referenced after the last collection. print()
+// output is buffered and written when input() is called, when the buffer fills up, and at the end.
+class Interpreter {
+private:
+    const BytecodeProgram& program;
+    std::istream& in;
+    std::ostream& out;
+    std::vector<Value> registers;
+    std::deque<std::string> strings; // Storage of the STR values made at run time
+    size_t stringBytes = 0;          // Size of strings, counting each std::string object
+    size_t collectAt = 0;            // stringBytes at which collectStrings runs
+    std::string output;              // Buffered print() text
+    ExecutionError error;
+
+    void flushOutput();
+    bool fail(const Instruction* at, const std::string& message);
+    bool checkBound(const Instruction* at, uint32_t reg);
+    // Counts the string just stored for a register, collecting when the strings add up
+    void addedString();
+    void collectStrings();
+
+    // The cases the handlers do not do inline. Each returns false after fail().
+    bool binarySlow(const Instruction* at);
+    bool unarySlow(const Instruction* at);
+    bool compareSlow(const Instruction* at, Opcode comparison, bool& result);
+    bool truthSlow(const Instruction* at, bool& result);
+    bool print(const Instruction* at);
+    bool input(const Instruction* at);
+
+public:
+    Interpreter(const BytecodeProgram& program, std::istream& in = std::cin, std::ostream& out = std::cout);
+
+    // Runs the program from the start with fresh registers. False on a run-time error (see
+    // getError); the output printed up to the error is still written.
+    bool run();
+    const ExecutionError& getError() const { return error; }
+
+    // A variable's value after run(), by SymbolTable position
+    const Value& variable(size_t position) const { return registers[position]; }
+};
+
+#endif
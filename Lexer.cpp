@@ -1,48 +1,14 @@
 #include "Lexer.h"
-#include <cctype> // For isalpha, isdigit, isalnum
+#include "LexerTables.h"
+#include "ScanKernels.h"
+#include "Stats.h"
 #include <iomanip>
+#include <iostream>
 
 // Constructor
-Lexer::Lexer(const std::string& code, ErrorHandler& handler)
-    : sourceCode(code), currentIndex(0), currentLine(1), currentCol(1), errorHandler(handler) {
-    // Initialize keywords
-    keywords["if"] = TokenType::IF;
-    keywords["else"] = TokenType::ELSE;
-    keywords["elif"] = TokenType::ELIF; 
-    keywords["while"] = TokenType::WHILE;
-    keywords["for"] = TokenType::FOR;
-    keywords["print"] = TokenType::PRINT;
-    keywords["input"] = TokenType::INPUT;
-    keywords["True"] = TokenType::BOOLEAN_LITERAL;
-    keywords["False"] = TokenType::BOOLEAN_LITERAL;
-    keywords["and"] = TokenType::AND;
-    keywords["or"] = TokenType::OR;
-    keywords["not"] = TokenType::NOT;
-
-    // Initialize single character tokens
-    singleCharTokens['+'] = TokenType::PLUS;
-    singleCharTokens['-'] = TokenType::MINUS;
-    singleCharTokens['*'] = TokenType::MULTIPLY;
-    singleCharTokens['/'] = TokenType::DIVIDE;
-    singleCharTokens['%'] = TokenType::MODULO;
-    singleCharTokens['('] = TokenType::LPAREN;
-    singleCharTokens[')'] = TokenType::RPAREN;
-    singleCharTokens['['] = TokenType::LBRACKET;
-    singleCharTokens[']'] = TokenType::RBRACKET;
-    singleCharTokens[','] = TokenType::COMMA;
-    singleCharTokens[':'] = TokenType::COLON;
-    singleCharTokens['.'] = TokenType::DOT;
-    singleCharTokens['='] = TokenType::ASSIGN;      
-    singleCharTokens['<'] = TokenType::LESS_THAN;  
-    singleCharTokens['>'] = TokenType::GREATER_THAN;
-    // blocks not yet added, {}, need further logic constraints
-
-    // Initialize multi-character tokens
-    multiCharTokens["=="] = TokenType::EQUAL_EQUAL;
-    multiCharTokens["!="] = TokenType::NOT_EQUAL;
-    multiCharTokens["<="] = TokenType::LESS_EQUAL;
-    multiCharTokens[">="] = TokenType::GREATER_EQUAL;
-}
+Lexer::Lexer(std::string_view code, ErrorHandler& handler)
+    : sourceCode(code), currentIndex(0), errorHandler(handler), indents{0}, pendingDedents(0), lineStart(0),
+      atLineStart(true), openBrackets(0) {}
 
 // Looks at the next character without advancing
 char Lexer::peek() {
@@ -52,218 +18,310 @@ char Lexer::peek() {
     return sourceCode[currentIndex];
 }
 
+// Looks one character past peek() without advancing
+char Lexer::peekNext() {
+    if (currentIndex + 1 >= sourceCode.length()) {
+        return '\0';
+    }
+    return sourceCode[currentIndex + 1];
+}
+
 // Advances the current index and returns the character
 char Lexer::advance() {
     if (currentIndex >= sourceCode.length()) {
         return '\0';
     }
-    char c = sourceCode[currentIndex];
-    currentIndex++;
-    currentCol++;
-    return c;
+    return sourceCode[currentIndex++];
+}
+
+// Moves to a position found by one of the ScanKernels scanners
+void Lexer::advanceTo(const char* position) {
+    currentIndex = static_cast<size_t>(position - sourceCode.data());
+}
+
+// Whether the next line with a token after the '\n' at newline starts a statement in column 1: with
+// 'if', 'while', 'for', 'elif', 'else' or 'print', or with a name and a single '='. Blank and
+// comment lines are passed over.
+bool Lexer::nextLineStartsStatement(size_t newline) const {
+    const char* end = sourceEnd();
+    const char* line = sourceCode.data() + newline + 1;
+    while (line < end) {
+        const char* first = ScanKernels::skipBlanks(line, end);
+        if (first < end && *first == '#') {
+            first = ScanKernels::findLineEnd(first, end);
+        }
+        if (first == end) {
+            return false;
+        }
+        if (*first == '\n') {
+            line = first + 1;
+            continue;
+        }
+        if (first != line || !LexerTables::hasFlag(*first, LexerTables::CHAR_IDENT_START)) {
+            return false;
+        }
+        const char* wordEnd = ScanKernels::skipIdentifier(first, end);
+        switch (LexerTables::lookupKeyword(std::string_view(first, static_cast<size_t>(wordEnd - first)))) {
+            case TokenType::IF:
+            case TokenType::WHILE:
+            case TokenType::FOR:
+            case TokenType::ELIF:
+            case TokenType::ELSE:
+            case TokenType::PRINT:
+                return true;
+            case TokenType::IDENTIFIER: {
+                const char* next = ScanKernels::skipBlanks(wordEnd, end);
+                return next < end && *next == '=' && (next + 1 == end || next[1] != '=');
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
 }
 
-// Skips whitespace characters and comments
+// Skips whitespace characters and comments, and the newlines of lines without tokens or inside
+// brackets. A bracket still open when the next line starts a statement is given up on, so the
+// line ends at its own newline and the parser reports the missing bracket there.
 void Lexer::skipWhitespace() {
     while (currentIndex < sourceCode.length()) {
         char c = peek();
-        if (c == ' ' || c == '\t' || c == '\r') {
+        if (LexerTables::hasFlag(c, LexerTables::CHAR_BLANK)) {
             advance();
+            // Single spaces between tokens are the common case; only longer runs use the scanner
+            if (LexerTables::hasFlag(peek(), LexerTables::CHAR_BLANK)) {
+                advanceTo(ScanKernels::skipBlanks(sourceCode.data() + currentIndex, sourceEnd()));
+            }
         } else if (c == '\n') {
-            advance();
-            currentLine++;
-            currentCol = 1;
-        } else if (c == '#') { // Python comments
-            while (currentIndex < sourceCode.length() && peek() != '\n' && peek() != '\0') {
-                advance();
+            if (!atLineStart && (openBrackets == 0 || nextLineStartsStatement(currentIndex))) {
+                openBrackets = 0;
+                break; // Ends the line; scanToken() returns it as a NEWLINE
             }
+            advance();
+            lineStart = currentIndex;
+        } else if (c == '#') { // Python comments, skipped up to (not including) the newline
+            advanceTo(ScanKernels::findLineEnd(sourceCode.data() + currentIndex, sourceEnd()));
         } else {
             break;
         }
     }
 }
 
+// Columns of indentation before currentIndex on the current line
+size_t Lexer::indentationWidth() const {
+    size_t width = 0;
+    for (size_t i = lineStart; i < currentIndex; ++i) {
+        width = sourceCode[i] == '\t' ? (width / 8 + 1) * 8 : width + 1;
+    }
+    return width;
+}
+
+Token Lexer::layoutToken(TokenType type, size_t offset) const {
+    return Token(type, syntheticLexeme(type), offset);
+}
+
+// Returns a view of the source from start up to the current index (no copy is made)
+std::string_view Lexer::lexemeFrom(size_t start) const {
+    return sourceCode.substr(start, currentIndex - start);
+}
+
 // Identifies identifiers or keywords
 Token Lexer::identifyIdentifierOrKeyword() {
-    std::string lexeme;
-    int startCol = currentCol;
-    while (isalnum(peek()) || peek() == '_') { // Python identifiers can contain letters, numbers, and underscores
-        lexeme += advance();
-    }
+    size_t start = currentIndex;
+    // Python identifiers can contain letters, numbers, and underscores
+    advanceTo(ScanKernels::skipIdentifier(sourceCode.data() + currentIndex, sourceEnd()));
+    std::string_view lexeme = lexemeFrom(start);
 
-    // Check if it's a keyword
-    if (keywords.count(lexeme)) {
-        return Token(keywords[lexeme], lexeme, currentLine, startCol);
-    } else {
-        return Token(TokenType::IDENTIFIER, lexeme, currentLine, startCol);
-    }
+    // Keywords come back as their own type, anything else as IDENTIFIER
+    return Token(LexerTables::lookupKeyword(lexeme), lexeme, start);
 }
 
 // Identifies numbers (integers and floats)
 Token Lexer::identifyNumber() {
-    std::string lexeme;
-    int startCol = currentCol;
+    size_t start = currentIndex;
     bool isFloat = false;
 
-    while (isdigit(peek())) {
-        lexeme += advance();
-    }
+    advanceTo(ScanKernels::skipDigits(sourceCode.data() + currentIndex, sourceEnd()));
 
-    if (peek() == '.' && isdigit(sourceCode[currentIndex + 1])) { // Check for fractional part
+    if (peek() == '.' && LexerTables::hasFlag(peekNext(), LexerTables::CHAR_DIGIT)) { // Check for fractional part
         isFloat = true;
-        lexeme += advance(); // Consume '.'
-        while (isdigit(peek())) {
-            lexeme += advance();
-        }
+        advance(); // Consume '.'
+        advanceTo(ScanKernels::skipDigits(sourceCode.data() + currentIndex, sourceEnd()));
     }
 
     if (isFloat) {
-        return Token(TokenType::FLOAT_LITERAL, lexeme, currentLine, startCol);
+        return Token(TokenType::FLOAT_LITERAL, lexemeFrom(start), start);
     } else {
-        return Token(TokenType::INTEGER_LITERAL, lexeme, currentLine, startCol);
+        return Token(TokenType::INTEGER_LITERAL, lexemeFrom(start), start);
     }
 }
 
 // Identifies strings (enclosed in single or double quotes)
 Token Lexer::identifyString() {
+    size_t quote = currentIndex; // The token starts at the quote
     char quoteChar = advance(); // Consume the opening quote (' or ")
-    std::string lexeme;
-    int startCol = currentCol - 1; // Start column of the quote
+    size_t start = currentIndex; // The lexeme excludes the quotes
 
-    while (peek() != quoteChar && peek() != '\0' && peek() != '\n') {
-        lexeme += advance();
-    }
+    advanceTo(ScanKernels::findStringEnd(sourceCode.data() + currentIndex, sourceEnd(), quoteChar));
+    std::string_view lexeme = lexemeFrom(start);
 
     if (peek() == '\0' || peek() == '\n') {
-        errorHandler.reportError("Unterminated string literal.", currentLine, startCol, "Lexical");
-        return Token(TokenType::UNKNOWN, lexeme, currentLine, startCol); // Return an error token
+        errorHandler.reportError(ErrorKind::LEXICAL, ErrorCode::UNTERMINATED_STRING, "", quote);
+        return Token(TokenType::UNKNOWN, lexeme, quote); // Return an error token
     } else {
         advance(); // Consume the closing quote
-        return Token(TokenType::STRING_LITERAL, lexeme, currentLine, startCol);
+        return Token(TokenType::STRING_LITERAL, lexeme, quote);
     }
 }
 
 // Identifies operators (single and multi-character)
 Token Lexer::identifyOperator() {
+    size_t start = currentIndex;
     char c = advance();
-    std::string lexeme(1, c);
-    int startCol = currentCol - 1; // Column where the operator starts
 
     // Check for multi-character operators first (since we need to rule out multi-character first)
     // Compare current to next character
     if (c == '=' && peek() == '=') {
-        lexeme += advance(); return Token(TokenType::EQUAL_EQUAL, lexeme, currentLine, startCol);
+        advance(); return Token(TokenType::EQUAL_EQUAL, lexemeFrom(start), start);
     } else if (c == '!' && peek() == '=') {
-        lexeme += advance(); return Token(TokenType::NOT_EQUAL, lexeme, currentLine, startCol);
+        advance(); return Token(TokenType::NOT_EQUAL, lexemeFrom(start), start);
     } else if (c == '<' && peek() == '=') {
-        lexeme += advance(); return Token(TokenType::LESS_EQUAL, lexeme, currentLine, startCol);
+        advance(); return Token(TokenType::LESS_EQUAL, lexemeFrom(start), start);
     } else if (c == '>' && peek() == '=') {
-        lexeme += advance(); return Token(TokenType::GREATER_EQUAL, lexeme, currentLine, startCol);
+        advance(); return Token(TokenType::GREATER_EQUAL, lexemeFrom(start), start);
     }
 
     // Check for single character tokens if it wasn't a multi-character operator
-    if (singleCharTokens.count(c)) {
-        return Token(singleCharTokens[c], lexeme, currentLine, startCol);
+    TokenType single = LexerTables::info(c).singleToken;
+    if (single == TokenType::LPAREN || single == TokenType::LBRACKET) {
+        openBrackets++;
+    } else if ((single == TokenType::RPAREN || single == TokenType::RBRACKET) && openBrackets > 0) {
+        openBrackets--; // A stray closing bracket is the parser's to report; it joins nothing
+    }
+    if (single != TokenType::UNKNOWN) {
+        return Token(single, lexemeFrom(start), start);
     }
 
     // If it's none of above, then it's an unknown character.
-    errorHandler.reportError("Unknown character: '" + std::string(1, c) + "'", currentLine, startCol, "Lexical");
-    return Token(TokenType::UNKNOWN, lexeme, currentLine, startCol);
+    errorHandler.reportError(ErrorKind::LEXICAL, ErrorCode::UNKNOWN_CHARACTER, lexemeFrom(start), start);
+    return Token(TokenType::UNKNOWN, lexemeFrom(start), start);
 }
 
-// Main tokenization function
-std::vector<Token> Lexer::tokenize() {
-    std::vector<Token> tokens;
-    while (currentIndex < sourceCode.length()) {
-        skipWhitespace();
+// Lexes one token (see next())
+Token Lexer::scanToken() {
+    if (pendingDedents > 0) {
+        pendingDedents--;
+        return layoutToken(TokenType::DEDENT, currentIndex);
+    }
+    skipWhitespace();
 
-        if (currentIndex >= sourceCode.length()) {
-            break; // Reached end after skipping whitespace
+    if (currentIndex >= sourceCode.length()) {
+        // Close the last line and every block still open
+        if (!atLineStart) {
+            atLineStart = true;
+            return layoutToken(TokenType::NEWLINE, currentIndex);
+        }
+        if (indents.size() > 1) {
+            indents.pop_back();
+            return layoutToken(TokenType::DEDENT, currentIndex);
         }
+        return layoutToken(TokenType::END_OF_FILE, currentIndex); // EOF (end of file) token
+    }
 
-        char c = peek();
-        Token token(TokenType::UNKNOWN, "", currentLine, currentCol); // Default empty token
-
-        if (isalpha(c) || c == '_') {
-            token = identifyIdentifierOrKeyword();
-        } else if (isdigit(c)) {
-            token = identifyNumber();
-        } else if (c == '\'' || c == '"') {
-            token = identifyString();
-        } else if (singleCharTokens.count(c) || c == '=' || c == '!' || c == '<' || c == '>') { // Check for operators
-            token = identifyOperator();
-        } else {
-            errorHandler.reportError("Unexpected character: '" + std::string(1, c) + "'", currentLine, currentCol, "Lexical");
-            advance(); // Consume the unknown character to avoid infinite loop
+    char c = peek();
+    if (c == '\n') { // skipWhitespace() only stops here after a token
+        size_t newline = currentIndex;
+        advance();
+        lineStart = currentIndex;
+        atLineStart = true;
+        return layoutToken(TokenType::NEWLINE, newline);
+    }
+    if (atLineStart) {
+        atLineStart = false;
+        size_t width = indentationWidth();
+        if (width > indents.back()) {
+            indents.push_back(width);
+            return layoutToken(TokenType::INDENT, currentIndex);
+        }
+        if (width < indents.back()) {
+            while (indents.back() > width) {
+                indents.pop_back();
+                pendingDedents++;
+            }
+            if (indents.back() != width) {
+                // Carry on as if the line were indented like the block it returns to
+                errorHandler.reportError(ErrorKind::LEXICAL, ErrorCode::INCONSISTENT_DEDENT, "", currentIndex);
+            }
+            pendingDedents--;
+            return layoutToken(TokenType::DEDENT, currentIndex);
         }
-        tokens.push_back(token);
     }
 
-    tokens.emplace_back(TokenType::END_OF_FILE, "EOF", currentLine, currentCol); // Add EOF (end of file) token
+    uint8_t flags = LexerTables::info(c).flags;
+    if (flags & LexerTables::CHAR_IDENT_START) {
+        return identifyIdentifierOrKeyword();
+    } else if (flags & LexerTables::CHAR_DIGIT) {
+        return identifyNumber();
+    } else if (flags & LexerTables::CHAR_QUOTE) {
+        return identifyString();
+    } else if (flags & LexerTables::CHAR_OPERATOR) { // Check for operators
+        return identifyOperator();
+    }
+
+    Token token(TokenType::UNKNOWN, "", currentIndex); // Empty error token
+    errorHandler.reportError(ErrorKind::LEXICAL, ErrorCode::UNEXPECTED_CHARACTER, sourceCode.substr(currentIndex, 1), currentIndex);
+    advance(); // Consume the unknown character to avoid infinite loop
+    return token;
+}
+
+// Returns the next token, or END_OF_FILE (repeatedly) once the source is exhausted
+Token Lexer::next() {
+    size_t start = currentIndex;
+    Token token = scanToken();
+    Stats::countToken(token.type, currentIndex - start);
+    return token;
+}
+
+// Main tokenization function
+std::vector<Token> Lexer::tokenize() {
+    std::vector<Token> tokens;
+    tokenize(tokens);
     return tokens;
 }
 
+void Lexer::tokenize(std::vector<Token>& tokens) {
+    tokens.clear();
+    do {
+        tokens.push_back(next());
+    } while (tokens.back().type != TokenType::END_OF_FILE);
+    Stats::notePeakTokens(tokens.size());
+}
+
+void Lexer::tokenize(TokenBuffer& tokens) {
+    tokens.reset(sourceCode);
+    Token token = next();
+    tokens.push(token);
+    while (token.type != TokenType::END_OF_FILE) {
+        token = next();
+        tokens.push(token);
+    }
+    Stats::notePeakTokens(tokens.size());
+}
+
 // Prints the lexemes and tokens table
-void Lexer::printLexemesAndTokens(const std::vector<Token>& tokens) const {
-    std::cout << "\n--- Lexemes and Tokens Table ---" << std::endl;
-    std::cout << std::left << std::setw(20) << "Lexeme"
+void Lexer::printLexemesAndTokens(const std::vector<Token>& tokens, const LineIndex& lines, std::ostream& out) const {
+    out << "\n--- Lexemes and Tokens Table ---" << '\n';
+    out << std::left << std::setw(20) << "Lexeme"
               << std::setw(20) << "Token Type"
               << std::setw(10) << "Line"
-              << std::setw(10) << "Column" << std::endl;
-    std::cout << std::string(60, '-') << std::endl;
+              << std::setw(10) << "Column" << '\n';
+    out << std::string(60, '-') << '\n';
 
     for (const auto& token : tokens) {
-        std::string tokenTypeName;
-        switch (token.type) {
-            case TokenType::IDENTIFIER: tokenTypeName = "IDENTIFIER"; break;
-            case TokenType::INTEGER_LITERAL: tokenTypeName = "INTEGER_LITERAL"; break;
-            case TokenType::FLOAT_LITERAL: tokenTypeName = "FLOAT_LITERAL"; break;
-            case TokenType::STRING_LITERAL: tokenTypeName = "STRING_LITERAL"; break;
-            case TokenType::BOOLEAN_LITERAL: tokenTypeName = "BOOLEAN_LITERAL"; break;
-            case TokenType::PLUS: tokenTypeName = "PLUS"; break;
-            case TokenType::MINUS: tokenTypeName = "MINUS"; break;
-            case TokenType::MULTIPLY: tokenTypeName = "MULTIPLY"; break;
-            case TokenType::DIVIDE: tokenTypeName = "DIVIDE"; break;
-            case TokenType::MODULO: tokenTypeName = "MODULO"; break; // For %
-            case TokenType::ASSIGN: tokenTypeName = "ASSIGN"; break; // For =
-            case TokenType::EQUAL_EQUAL: tokenTypeName = "EQUAL_EQUAL"; break; // For ==
-            case TokenType::NOT_EQUAL: tokenTypeName = "NOT_EQUAL"; break; // For !=
-            case TokenType::LESS_THAN: tokenTypeName = "LESS_THAN"; break;
-            case TokenType::LESS_EQUAL: tokenTypeName = "LESS_EQUAL"; break; // For <=
-            case TokenType::GREATER_THAN: tokenTypeName = "GREATER_THAN"; break;
-            case TokenType::GREATER_EQUAL: tokenTypeName = "GREATER_EQUAL"; break; // For >=
-            case TokenType::AND: tokenTypeName = "AND"; break;
-            case TokenType::OR: tokenTypeName = "OR"; break;
-            case TokenType::NOT: tokenTypeName = "NOT"; break;
-            case TokenType::LPAREN: tokenTypeName = "LPAREN"; break;
-            case TokenType::RPAREN: tokenTypeName = "RPAREN"; break;
-            case TokenType::LBRACE: tokenTypeName = "LBRACE"; break; 
-            case TokenType::RBRACE: tokenTypeName = "RBRACE"; break;
-            case TokenType::LBRACKET: tokenTypeName = "LBRACKET"; break;
-            case TokenType::RBRACKET: tokenTypeName = "RBRACKET"; break;
-            case TokenType::COMMA: tokenTypeName = "COMMA"; break;
-            case TokenType::COLON: tokenTypeName = "COLON"; break; // For :
-            case TokenType::SEMICOLON: tokenTypeName = "SEMICOLON"; break;
-            case TokenType::DOT: tokenTypeName = "DOT"; break;
-            case TokenType::IF: tokenTypeName = "IF"; break;
-            case TokenType::ELSE: tokenTypeName = "ELSE"; break;
-            case TokenType::ELIF: tokenTypeName = "ELIF"; break;
-            case TokenType::WHILE: tokenTypeName = "WHILE"; break;
-            case TokenType::FOR: tokenTypeName = "FOR"; break;
-            case TokenType::PRINT: tokenTypeName = "PRINT"; break; 
-            case TokenType::INPUT: tokenTypeName = "INPUT"; break;
-            case TokenType::DEF: tokenTypeName = "DEF"; break; 
-            case TokenType::RETURN: tokenTypeName = "RETURN"; break;
-            case TokenType::END_OF_FILE: tokenTypeName = "END_OF_FILE"; break;
-            case TokenType::UNKNOWN: tokenTypeName = "UNKNOWN"; break; 
-            // more cases can be added
-            default: tokenTypeName = "UNKNOWN_TYPE"; break; // Fallback for any unhandled types
-        }
-
-        std::cout << std::left << std::setw(20) << token.lexeme
-                  << std::setw(20) << tokenTypeName
-                  << std::setw(10) << token.lineNumber
-                  << std::setw(10) << token.columnNumber << std::endl;
+        out << std::left << std::setw(20) << token.lexeme
+                  << std::setw(20) << tokenTypeName(token.type)
+                  << std::setw(10) << lines.line(token.offset)
+                  << std::setw(10) << lines.column(token.offset) << '\n';
     }
-    std::cout << std::string(60, '-') << std::endl;
+    out << std::string(60, '-') << '\n';
 }
\ No newline at end of file
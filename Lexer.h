@@ -2,41 +2,82 @@
 #define LEXER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
-#include <fstream> // For reading file content
-#include <sstream>
+
+#include <iostream>
 
 #include "Token.h"
+#include "TokenBuffer.h"
+#include "LineIndex.h"
 #include "ErrorHandler.h"
 
+// Python's block structure comes out as tokens, so the parser never looks at whitespace:
+//  - NEWLINE ends every line that holds a token; blank and comment-only lines produce nothing
+//  - at the first token of a line, an indentation deeper than the enclosing block's gives an
+//    INDENT, a shallower one a DEDENT for each block it closes (it must match one of them)
+//  - at the end of the source the last line gets its NEWLINE and every open block its DEDENT
+// A tab indents to the next multiple of 8 columns, as in Python. As in Python too, lines are
+// joined inside brackets: while a '(' or '[' is open, a line break is only whitespace, so it
+// gives no NEWLINE and the indentation of the next line means nothing. Unlike Python, a bracket
+// left open does not swallow the rest of the file: when the next line with a token starts a
+// statement in column 1 (a statement keyword, or a name and '='), the line ends at its newline and
+// the count of open brackets goes back to 0, so only the statement with the missing bracket fails.
+// The state carried from one line to the next is the stack of open indentations and the count of
+// open brackets. Both are empty again at a token in column 1 that follows a NEWLINE or DEDENT
+// (see ParallelLexer and IncrementalAnalyzer).
 class Lexer {
 private:
-    std::string sourceCode;
-    size_t currentIndex;
-    int currentLine;
-    int currentCol;
+    std::string_view sourceCode; // Not owned; see SourceFile
+    size_t currentIndex; // The only position kept; lines and columns come from a LineIndex
     ErrorHandler& errorHandler;
 
-    std::map<std::string, TokenType> keywords;
-    std::map<char, TokenType> singleCharTokens;
-    std::map<std::string, TokenType> multiCharTokens;
+    // Layout state
+    std::vector<size_t> indents; // Indentation of every open block, outermost (0) first
+    size_t pendingDedents;       // DEDENTs still owed before the current line's first token
+    size_t lineStart;            // Offset where the current line begins
+    bool atLineStart;            // No token of the current line returned yet
+    size_t openBrackets;         // Brackets opened and not closed yet; lines are joined while > 0
+
+    // Keyword and operator tables are shared compile-time data (see LexerTables.h)
 
     // Helper functions
     char peek();
+    char peekNext();
     char advance();
-    void skipWhitespace();
+    void advanceTo(const char* position); // Skips a run found by a ScanKernels scanner
+    void skipWhitespace(); // Stops at a '\n' that ends a line with tokens
+    bool nextLineStartsStatement(size_t newline) const;
+    size_t indentationWidth() const; // Of the current line, up to currentIndex
+    Token layoutToken(TokenType type, size_t offset) const;
+    std::string_view lexemeFrom(size_t start) const;
+    const char* sourceEnd() const { return sourceCode.data() + sourceCode.size(); }
     Token identifyIdentifierOrKeyword();
     Token identifyNumber();
     Token identifyString();
     Token identifyOperator();
+    Token scanToken(); // next() without the statistics hook
 
 public:
-    Lexer(const std::string& code, ErrorHandler& handler);
+    // The source is not copied: the caller keeps the buffer alive for as long as the tokens are used
+    Lexer(std::string_view code, ErrorHandler& handler);
+
+    // Pull interface: lexes one token per call, so callers can consume tokens as they are produced
+    Token next();
+
+    // Lexes the whole source into a vector (ends with the END_OF_FILE token)
     std::vector<Token> tokenize();
+    // Same, into a caller's vector (cleared first), so a reused vector keeps its capacity
+    void tokenize(std::vector<Token>& tokens);
+    // Same, into a struct-of-arrays buffer (reset to this source first; see TokenBuffer::fits)
+    void tokenize(TokenBuffer& tokens);
+
+    // Brackets still open where lexing stopped; at the end of the source, ones never closed
+    size_t bracketDepth() const { return openBrackets; }
 
-    // Getter for lexemes and tokens table
-    void printLexemesAndTokens(const std::vector<Token>& tokens) const;
+    // Getter for lexemes and tokens table; lines is an index of this lexer's source
+    void printLexemesAndTokens(const std::vector<Token>& tokens, const LineIndex& lines,
+                               std::ostream& out = std::cout) const;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef LEXERTABLES_H
+#define LEXERTABLES_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+#include "Token.h"
+
+// Character classification and keyword lookup tables for the Lexer.
+// Everything here is built at compile time, so every Lexer shares the same read-only data
+// and constructing a Lexer costs nothing.
+namespace LexerTables {
+
+// Bit flags describing what a character can start or continue
+enum CharFlag : uint8_t {
+    CHAR_IDENT_START = 1 << 0, // [A-Za-z_]
+    CHAR_IDENT       = 1 << 1, // [A-Za-z0-9_]
+    CHAR_DIGIT       = 1 << 2, // [0-9]
+    CHAR_BLANK       = 1 << 3, // ' ', '\t', '\r'
+    CHAR_QUOTE       = 1 << 4, // ' or "
+    CHAR_OPERATOR    = 1 << 5  // starts an operator or delimiter (including '!' of "!=")
+};
+
+struct CharInfo {
+    uint8_t flags;
+    TokenType singleToken; // Token for a single-character operator/delimiter, UNKNOWN otherwise
+};
+
+constexpr std::array<CharInfo, 256> buildCharTable() {
+    std::array<CharInfo, 256> table{};
+    for (auto& info : table) {
+        info = CharInfo{0, TokenType::UNKNOWN};
+    }
+    for (int c = 'a'; c <= 'z'; ++c) {
+        table[c].flags = CHAR_IDENT_START | CHAR_IDENT;
+        table[c - 'a' + 'A'].flags = CHAR_IDENT_START | CHAR_IDENT;
+    }
+    for (int c = '0'; c <= '9'; ++c) {
+        table[c].flags = CHAR_IDENT | CHAR_DIGIT;
+    }
+    table['_'].flags = CHAR_IDENT_START | CHAR_IDENT;
+    table[' '].flags = CHAR_BLANK;
+    table['\t'].flags = CHAR_BLANK;
+    table['\r'].flags = CHAR_BLANK;
+    table['\''].flags = CHAR_QUOTE;
+    table['"'].flags = CHAR_QUOTE;
+
+    // Single character tokens
+    // blocks not yet added, {}, need further logic constraints
+    const std::pair<char, TokenType> singles[] = {
+        {'+', TokenType::PLUS},     {'-', TokenType::MINUS},    {'*', TokenType::MULTIPLY},
+        {'/', TokenType::DIVIDE},   {'%', TokenType::MODULO},   {'(', TokenType::LPAREN},
+        {')', TokenType::RPAREN},   {'[', TokenType::LBRACKET}, {']', TokenType::RBRACKET},
+        {',', TokenType::COMMA},    {':', TokenType::COLON},    {'.', TokenType::DOT},
+        {'=', TokenType::ASSIGN},   {'<', TokenType::LESS_THAN}, {'>', TokenType::GREATER_THAN}
+    };
+    for (const auto& single : singles) {
+        auto index = static_cast<unsigned char>(single.first);
+        table[index].flags = CHAR_OPERATOR;
+        table[index].singleToken = single.second;
+    }
+    table['!'].flags = CHAR_OPERATOR; // Only valid as the start of "!="
+    return table;
+}
+
+inline constexpr std::array<CharInfo, 256> charTable = buildCharTable();
+
+constexpr const CharInfo& info(char c) {
+    return charTable[static_cast<unsigned char>(c)];
+}
+
+constexpr bool hasFlag(char c, CharFlag flag) {
+    return (info(c).flags & flag) != 0;
+}
+
+// Keyword matcher switched on length, so an identifier is compared against at most four
+// keywords of the same length. Returns IDENTIFIER when the lexeme is not a keyword.
+constexpr TokenType lookupKeyword(std::string_view lexeme) {
+    switch (lexeme.size()) {
+        case 2:
+            if (lexeme == "if") return TokenType::IF;
+            if (lexeme == "or") return TokenType::OR;
+            break;
+        case 3:
+            if (lexeme == "for") return TokenType::FOR;
+            if (lexeme == "and") return TokenType::AND;
+            if (lexeme == "not") return TokenType::NOT;
+            break;
+        case 4:
+            if (lexeme == "else") return TokenType::ELSE;
+            if (lexeme == "elif") return TokenType::ELIF;
+            if (lexeme == "True") return TokenType::BOOLEAN_LITERAL;
+            break;
+        case 5:
+            if (lexeme == "while") return TokenType::WHILE;
+            if (lexeme == "print") return TokenType::PRINT;
+            if (lexeme == "input") return TokenType::INPUT;
+            if (lexeme == "False") return TokenType::BOOLEAN_LITERAL;
+            break;
+        default:
+            break;
+    }
+    return TokenType::IDENTIFIER;
+}
+
+static_assert(lookupKeyword("while") == TokenType::WHILE, "keyword table out of sync");
+static_assert(lookupKeyword("whilst") == TokenType::IDENTIFIER, "keyword table out of sync");
+static_assert(info('=').singleToken == TokenType::ASSIGN, "operator table out of sync");
+
+} // namespace LexerTables
+
+#endif
@@ -0,0 +1,60 @@
+// implementation of LineIndex.h
+
+#include "LineIndex.h"
+#include "ScanKernels.h"
+
+#include <algorithm>
+
+LineIndex LineIndex::sharedWith(const LineIndex& owner) {
+    owner.table();
+    LineIndex view(owner.source);
+    view.owner = &owner;
+    return view;
+}
+
+void LineIndex::reset(std::string_view newSource) {
+    source = newSource;
+    starts.clear();
+    hint = 0;
+    owner = nullptr;
+}
+
+void LineIndex::build() const {
+    starts.push_back(0);
+    ScanKernels::collectLineStarts(source.data(), source.data() + source.size(), 0, starts);
+}
+
+const std::vector<size_t>& LineIndex::table() const {
+    if (owner) {
+        return owner->table();
+    }
+    if (starts.empty()) {
+        build();
+    }
+    return starts;
+}
+
+// Checks the few lines after the hint before falling back to a binary search
+size_t LineIndex::findLine(size_t offset) const {
+    const std::vector<size_t>& lineStarts = table();
+    size_t h = hint;
+    if (lineStarts[h] <= offset) {
+        for (size_t step = 0; step < 4; ++step, ++h) {
+            if (h + 1 == lineStarts.size() || offset < lineStarts[h + 1]) {
+                hint = h;
+                return h;
+            }
+        }
+    }
+    h = static_cast<size_t>(std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin()) - 1;
+    hint = h;
+    return h;
+}
+
+size_t LineIndex::lineCount() const {
+    return table().size();
+}
+
+size_t LineIndex::lineStart(size_t line) const {
+    return table()[line - 1];
+}
@@ -0,0 +1,59 @@
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Turns byte offsets into 1-based line and column numbers. Tokens and errors only record the
+// offset where they start (see Token.h, ErrorHandler.h); their line and column are looked up
+// here when they are printed.
+// The table of line starts is built on the first lookup, by one vectorized pass over the source
+// (ScanKernels::collectLineStarts). A lookup is then a binary search, except that lookups in
+// source order mostly hit the line of the previous one, which is tried first.
+// Columns count bytes, so a tab is one column.
+// The lazy build and the hint mutate the index, so one must not be read from several threads at once.
+// Threads looking up lines of the same source each take a view of one index instead (sharedWith()):
+// it reads that index's table, which is built once, and only keeps a hint of its own.
+class LineIndex {
+private:
+    std::string_view source; // Not owned; only read to build the table
+    mutable std::vector<size_t> starts; // Offset of the first byte of every line, once built
+    mutable size_t hint;                // 0-based line of the last lookup
+    const LineIndex* owner;             // Whose table a view reads, nullptr if this one has its own
+
+    void build() const;
+    const std::vector<size_t>& table() const; // Built if need be
+    size_t findLine(size_t offset) const; // lineOf() when the hint misses
+    size_t lineOf(size_t offset) const;   // 0-based
+
+public:
+    LineIndex() : hint(0), owner(nullptr) {}
+    explicit LineIndex(std::string_view source) : source(source), hint(0), owner(nullptr) {}
+
+    // A view of owner's table, which is built here; owner must outlive the view and not change
+    static LineIndex sharedWith(const LineIndex& owner);
+
+    // Points the index at a new source, keeping the table's capacity (a view gets a table of its own)
+    void reset(std::string_view newSource);
+
+    size_t line(size_t offset) const { return lineOf(offset) + 1; }
+    size_t column(size_t offset) const { return offset - table()[lineOf(offset)] + 1; }
+
+    size_t lineCount() const;
+    size_t lineStart(size_t line) const; // Offset of the first byte of a 1-based line
+
+    // Bytes held by the table
+    size_t memoryBytes() const { return starts.capacity() * sizeof(size_t); }
+};
+
+inline size_t LineIndex::lineOf(size_t offset) const {
+    const std::vector<size_t>& lineStarts = owner ? owner->starts : starts;
+    size_t h = hint;
+    if (!lineStarts.empty() && lineStarts[h] <= offset && (h + 1 == lineStarts.size() || offset < lineStarts[h + 1])) {
+        return h;
+    }
+    return findLine(offset);
+}
+
+#endif
@@ -0,0 +1,718 @@
+// implementation of Optimizer.h
+
+#include "Optimizer.h"
+
+#include <cmath>
+#include <iomanip>
+
+namespace {
+
+// Longest string a fold may produce; longer ones are left to run time rather than copied into
+// the tree
+const size_t MAX_FOLDED_STRING = 4096;
+
+Opcode operatorOpcode(TokenType op) {
+    switch (op) {
+        case TokenType::PLUS: return Opcode::ADD;
+        case TokenType::MINUS: return Opcode::SUB;
+        case TokenType::MULTIPLY: return Opcode::MUL;
+        case TokenType::DIVIDE: return Opcode::DIV;
+        case TokenType::MODULO: return Opcode::MOD;
+        case TokenType::EQUAL_EQUAL: return Opcode::EQ;
+        case TokenType::NOT_EQUAL: return Opcode::NE;
+        case TokenType::LESS_THAN: return Opcode::LT;
+        case TokenType::LESS_EQUAL: return Opcode::LE;
+        case TokenType::GREATER_THAN: return Opcode::GT;
+        case TokenType::GREATER_EQUAL: return Opcode::GE;
+        default: return Opcode::HALT;
+    }
+}
+
+Opcode unaryOpcode(TokenType op) {
+    return op == TokenType::MINUS ? Opcode::NEG : op == TokenType::PLUS ? Opcode::POS : Opcode::NOT;
+}
+
+bool isComparison(Opcode op) { return op >= Opcode::EQ && op <= Opcode::GE; }
+bool isIntLike(ValueType type) { return type == ValueType::BOOL || type == ValueType::INT; }
+bool isNumber(ValueType type) { return isIntLike(type) || type == ValueType::FLOAT; }
+bool isIntLike(const Value& v) { return isIntLike(v.type); }
+
+// The number a numeric constant stands for, as a double
+double numberOf(const Value& v) { return v.type == ValueType::FLOAT ? v.f : static_cast<double>(v.i); }
+bool isIntValue(const Value& v, int64_t n) { return isIntLike(v) && v.i == n; }
+bool isNumberValue(const Value& v, double n) { return isNumber(v.type) && numberOf(v) == n; }
+
+// Type of `x op y` when it does not raise, UNBOUND if that depends on the values
+ValueType arithmeticType(Opcode op, ValueType x, ValueType y) {
+    if (isIntLike(x) && isIntLike(y)) {
+        return op == Opcode::DIV ? ValueType::FLOAT : ValueType::INT;
+    }
+    if (isNumber(x) && isNumber(y)) {
+        return ValueType::FLOAT;
+    }
+    if ((op == Opcode::ADD && x == ValueType::STR && y == ValueType::STR) ||
+        (op == Opcode::MUL && ((x == ValueType::STR && isIntLike(y)) || (isIntLike(x) && y == ValueType::STR)))) {
+        return ValueType::STR;
+    }
+    return ValueType::UNBOUND;
+}
+
+// Length of the string `x op y` would make, 0 if it makes none
+uint64_t resultLength(Opcode op, const Value& x, const Value& y) {
+    if (op == Opcode::ADD && x.type == ValueType::STR && y.type == ValueType::STR) {
+        return static_cast<uint64_t>(x.length) + y.length;
+    }
+    if (op == Opcode::MUL && (x.type == ValueType::STR || y.type == ValueType::STR)) {
+        const Value& text = x.type == ValueType::STR ? x : y;
+        const Value& count = x.type == ValueType::STR ? y : x;
+        if (isIntLike(count) && count.i > 0) {
+            return count.i > static_cast<int64_t>(MAX_FOLDED_STRING) ? MAX_FOLDED_STRING + 1 : count.i * text.length;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+void OptimizerReport::print(std::ostream& out) const {
+    out << "\n--- Optimizer Report ---" << std::endl;
+    out << std::left << std::setw(20) << "Nodes before" << nodesBefore << std::endl;
+    out << std::setw(20) << "Nodes after" << nodesAfter << std::endl;
+    out << std::setw(20) << "Nodes removed" << removed() << std::endl;
+    out << std::setw(20) << "Folded" << folded << std::endl;
+    out << std::setw(20) << "Propagated" << propagated << std::endl;
+    out << std::setw(20) << "Simplified" << simplified << std::endl;
+    out << std::setw(20) << "Branches pruned" << branchesPruned << std::endl;
+    out << "------------------------" << std::endl;
+}
+
+Optimizer::Optimizer(Ast& ast, const SymbolTable& symbolTable) : ast(ast), symbolTable(symbolTable) {}
+
+const OptimizerReport& Optimizer::optimize() {
+    report = OptimizerReport();
+    state.assign(symbolTable.getEntries().size(), Known());
+    nodeTypes.assign(ast.size(), ValueType::UNBOUND);
+    ast.walk(ast.getRoot(), [&](NodeId, size_t) {
+        report.nodesBefore++;
+        return true;
+    });
+
+    if (ast.getRoot() != NO_NODE) {
+        optimizeBlock(ast.getRoot());
+    }
+    ast.compact();
+    report.nodesAfter = ast.size();
+    state.clear();
+    nodeTypes.clear();
+    return report;
+}
+
+NodeId Optimizer::typed(NodeId id, ValueType type) {
+    if (id >= nodeTypes.size()) {
+        nodeTypes.resize(ast.size(), ValueType::UNBOUND);
+    }
+    nodeTypes[id] = type;
+    return id;
+}
+
+ValueType Optimizer::typeOf(NodeId id) const {
+    return id < nodeTypes.size() ? nodeTypes[id] : ValueType::UNBOUND;
+}
+
+bool Optimizer::literalValue(NodeId id, Value& value) {
+    const AstNode& node = ast.node(id);
+    return node.kind == NodeKind::Literal && parseLiteral(node.op, node.text, scratch, value);
+}
+
+// The literal's text is what appendValue writes, which parseLiteral reads back as the same value
+NodeId Optimizer::makeLiteral(const Value& value, size_t line) {
+    TokenType type = TokenType::BOOLEAN_LITERAL;
+    std::string_view text;
+    if (value.type == ValueType::BOOL) {
+        text = value.i ? "True" : "False";
+    } else {
+        std::string lexeme;
+        appendValue(lexeme, value);
+        text = ast.addText(std::move(lexeme));
+        type = value.type == ValueType::INT     ? TokenType::INTEGER_LITERAL
+               : value.type == ValueType::FLOAT ? TokenType::FLOAT_LITERAL
+                                                : TokenType::STRING_LITERAL;
+    }
+    return typed(ast.addNode(NodeKind::Literal, type, text, line), value.type);
+}
+
+int Optimizer::position(NodeId id) const {
+    return static_cast<int>(symbolTable.search(ast.node(id).text));
+}
+
+std::vector<int> Optimizer::assignedIn(NodeId id) const {
+    std::vector<int> positions;
+    ast.walk(id, [&](NodeId child, size_t) {
+        NodeKind kind = ast.node(child).kind;
+        if (kind == NodeKind::Assign || kind == NodeKind::For) {
+            positions.push_back(position(child));
+        }
+        return kind != NodeKind::Assign; // Expressions assign nothing
+    });
+    return positions;
+}
+
+void Optimizer::forget(const std::vector<int>& positions) {
+    for (int pos : positions) {
+        if (pos >= 0) {
+            state[static_cast<size_t>(pos)] = Known();
+        }
+    }
+}
+
+// Keeps only what holds on both paths
+void Optimizer::merge(std::vector<Known>& into, const std::vector<Known>& other) const {
+    for (size_t i = 0; i < into.size(); ++i) {
+        Known& a = into[i];
+        const Known& b = other[i];
+        if (a.type != b.type) {
+            a = Known();
+        } else if (a.literal != b.literal &&
+                   (a.literal == NO_NODE || b.literal == NO_NODE || ast.node(a.literal).op != ast.node(b.literal).op ||
+                    ast.node(a.literal).text != ast.node(b.literal).text)) {
+            a.literal = NO_NODE;
+        }
+    }
+}
+
+// Optimizes from an explicit stack: the frame on top is revisited after each of its blocks
+void Optimizer::optimizeBlock(NodeId root) {
+    size_t base = statementStack.size();
+    optimizeStatement(root, false);
+    while (statementStack.size() > base) {
+        StatementFrame& frame = statementStack.back();
+        switch (ast.node(frame.id).kind) {
+            case NodeKind::If:
+                if (frame.block == NO_NODE) {
+                    finishIf();
+                    break;
+                }
+                // A branch was optimized: it starts again from the entry state
+                if (frame.branches.empty()) {
+                    frame.merged = state;
+                } else {
+                    merge(frame.merged, state);
+                }
+                state = frame.entry;
+                frame.branches.push_back(frame.child);
+                frame.branches.push_back(frame.block);
+                frame.child = ast.node(frame.block).nextSibling;
+                nextBranch();
+                break;
+            case NodeKind::While:
+                finishWhile();
+                break;
+            default:
+                if (frame.child == NO_NODE) {
+                    finishBlock();
+                    break;
+                }
+                NodeId child = frame.child;
+                frame.child = ast.node(child).nextSibling;
+                optimizeStatement(child, true);
+                break;
+        }
+    }
+}
+
+void Optimizer::optimizeStatement(NodeId id, bool statement) {
+    switch (ast.node(id).kind) {
+        case NodeKind::Program:
+        case NodeKind::Block:
+            statementStack.push_back({id, ast.node(id).firstChild, NO_NODE, NO_NODE, kept.size(), 0, statement,
+                                      {}, {}, {}, {}});
+            return;
+        case NodeKind::Assign: {
+            NodeId value = optimizeExpression(ast.node(id).firstChild);
+            ast.replaceChildren(id, {value});
+            int pos = position(id);
+            if (pos >= 0) {
+                Value constant;
+                bool isConstant = value != NO_NODE && literalValue(value, constant);
+                scratch.clear();
+                state[static_cast<size_t>(pos)] = Known{typeOf(value), isConstant ? value : NO_NODE};
+            }
+            break;
+        }
+        case NodeKind::ExprStmt: {
+            NodeId value = optimizeExpression(ast.node(id).firstChild);
+            if (value != NO_NODE && ast.node(value).kind == NodeKind::Literal) {
+                return; // Evaluating a constant does nothing
+            }
+            ast.replaceChildren(id, {value});
+            break;
+        }
+        case NodeKind::Print:
+            ast.replaceChildren(id, {optimizeExpression(ast.node(id).firstChild)});
+            break;
+        case NodeKind::If:
+            optimizeIf(id);
+            return;
+        case NodeKind::While:
+            optimizeWhile(id);
+            return;
+        case NodeKind::For:
+            forget(assignedIn(id)); // Not run by the interpreter, so only what it assigns matters
+            break;
+        default:
+            break;
+    }
+    kept.push_back(id);
+}
+
+void Optimizer::finishBlock() {
+    StatementFrame& frame = statementStack.back();
+    auto first = kept.begin() + static_cast<std::ptrdiff_t>(frame.start);
+    ast.replaceChildren(frame.id, std::vector<NodeId>(first, kept.end()));
+    kept.resize(frame.start);
+    if (frame.statement) {
+        kept.push_back(frame.id);
+    }
+    statementStack.pop_back();
+}
+
+// Children: condition, block, then (condition, block) per elif, then the else block
+void Optimizer::optimizeIf(NodeId id) {
+    size_t children = 0;
+    NodeId last = NO_NODE;
+    for (NodeId child = ast.node(id).firstChild; child != NO_NODE; child = ast.node(child).nextSibling) {
+        children++;
+        last = child;
+    }
+    NodeId elseBlock = (ast.node(id).flags & HAS_ELSE) ? last : NO_NODE;
+    size_t pairs = (children - (elseBlock != NO_NODE ? 1 : 0)) / 2;
+    // Conditions are tested with the state on entry; each branch starts from it too
+    statementStack.push_back({id, ast.node(id).firstChild, NO_NODE, elseBlock, 0, pairs, false, state, {}, {}, {}});
+    nextBranch();
+}
+
+// Tries the conditions left until one has a block to optimize, then the else block
+void Optimizer::nextBranch() {
+    StatementFrame& frame = statementStack.back();
+    for (; frame.start < frame.pairs; frame.start++) {
+        NodeId condition = optimizeExpression(frame.child);
+        NodeId block = ast.node(frame.child).nextSibling;
+        Value constant;
+        if (condition != NO_NODE && literalValue(condition, constant)) {
+            if (!isTruthy(constant)) {
+                report.branchesPruned++;
+                frame.child = ast.node(block).nextSibling;
+                continue;
+            }
+            // Always taken once reached: it is the else, and what follows never runs
+            report.branchesPruned += frame.pairs - frame.start - 1 + (frame.elseBlock != NO_NODE ? 1 : 0);
+            frame.elseBlock = block;
+            break;
+        }
+        frame.start++;
+        frame.child = condition;
+        frame.block = block;
+        optimizeStatement(block, false);
+        return;
+    }
+    frame.block = NO_NODE;
+    if (frame.elseBlock != NO_NODE) {
+        optimizeStatement(frame.elseBlock, false);
+    } else {
+        finishIf();
+    }
+}
+
+void Optimizer::finishIf() {
+    StatementFrame frame = std::move(statementStack.back());
+    statementStack.pop_back();
+    if (frame.branches.empty()) {
+        // No condition is left to test, so the else block (if any) simply runs here
+        if (frame.elseBlock != NO_NODE) {
+            for (NodeId child = ast.node(frame.elseBlock).firstChild; child != NO_NODE;
+                 child = ast.node(child).nextSibling) {
+                kept.push_back(child);
+            }
+        }
+        return;
+    }
+    merge(frame.merged, state); // The else block, or falling through with the entry state
+    state = std::move(frame.merged);
+
+    if (frame.elseBlock != NO_NODE) {
+        frame.branches.push_back(frame.elseBlock);
+        ast.node(frame.id).flags |= HAS_ELSE;
+    } else {
+        ast.node(frame.id).flags &= static_cast<uint16_t>(~HAS_ELSE);
+    }
+    ast.replaceChildren(frame.id, frame.branches);
+    kept.push_back(frame.id);
+}
+
+// Children: condition, block. A loop whose condition is false on entry is removed. Otherwise the
+// condition and body see the state of any iteration, so the variables the loop assigns are
+// forgotten first (and again after the body).
+void Optimizer::optimizeWhile(NodeId id) {
+    NodeId condition = ast.node(id).firstChild;
+    NodeId body = condition == NO_NODE ? NO_NODE : ast.node(condition).nextSibling;
+    Value constant;
+    bool neverRuns = evaluate(condition, constant) && !isTruthy(constant);
+    scratch.clear();
+    if (neverRuns) {
+        report.branchesPruned++;
+        return;
+    }
+    std::vector<int> assigned = assignedIn(id);
+    forget(assigned);
+
+    condition = optimizeExpression(condition);
+    statementStack.push_back({id, condition, body, NO_NODE, 0, 0, false, {}, {}, {}, std::move(assigned)});
+    if (body != NO_NODE) {
+        optimizeStatement(body, false);
+    } else {
+        finishWhile();
+    }
+}
+
+void Optimizer::finishWhile() {
+    StatementFrame frame = std::move(statementStack.back());
+    statementStack.pop_back();
+    if (frame.block != NO_NODE) {
+        forget(frame.assigned);
+    }
+    ast.replaceChildren(frame.id, {frame.child, frame.block});
+    kept.push_back(frame.id);
+}
+
+// Operands are evaluated from an explicit stack, their values kept on evaluated
+bool Optimizer::evaluate(NodeId root, Value& value) {
+    size_t base = expressionStack.size();
+    size_t valueBase = evaluated.size();
+    expressionStack.push_back({root, NO_NODE, NO_NODE, 0});
+    std::string error;
+    bool ok = true;
+    while (ok && expressionStack.size() > base) {
+        ExpressionFrame& frame = expressionStack.back();
+        if (frame.id == NO_NODE) {
+            ok = false;
+            break;
+        }
+        const AstNode& node = ast.node(frame.id);
+        Value x;
+        switch (node.kind) {
+            case NodeKind::Literal:
+                ok = literalValue(frame.id, x);
+                evaluated.push_back(x);
+                break;
+            case NodeKind::Name: {
+                int pos = position(frame.id);
+                ok = pos >= 0 && state[static_cast<size_t>(pos)].literal != NO_NODE &&
+                     literalValue(state[static_cast<size_t>(pos)].literal, x);
+                evaluated.push_back(x);
+                break;
+            }
+            case NodeKind::Unary:
+                if (frame.step == 0) {
+                    frame.step = 1;
+                    expressionStack.push_back({node.firstChild, NO_NODE, NO_NODE, 0});
+                    continue;
+                }
+                ok = applyUnary(unaryOpcode(node.op), evaluated.back(), x, error);
+                evaluated.back() = x;
+                break;
+            case NodeKind::Binary: {
+                if (frame.step == 0) {
+                    frame.right = node.firstChild == NO_NODE ? NO_NODE : ast.node(node.firstChild).nextSibling;
+                    frame.step = 1;
+                    expressionStack.push_back({node.firstChild, NO_NODE, NO_NODE, 0});
+                    continue;
+                }
+                if (node.op == TokenType::AND || node.op == TokenType::OR) {
+                    if (isTruthy(evaluated.back()) == (node.op == TokenType::AND)) {
+                        // The right operand decides: it takes this frame's place
+                        evaluated.pop_back();
+                        frame = {frame.right, NO_NODE, NO_NODE, 0};
+                        continue;
+                    }
+                    break; // The left operand is the value
+                }
+                if (frame.step == 1) {
+                    frame.step = 2;
+                    expressionStack.push_back({frame.right, NO_NODE, NO_NODE, 0});
+                    continue;
+                }
+                Value y = evaluated.back();
+                evaluated.pop_back();
+                x = evaluated.back();
+                Opcode op = operatorOpcode(node.op);
+                bool result = false;
+                if (isComparison(op)) {
+                    ok = applyComparison(op, x, y, result, error);
+                    evaluated.back() = Value::fromBool(result);
+                } else {
+                    ok = resultLength(op, x, y) <= MAX_FOLDED_STRING &&
+                         applyBinary(op, x, y, scratch, evaluated.back(), error);
+                }
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+        expressionStack.pop_back();
+    }
+    if (ok) {
+        value = evaluated.back();
+    }
+    expressionStack.resize(base);
+    evaluated.resize(valueBase);
+    return ok;
+}
+
+// Walks the expression from an explicit stack: a frame is revisited after each of its operands,
+// with value holding what replaces the operand just finished
+NodeId Optimizer::optimizeExpression(NodeId root) {
+    size_t base = expressionStack.size();
+    expressionStack.push_back({root, NO_NODE, NO_NODE, 0});
+    NodeId value = NO_NODE;
+    while (expressionStack.size() > base) {
+        ExpressionFrame& frame = expressionStack.back();
+        NodeId id = frame.id;
+        if (id == NO_NODE) {
+            value = NO_NODE;
+            expressionStack.pop_back();
+            continue;
+        }
+        // Copied, since optimizing may add nodes (and move the node array)
+        NodeKind kind = ast.node(id).kind;
+        TokenType op = ast.node(id).op;
+        NodeId firstChild = ast.node(id).firstChild;
+        switch (kind) {
+            case NodeKind::Literal: {
+                Value literal;
+                value = typed(id, literalValue(id, literal) ? literal.type : ValueType::UNBOUND);
+                break;
+            }
+            case NodeKind::Name: {
+                int pos = position(id);
+                Known known = pos >= 0 ? state[static_cast<size_t>(pos)] : Known();
+                if (known.literal != NO_NODE) {
+                    // A copy, so that no node has two parents
+                    const AstNode& literal = ast.node(known.literal);
+                    report.propagated++;
+                    value = typed(ast.addNode(NodeKind::Literal, literal.op, literal.text, ast.node(id).line), known.type);
+                } else {
+                    value = typed(id, known.type);
+                }
+                break;
+            }
+            case NodeKind::Input:
+                if (frame.step == 0 && firstChild != NO_NODE) {
+                    frame.step = 1;
+                    expressionStack.push_back({firstChild, NO_NODE, NO_NODE, 0});
+                    continue;
+                }
+                if (frame.step == 1) {
+                    ast.replaceChildren(id, {value});
+                }
+                value = typed(id, ValueType::STR);
+                break;
+            case NodeKind::Unary:
+                if (frame.step == 0) {
+                    frame.step = 1;
+                    expressionStack.push_back({firstChild, NO_NODE, NO_NODE, 0});
+                    continue;
+                }
+                value = optimizeUnary(id, value);
+                break;
+            case NodeKind::Binary: {
+                bool logical = op == TokenType::AND || op == TokenType::OR;
+                if (frame.step == 0) {
+                    frame.right = firstChild == NO_NODE ? NO_NODE : ast.node(firstChild).nextSibling;
+                    frame.step = 1;
+                    expressionStack.push_back({firstChild, NO_NODE, NO_NODE, 0});
+                    continue;
+                }
+                if (frame.step == 1) {
+                    frame.left = value;
+                    Value x;
+                    if (logical && value != NO_NODE && literalValue(value, x)) {
+                        // A constant left operand decides which operand is the result, whatever its type
+                        scratch.clear();
+                        if (isTruthy(x) != (op == TokenType::AND)) {
+                            report.folded++; // The literal itself
+                            break;
+                        }
+                        frame.step = 3;
+                    } else {
+                        frame.step = 2;
+                    }
+                    expressionStack.push_back({frame.right, NO_NODE, NO_NODE, 0});
+                    continue;
+                }
+                if (frame.step == 3) { // The right operand of a decided 'and' / 'or' is the result
+                    if (value != NO_NODE && ast.node(value).kind == NodeKind::Literal) {
+                        report.folded++;
+                    } else {
+                        report.simplified++;
+                    }
+                    break;
+                }
+                if (logical) {
+                    ast.replaceChildren(id, {frame.left, value});
+                    value = typed(id, typeOf(frame.left) == typeOf(value) ? typeOf(frame.left) : ValueType::UNBOUND);
+                } else {
+                    value = optimizeBinary(id, frame.left, value);
+                }
+                break;
+            }
+            default:
+                value = id;
+                break;
+        }
+        expressionStack.pop_back();
+    }
+    return value;
+}
+
+NodeId Optimizer::optimizeUnary(NodeId id, NodeId operand) {
+    ast.replaceChildren(id, {operand});
+    if (operand == NO_NODE) {
+        return id;
+    }
+    TokenType op = ast.node(id).op;
+    Opcode opcode = unaryOpcode(op);
+
+    Value x;
+    Value result;
+    std::string error;
+    if (literalValue(operand, x) && applyUnary(opcode, x, result, error)) {
+        scratch.clear();
+        report.folded++;
+        return makeLiteral(result, ast.node(id).line);
+    }
+    scratch.clear();
+
+    ValueType type = typeOf(operand);
+    const AstNode& inner = ast.node(operand);
+    NodeId innerOperand = inner.kind == NodeKind::Unary ? inner.firstChild : NO_NODE;
+    bool numeric = type == ValueType::INT || type == ValueType::FLOAT;
+    if (opcode == Opcode::POS && numeric) { // +x
+        report.simplified++;
+        return operand;
+    }
+    if (innerOperand != NO_NODE && inner.op == op &&
+        ((opcode == Opcode::NEG && (typeOf(innerOperand) == ValueType::INT || typeOf(innerOperand) == ValueType::FLOAT)) ||
+         (opcode == Opcode::NOT && typeOf(innerOperand) == ValueType::BOOL))) { // -(-x), not not x
+        report.simplified++;
+        return innerOperand;
+    }
+    if (opcode == Opcode::NOT) {
+        return typed(id, ValueType::BOOL);
+    }
+    return typed(id, numeric ? type : isIntLike(type) ? ValueType::INT : ValueType::UNBOUND);
+}
+
+NodeId Optimizer::optimizeBinary(NodeId id, NodeId left, NodeId right) {
+    TokenType op = ast.node(id).op;
+    size_t line = ast.node(id).line;
+    Value x;
+    Value y;
+
+    ast.replaceChildren(id, {left, right});
+    if (left == NO_NODE || right == NO_NODE) {
+        return id;
+    }
+    Opcode opcode = operatorOpcode(op);
+    bool constants = literalValue(left, x) && literalValue(right, y);
+
+    if (isComparison(opcode)) {
+        bool result = false;
+        std::string error;
+        bool folded = constants && applyComparison(opcode, x, y, result, error);
+        scratch.clear();
+        if (folded) {
+            report.folded++;
+            return makeLiteral(Value::fromBool(result), line);
+        }
+        // x op x for a variable whose type compares equal to itself (a float could be nan)
+        const AstNode& a = ast.node(left);
+        const AstNode& b = ast.node(right);
+        ValueType type = typeOf(left);
+        if (a.kind == NodeKind::Name && b.kind == NodeKind::Name && a.text == b.text &&
+            (type == ValueType::INT || type == ValueType::STR || type == ValueType::BOOL)) {
+            report.simplified++;
+            return makeLiteral(Value::fromBool(opcode == Opcode::EQ || opcode == Opcode::LE || opcode == Opcode::GE), line);
+        }
+        return typed(id, ValueType::BOOL);
+    }
+
+    if (constants && resultLength(opcode, x, y) <= MAX_FOLDED_STRING) {
+        Value result;
+        std::string error;
+        if (applyBinary(opcode, x, y, scratch, result, error)) {
+            NodeId literal = makeLiteral(result, line);
+            scratch.clear();
+            report.folded++;
+            return literal;
+        }
+    }
+    scratch.clear();
+    NodeId simpler = applyIdentity(opcode, left, right, line);
+    if (simpler != NO_NODE) {
+        report.simplified++;
+        return simpler;
+    }
+    return typed(id, arithmeticType(opcode, typeOf(left), typeOf(right)));
+}
+
+// The operand or literal `left op right` can be replaced by, or NO_NODE. An operand is only
+// dropped when it is a variable known to hold a value of the right type, so nothing that could
+// raise (or print) is lost.
+NodeId Optimizer::applyIdentity(Opcode op, NodeId left, NodeId right, size_t line) {
+    ValueType leftType = typeOf(left);
+    ValueType rightType = typeOf(right);
+    Value x;
+    Value y;
+    bool leftConstant = literalValue(left, x);
+    bool rightConstant = literalValue(right, y);
+    scratch.clear();
+    const AstNode& a = ast.node(left);
+    const AstNode& b = ast.node(right);
+    bool sameIntName = a.kind == NodeKind::Name && b.kind == NodeKind::Name && a.text == b.text &&
+                       leftType == ValueType::INT;
+    auto intName = [&](NodeId id) { return ast.node(id).kind == NodeKind::Name && typeOf(id) == ValueType::INT; };
+
+    switch (op) {
+        case Opcode::ADD: // x + 0, 0 + x (not for floats: -0.0 + 0 is 0.0)
+            if (rightConstant && isIntValue(y, 0) && leftType == ValueType::INT) return left;
+            if (leftConstant && isIntValue(x, 0) && rightType == ValueType::INT) return right;
+            break;
+        case Opcode::SUB: // x - 0, x - x
+            if (rightConstant && leftType == ValueType::INT && isIntValue(y, 0)) return left;
+            if (rightConstant && leftType == ValueType::FLOAT && isNumberValue(y, 0) && !std::signbit(numberOf(y))) {
+                return left;
+            }
+            if (sameIntName) return makeLiteral(Value::fromInt(0), line);
+            break;
+        case Opcode::MUL: // x * 1, 1 * x, x * 0, 0 * x
+            if (rightConstant && ((leftType == ValueType::INT && isIntValue(y, 1)) ||
+                                  (leftType == ValueType::FLOAT && isNumberValue(y, 1)))) {
+                return left;
+            }
+            if (leftConstant && ((rightType == ValueType::INT && isIntValue(x, 1)) ||
+                                 (rightType == ValueType::FLOAT && isNumberValue(x, 1)))) {
+                return right;
+            }
+            if ((rightConstant && isIntValue(y, 0) && intName(left)) || (leftConstant && isIntValue(x, 0) && intName(right))) {
+                return makeLiteral(Value::fromInt(0), line);
+            }
+            break;
+        case Opcode::DIV: // x / 1 (an int divided by 1 is a float, so floats only)
+            if (rightConstant && leftType == ValueType::FLOAT && isNumberValue(y, 1)) return left;
+            break;
+        default:
+            break;
+    }
+    return NO_NODE;
+}
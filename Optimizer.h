@@ -0,0 +1,117 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "AST.h"
+#include "Bytecode.h"
+#include "SymbolTable.h"
+
+// What one optimize() did. Nodes are counted as reachable from the root.
+struct OptimizerReport {
+    size_t nodesBefore = 0;
+    size_t nodesAfter = 0;
+    size_t folded = 0;         // Operators on constants replaced by their result
+    size_t propagated = 0;     // Variable reads replaced by the constant last assigned
+    size_t simplified = 0;     // Algebraic identities applied (x + 0, x * 1, x - x, ...)
+    size_t branchesPruned = 0; // if/elif/else bodies and while loops that can never run
+
+    size_t removed() const { return nodesBefore - nodesAfter; }
+    void print(std::ostream& out = std::cout) const;
+};
+
+// Simplifies the tree of an error-free parse in place, before it is printed or compiled:
+//   - operators whose operands are all literals are folded into a literal, with the same
+//     semantics as the interpreter (see Bytecode.h); anything that would raise is left alone
+//   - identities that hold for the operand's type are applied, e.g. x * 1 -> x for an int or
+//     float x, and x * 0 -> 0 only for an int variable (for a float it could be -0.0 or nan)
+//   - a variable read after a straight-line assignment of a literal becomes that literal.
+//     Variables are tracked by SymbolTable position; at an if the branches' states are merged,
+//     and a loop forgets every variable it assigns.
+//   - if/elif conditions that fold to a constant drop their branch or become the else, and a
+//     while loop whose condition is false on entry is removed
+// The tree is then compacted, so the nodes removed no longer take up space.
+class Optimizer {
+private:
+    // What is known about a variable at the current statement
+    struct Known {
+        ValueType type = ValueType::UNBOUND; // UNBOUND: not known (or not assigned yet)
+        NodeId literal = NO_NODE;            // The Literal node last assigned, if any
+    };
+    // A block, if or while whose blocks are being optimized, revisited after each of them
+    struct StatementFrame {
+        NodeId id;
+        NodeId child;       // Block: the next statement; If: the next condition; While: the condition
+        NodeId block;       // If: the branch's block being optimized, NO_NODE for the else block
+        NodeId elseBlock;   // If: the else block, or the block of a condition that is always true
+        size_t start;       // Block: where its statements start in kept; If: the pairs tried so far
+        size_t pairs;       // If: condition/block pairs
+        bool statement;     // Block: kept by the enclosing block when done
+        std::vector<Known> entry;     // If: the state on entry
+        std::vector<Known> merged;    // If: what holds after every branch done so far
+        std::vector<NodeId> branches; // If: the conditions and blocks left
+        std::vector<int> assigned;    // While: what the loop assigns
+    };
+    // An expression node being optimized or evaluated, revisited once per operand
+    struct ExpressionFrame {
+        NodeId id;
+        NodeId right; // Binary: the right operand, found before the left one is optimized
+        NodeId left;  // Binary: what replaces the left operand, once optimized
+        uint8_t step; // Operands done so far (3: a constant left operand decided 'and' / 'or')
+    };
+
+    Ast& ast;
+    const SymbolTable& symbolTable;
+    std::vector<Known> state;           // By SymbolTable position
+    std::vector<ValueType> nodeTypes;   // Type of each optimized expression, UNBOUND if not known
+    std::deque<std::string> scratch;    // STR values of the fold being tried
+    // Blocks nest as deep as ErrorPolicy::maxNesting allows and expressions as deep as an operator
+    // chain is long, so both are optimized from these stacks rather than by recursion
+    std::vector<StatementFrame> statementStack;
+    std::vector<NodeId> kept; // What replaces the statements of each block on statementStack
+    std::vector<ExpressionFrame> expressionStack;
+    std::vector<Value> evaluated;                 // Operand values of evaluate()
+    OptimizerReport report;
+
+    NodeId typed(NodeId id, ValueType type);
+    ValueType typeOf(NodeId id) const;
+    bool literalValue(NodeId id, Value& value);
+    NodeId makeLiteral(const Value& value, size_t line);
+    int position(NodeId name) const; // SymbolTable position of a Name/Assign/For, -1 if none
+    std::vector<int> assignedIn(NodeId id) const;
+    void forget(const std::vector<int>& positions);
+    void merge(std::vector<Known>& into, const std::vector<Known>& other) const;
+
+    void optimizeBlock(NodeId id);
+    // Appends what replaces a one-line statement to kept (itself or nothing), or pushes the frame
+    // of a block, if or while, which appends its replacement when done
+    void optimizeStatement(NodeId id, bool statement);
+    void optimizeIf(NodeId id);
+    void nextBranch();
+    void finishIf();
+    void optimizeWhile(NodeId id);
+    void finishWhile();
+    void finishBlock();
+    // The value of an expression from its literals and the known variables, without changing
+    // the tree; false if it is not constant or would raise. STR results point into scratch.
+    bool evaluate(NodeId id, Value& value);
+    // Returns the node that replaces the expression (possibly itself)
+    NodeId optimizeExpression(NodeId id);
+    // The node that replaces a Unary, or a Binary other than 'and' / 'or', given what replaces
+    // its operands
+    NodeId optimizeUnary(NodeId id, NodeId operand);
+    NodeId optimizeBinary(NodeId id, NodeId left, NodeId right);
+    NodeId applyIdentity(Opcode op, NodeId left, NodeId right, size_t line);
+
+public:
+    Optimizer(Ast& ast, const SymbolTable& symbolTable);
+
+    const OptimizerReport& optimize();
+    const OptimizerReport& getReport() const { return report; }
+};
+
+#endif
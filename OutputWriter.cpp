@@ -0,0 +1,287 @@
+// implementation of OutputWriter.h
+
+#include "OutputWriter.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace {
+
+const char BINARY_MAGIC[4] = {'P', 'L', 'T', 'K'};
+const uint32_t BINARY_FORMAT_VERSION = 1;
+const uint32_t NOT_IN_SOURCE = 0xFFFFFFFFu; // Lexeme is not source text ("EOF", unexpected characters)
+
+// Binary token dump, one section per file: FileHeader, the path bytes, then tokenCount
+// TokenRecords. Fields are native byte order and not padded; read them with memcpy.
+struct FileHeader {
+    char magic[4];
+    uint32_t formatVersion;
+    uint32_t pathLength;
+    uint32_t tokenCount;
+};
+
+// The lexeme is source[offset, offset + length); values past 32 bits are truncated
+struct TokenRecord {
+    uint8_t type; // TokenType
+    uint8_t reserved[3];
+    uint32_t offset;
+    uint32_t length;
+    uint32_t line;
+    uint32_t column;
+};
+
+} // namespace
+
+bool parseOutputFormat(std::string_view name, OutputFormat& format) {
+    if (name == "table") format = OutputFormat::TABLE;
+    else if (name == "none") format = OutputFormat::NONE;
+    else if (name == "summary") format = OutputFormat::SUMMARY;
+    else if (name == "ndjson") format = OutputFormat::NDJSON;
+    else if (name == "csv") format = OutputFormat::CSV;
+    else if (name == "binary") format = OutputFormat::BINARY;
+    else return false;
+    return true;
+}
+
+OutputWriter::OutputWriter(OutputFormat format, size_t initialCapacity) : format(format) {
+    buffer.reserve(initialCapacity);
+}
+
+void OutputWriter::appendNumber(uint64_t value) {
+    char digits[20];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.append(digits, result.ptr);
+}
+
+void OutputWriter::appendJsonString(std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    buffer += '"';
+    for (char c : text) {
+        unsigned char byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            buffer += '\\';
+            buffer += c;
+        } else if (byte < 0x20) {
+            buffer += "\\u00";
+            buffer += hex[byte >> 4];
+            buffer += hex[byte & 0xF];
+        } else {
+            buffer += c;
+        }
+    }
+    buffer += '"';
+}
+
+// Quotes the field only when it needs it (RFC 4180)
+void OutputWriter::appendCsvField(std::string_view text) {
+    if (text.find_first_of(",\"\r\n") == std::string_view::npos) {
+        buffer += text;
+        return;
+    }
+    buffer += '"';
+    for (char c : text) {
+        if (c == '"') {
+            buffer += '"';
+        }
+        buffer += c;
+    }
+    buffer += '"';
+}
+
+void OutputWriter::appendRaw(const void* data, size_t size) {
+    buffer.append(static_cast<const char*>(data), size);
+}
+
+void OutputWriter::writeHeader() {
+    if (format == OutputFormat::CSV) {
+        buffer += "file,kind,name,type,line,column,detail\n";
+    }
+}
+
+void OutputWriter::writeTokensNdjson(std::string_view path, const LineIndex& lines, const std::vector<Token>& tokens) {
+    for (const Token& token : tokens) {
+        buffer += "{\"file\":";
+        appendJsonString(path);
+        buffer += ",\"kind\":\"token\",\"type\":\"";
+        buffer += tokenTypeName(token.type);
+        buffer += "\",\"lexeme\":";
+        appendJsonString(token.lexeme);
+        buffer += ",\"line\":";
+        appendNumber(lines.line(token.offset));
+        buffer += ",\"column\":";
+        appendNumber(lines.column(token.offset));
+        buffer += "}\n";
+    }
+}
+
+void OutputWriter::writeTokensCsv(std::string_view path, const LineIndex& lines, const std::vector<Token>& tokens) {
+    for (const Token& token : tokens) {
+        appendCsvField(path);
+        buffer += ",token,";
+        appendCsvField(token.lexeme);
+        buffer += ',';
+        buffer += tokenTypeName(token.type);
+        buffer += ',';
+        appendNumber(lines.line(token.offset));
+        buffer += ',';
+        appendNumber(lines.column(token.offset));
+        buffer += ",\n";
+    }
+}
+
+void OutputWriter::writeTokensBinary(std::string_view path, std::string_view source, const LineIndex& lines,
+                                     const std::vector<Token>& tokens) {
+    FileHeader header;
+    std::copy(BINARY_MAGIC, BINARY_MAGIC + 4, header.magic);
+    header.formatVersion = BINARY_FORMAT_VERSION;
+    header.pathLength = static_cast<uint32_t>(path.size());
+    header.tokenCount = static_cast<uint32_t>(tokens.size());
+    buffer.reserve(buffer.size() + sizeof(header) + path.size() + tokens.size() * sizeof(TokenRecord));
+    appendRaw(&header, sizeof(header));
+    appendRaw(path.data(), path.size());
+
+    const char* begin = source.data();
+    const char* end = begin + source.size();
+    for (const Token& token : tokens) {
+        TokenRecord record{};
+        record.type = static_cast<uint8_t>(token.type);
+        bool inSource = token.lexeme.data() >= begin && token.lexeme.data() + token.lexeme.size() <= end;
+        record.offset = inSource ? static_cast<uint32_t>(token.lexeme.data() - begin) : NOT_IN_SOURCE;
+        record.length = inSource ? static_cast<uint32_t>(token.lexeme.size()) : 0;
+        record.line = static_cast<uint32_t>(lines.line(token.offset));
+        record.column = static_cast<uint32_t>(lines.column(token.offset));
+        appendRaw(&record, sizeof(record));
+    }
+}
+
+void OutputWriter::writeFile(std::string_view path, std::string_view source, const LineIndex& lines,
+                             const std::vector<Token>* tokens, size_t tokenCount, const SymbolTable& symbolTable, const ErrorHandler& errorHandler) {
+    if (tokens != nullptr) {
+        tokenCount = tokens->size();
+    }
+    size_t lexicalErrors = 0;
+    for (const Error& error : errorHandler.getErrors()) {
+        lexicalErrors += error.kind == ErrorKind::LEXICAL;
+    }
+    size_t syntaxErrors = errorHandler.getErrors().size() - lexicalErrors;
+
+    switch (format) {
+    case OutputFormat::TABLE:
+    case OutputFormat::NONE:
+        break;
+
+    case OutputFormat::SUMMARY:
+        buffer += path;
+        buffer += ": ";
+        appendNumber(source.size());
+        buffer += " bytes, ";
+        appendNumber(tokenCount);
+        buffer += " tokens, ";
+        appendNumber(symbolTable.getEntries().size());
+        buffer += " symbols, ";
+        appendNumber(lexicalErrors);
+        buffer += " lexical errors, ";
+        appendNumber(syntaxErrors);
+        buffer += " syntax errors\n";
+        break;
+
+    case OutputFormat::NDJSON:
+        if (tokens != nullptr) {
+            writeTokensNdjson(path, lines, *tokens);
+        }
+        for (const STEntry& entry : symbolTable.getEntries()) {
+            buffer += "{\"file\":";
+            appendJsonString(path);
+            buffer += ",\"kind\":\"symbol\",\"name\":";
+            appendJsonString(entry.name);
+            buffer += ",\"type\":";
+            appendJsonString(entry.dataType);
+            buffer += ",\"size\":";
+            appendNumber(entry.size);
+            buffer += ",\"dimension\":";
+            appendNumber(entry.dimension);
+            buffer += ",\"declLine\":";
+            appendNumber(entry.lineOfDeclaration);
+            buffer += ",\"usageLines\":[";
+            for (size_t i = 0; i < entry.linesOfUsage.size(); ++i) {
+                if (i > 0) {
+                    buffer += ',';
+                }
+                appendNumber(entry.linesOfUsage[i]);
+            }
+            buffer += "]}\n";
+        }
+        for (const Error& error : errorHandler.getErrors()) {
+            buffer += "{\"file\":";
+            appendJsonString(path);
+            buffer += ",\"kind\":\"error\",\"type\":";
+            appendJsonString(error.typeName());
+            buffer += ",\"line\":";
+            appendNumber(lines.line(error.offset));
+            buffer += ",\"column\":";
+            appendNumber(lines.column(error.offset));
+            buffer += ",\"message\":";
+            appendJsonString(error.message());
+            buffer += "}\n";
+        }
+        buffer += "{\"file\":";
+        appendJsonString(path);
+        buffer += ",\"kind\":\"summary\",\"bytes\":";
+        appendNumber(source.size());
+        buffer += ",\"tokens\":";
+        appendNumber(tokenCount);
+        buffer += ",\"symbols\":";
+        appendNumber(symbolTable.getEntries().size());
+        buffer += ",\"lexicalErrors\":";
+        appendNumber(lexicalErrors);
+        buffer += ",\"syntaxErrors\":";
+        appendNumber(syntaxErrors);
+        buffer += "}\n";
+        break;
+
+    case OutputFormat::CSV:
+        if (tokens != nullptr) {
+            writeTokensCsv(path, lines, *tokens);
+        }
+        for (const STEntry& entry : symbolTable.getEntries()) {
+            appendCsvField(path);
+            buffer += ",symbol,";
+            appendCsvField(entry.name);
+            buffer += ',';
+            appendCsvField(entry.dataType);
+            buffer += ',';
+            appendNumber(entry.lineOfDeclaration);
+            buffer += ",,"; // detail: usage lines separated by spaces
+            for (size_t i = 0; i < entry.linesOfUsage.size(); ++i) {
+                if (i > 0) {
+                    buffer += ' ';
+                }
+                appendNumber(entry.linesOfUsage[i]);
+            }
+            buffer += '\n';
+        }
+        for (const Error& error : errorHandler.getErrors()) {
+            appendCsvField(path);
+            buffer += ",error,,";
+            appendCsvField(error.typeName());
+            buffer += ',';
+            appendNumber(lines.line(error.offset));
+            buffer += ',';
+            appendNumber(lines.column(error.offset));
+            buffer += ',';
+            appendCsvField(error.message());
+            buffer += '\n';
+        }
+        break;
+
+    case OutputFormat::BINARY:
+        writeTokensBinary(path, source, lines, tokens != nullptr ? *tokens : std::vector<Token>());
+        break;
+    }
+}
+
+void OutputWriter::flush(std::ostream& out) {
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+    buffer.clear();
+}
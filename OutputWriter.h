@@ -0,0 +1,66 @@
+#ifndef OUTPUTWRITER_H
+#define OUTPUTWRITER_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Token.h"
+#include "SymbolTable.h"
+#include "ErrorHandler.h"
+#include "LineIndex.h"
+
+// How analysis results are printed.
+// TABLE is the original human-readable output (source echo, tokens table, symbol table, errors).
+// The others skip the echo and the tables and are meant for tools:
+//   NONE     nothing; the exit status tells whether there were errors
+//   SUMMARY  one line per file with its byte, token, symbol and error counts
+//   NDJSON   one JSON object per token, symbol, error and file summary ("kind" tells which)
+//   CSV      columns file,kind,name,type,line,column,detail for tokens, symbols and errors
+//   BINARY   compact token dump, see OutputWriter::writeTokensBinary
+enum class OutputFormat { TABLE, NONE, SUMMARY, NDJSON, CSV, BINARY };
+
+// Parses a --format value; returns false for an unknown name
+bool parseOutputFormat(std::string_view name, OutputFormat& format);
+
+// Formats results into one growing buffer, so nothing reaches the stream until flush(), which
+// writes it with a single call. clear() keeps the capacity, so the buffer can be reused.
+class OutputWriter {
+private:
+    OutputFormat format;
+    std::string buffer;
+
+    void appendNumber(uint64_t value);
+    void appendJsonString(std::string_view text);
+    void appendCsvField(std::string_view text);
+    void appendRaw(const void* data, size_t size);
+
+    void writeTokensNdjson(std::string_view path, const LineIndex& lines, const std::vector<Token>& tokens);
+    void writeTokensCsv(std::string_view path, const LineIndex& lines, const std::vector<Token>& tokens);
+    void writeTokensBinary(std::string_view path, std::string_view source, const LineIndex& lines,
+                           const std::vector<Token>& tokens);
+
+public:
+    explicit OutputWriter(OutputFormat format, size_t initialCapacity = 1 << 16);
+
+    // Starts the output (the CSV header row); call once, before the first file
+    void writeHeader();
+
+    // Appends everything the format shows for one analyzed file. tokens may be null (streamed,
+    // or answered from the cache), in which case no token records are written and tokenCount
+    // is used for the summary. lines indexes source, for the token and error positions.
+    void writeFile(std::string_view path, std::string_view source, const LineIndex& lines,
+                   const std::vector<Token>* tokens, size_t tokenCount, const SymbolTable& symbolTable,
+                   const ErrorHandler& errorHandler);
+
+    const std::string& contents() const { return buffer; }
+    std::string takeContents() { return std::move(buffer); }
+    void clear() { buffer.clear(); }
+
+    // Writes the buffer with one call, flushes the stream and clears the buffer
+    void flush(std::ostream& out = std::cout);
+};
+
+#endif
@@ -0,0 +1,134 @@
+// implementation of ParallelLexer.h
+
+#include "ParallelLexer.h"
+#include "Lexer.h"
+#include "LexerTables.h"
+#include "ThreadPool.h"
+#include "Stats.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Whether a line starting with c has a token in column 1 (it is not blank, indented or a comment)
+bool startsToken(char c) {
+    return c != '\n' && c != '#' && !LexerTables::hasFlag(c, LexerTables::CHAR_BLANK);
+}
+
+} // namespace
+
+ParallelLexer::ParallelLexer(std::string_view code, ErrorHandler& handler, size_t threadCount, size_t minChunkSize)
+    : sourceCode(code), errorHandler(handler), threadCount(std::max<size_t>(1, threadCount)),
+      minChunkSize(std::max<size_t>(1, minChunkSize)) {}
+
+// Cuts the source into roughly equal chunks, each ending just after a '\n' (except the last)
+// that is followed by a token in column 1
+std::vector<std::string_view> ParallelLexer::splitIntoChunks() const {
+    // A few chunks per thread evens out lines of very different lengths
+    size_t chunkCount = std::min(threadCount * 4, std::max<size_t>(1, sourceCode.size() / minChunkSize));
+    size_t targetSize = sourceCode.size() / chunkCount + 1;
+
+    std::vector<std::string_view> chunks;
+    size_t start = 0;
+    while (start < sourceCode.size()) {
+        size_t end = start + targetSize;
+        if (end >= sourceCode.size()) {
+            end = sourceCode.size();
+        } else {
+            do {
+                const void* newline = std::memchr(sourceCode.data() + end, '\n', sourceCode.size() - end);
+                end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - sourceCode.data()) + 1
+                              : sourceCode.size();
+            } while (end < sourceCode.size() && !startsToken(sourceCode[end]));
+        }
+        chunks.push_back(sourceCode.substr(start, end - start));
+        start = end;
+    }
+    return chunks;
+}
+
+std::vector<Token> ParallelLexer::tokenize() {
+    std::vector<std::string_view> chunks = splitIntoChunks();
+    if (chunks.size() <= 1 || threadCount == 1) {
+        Lexer lexer(sourceCode, errorHandler);
+        return lexer.tokenize();
+    }
+
+    // Lex every chunk as if it were the whole source; positions come out relative to the chunk
+    struct ChunkResult {
+        std::vector<Token> tokens;
+        ErrorHandler errors;
+        size_t openBrackets = 0; // At the end of the chunk
+    };
+    std::vector<ChunkResult> results(chunks.size());
+    ThreadPool pool(threadCount);
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        pool.submit([&, i] {
+            ChunkResult& result = results[i];
+            Lexer lexer(chunks[i], result.errors);
+            result.tokens = lexer.tokenize();
+            result.openBrackets = lexer.bracketDepth();
+            if (i + 1 < chunks.size()) {
+                result.tokens.pop_back(); // Only the last chunk's END_OF_FILE is real
+                Stats::uncountToken(TokenType::END_OF_FILE);
+            }
+        });
+    }
+    pool.wait();
+
+    // The chunks after one that ends inside brackets started on a continuation line, so from
+    // that one on the source is lexed again in one piece
+    for (size_t i = 0; i + 1 < chunks.size(); ++i) {
+        if (results[i].openBrackets == 0) {
+            continue;
+        }
+        for (size_t j = i; j < chunks.size(); ++j) {
+            for (const Token& token : results[j].tokens) {
+                Stats::uncountToken(token.type);
+            }
+            for (const Error& error : results[j].errors.getErrors()) {
+                Stats::uncountError(error.kind);
+            }
+            Stats::uncountBytes(chunks[j].size());
+        }
+        chunks[i] = sourceCode.substr(static_cast<size_t>(chunks[i].data() - sourceCode.data()));
+        chunks.resize(i + 1);
+        results.resize(i + 1);
+        results[i].errors = ErrorHandler();
+        Lexer lexer(chunks[i], results[i].errors);
+        results[i].tokens = lexer.tokenize();
+        break;
+    }
+
+    // Source offset and output position of each chunk
+    std::vector<size_t> byteOffsets(chunks.size());
+    std::vector<size_t> tokenOffsets(chunks.size());
+    size_t total = 0;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        byteOffsets[i] = static_cast<size_t>(chunks[i].data() - sourceCode.data());
+        tokenOffsets[i] = total;
+        total += results[i].tokens.size();
+    }
+
+    // Stitch: copy every chunk into place with its offsets shifted
+    std::vector<Token> tokens(total, Token(TokenType::UNKNOWN, "", 0));
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        pool.submit([&, i] {
+            Token* out = tokens.data() + tokenOffsets[i];
+            for (const Token& token : results[i].tokens) {
+                *out = token;
+                out->offset += byteOffsets[i];
+                ++out;
+            }
+        });
+    }
+
+    // Errors are few, so merge them in order on this thread meanwhile
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        errorHandler.appendErrors(results[i].errors, byteOffsets[i]);
+    }
+    pool.wait();
+    Stats::notePeakTokens(tokens.size());
+    return tokens;
+}
@@ -0,0 +1,40 @@
+#ifndef PARALLELLEXER_H
+#define PARALLELLEXER_H
+
+#include <string_view>
+#include <vector>
+
+#include "Token.h"
+#include "ErrorHandler.h"
+
+// Lexes one large source on several threads.
+// The buffer is split into chunks at the start of lines that begin with a token in column 1, each
+// chunk is lexed by its own Lexer (with its own ErrorHandler), and the results are stitched
+// together with their offsets shifted by where the chunk starts in the source.
+//
+// A chunk can never begin inside a token: string literals and comments both end at the first
+// '\n' (an unclosed string is reported as unterminated there). The lexer state that outlives a
+// line is the stack of open indentations and the count of open brackets (see Lexer.h). Outside
+// brackets a line in column 1 closes every block: the previous chunk's lexer emits the same
+// NEWLINE and DEDENTs at its end, at the same offset, as a sequential lexer does before that line.
+// Inside brackets the line continues the one before, which a chunk cannot see. A chunk that ends
+// with a bracket open (whose lexer cannot see whether the next line starts a statement and ends
+// the bracket's line) is therefore lexed again, together with everything after it, by one lexer.
+// Continuation lines are nearly always indented, so this is rare. The stitched tokens and errors
+// are identical to a sequential Lexer::tokenize().
+class ParallelLexer {
+private:
+    std::string_view sourceCode;
+    ErrorHandler& errorHandler;
+    size_t threadCount;
+    size_t minChunkSize; // Smaller inputs are not worth splitting
+
+    std::vector<std::string_view> splitIntoChunks() const;
+
+public:
+    ParallelLexer(std::string_view code, ErrorHandler& handler, size_t threadCount, size_t minChunkSize = 1 << 20);
+
+    std::vector<Token> tokenize();
+};
+
+#endif
@@ -0,0 +1,138 @@
+// implementation of ParallelParser.h
+
+#include "ParallelParser.h"
+#include "Parser.h"
+#include "ThreadPool.h"
+#include "Stats.h"
+
+#include <algorithm>
+
+ParallelParser::ParallelParser(const std::vector<Token>& tokens, const LineIndex& lines, SymbolTable& symTab,
+                               ErrorHandler& errHandler, size_t threadCount, size_t minPieceTokens)
+    : tokens(tokens), lines(lines), symbolTable(symTab), errorHandler(errHandler),
+      threadCount(std::max<size_t>(1, threadCount)), minPieceTokens(std::max<size_t>(1, minPieceTokens)) {}
+
+// Whether a top-level statement of an error-free program starts at tokens[i]; a token in column 1
+// that does not follow a NEWLINE or DEDENT is on a line joined inside brackets
+bool ParallelParser::startsStatement(size_t i) const {
+    TokenType type = tokens[i].type;
+    return !isLayoutToken(type) && type != TokenType::ELIF && type != TokenType::ELSE &&
+           type != TokenType::END_OF_FILE && isLayoutToken(tokens[i - 1].type) &&
+           lines.column(tokens[i].offset) == 1;
+}
+
+// Cuts the tokens into roughly equal pieces, each starting at a top-level statement
+std::vector<size_t> ParallelParser::splitIntoPieces() const {
+    size_t end = tokens.size() - 1;
+    size_t pieceCount = std::min(threadCount * 4, std::max<size_t>(1, tokens.size() / minPieceTokens));
+    size_t targetSize = tokens.size() / pieceCount + 1;
+
+    std::vector<size_t> bounds{0};
+    for (size_t next = targetSize; next < end; next = bounds.back() + targetSize) {
+        while (next < end && !startsStatement(next)) {
+            next++;
+        }
+        if (next == end) {
+            break;
+        }
+        bounds.push_back(next);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+// Adds a piece's names to the symbol table as its statements would have, had the pieces before
+// it been parsed first. False if the piece reads a name that nothing before it assigned.
+bool ParallelParser::mergeSymbols(const SymbolTable& piece) {
+    for (const STEntry& entry : piece.getEntries()) {
+        SymbolTable::SymTabPos pos = symbolTable.search(entry.name);
+        if (entry.lineOfDeclaration == 0) { // Read before the piece assigns it (see Parser::parsePiece)
+            if (pos == SymbolTable::SymTabPos::NOT_FOUND) {
+                return false;
+            }
+        } else if (pos == SymbolTable::SymTabPos::NOT_FOUND) {
+            symbolTable.insert(entry.name, entry.dataType, entry.size, entry.dimension, entry.lineOfDeclaration);
+            pos = static_cast<SymbolTable::SymTabPos>(symbolTable.getEntries().size() - 1);
+        } else {
+            symbolTable.addLineOfUsage(pos, entry.lineOfDeclaration); // An assignment to an earlier name
+        }
+        for (size_t line : entry.linesOfUsage) {
+            symbolTable.addLineOfUsage(pos, line);
+        }
+    }
+    return true;
+}
+
+void ParallelParser::parseSequentially() {
+    Parser parser(tokens, lines, symbolTable, errorHandler);
+    parser.parse();
+    ast = std::move(parser.getAst());
+}
+
+void ParallelParser::parse() {
+    std::vector<size_t> bounds = splitIntoPieces(); // Also builds the line table the pieces share
+    size_t pieceCount = bounds.size() - 1;
+    if (pieceCount <= 1 || threadCount == 1 || errorHandler.hasErrors()) {
+        parseSequentially();
+        return;
+    }
+
+    struct PieceResult {
+        SymbolTable symbols; // The piece's names, merged in source order afterwards
+        ErrorHandler errors;
+        Ast ast;
+        size_t at = 0; // Where its nodes go in the joined tree
+        bool clean = false;
+    };
+    std::vector<PieceResult> results(pieceCount);
+    ErrorPolicy piecePolicy; // Stops at the first error, at the same nesting limit
+    piecePolicy.maxNesting = errorHandler.getPolicy().maxNesting;
+    ThreadPool pool(threadCount);
+    for (size_t i = 0; i < pieceCount; ++i) {
+        pool.submit([&, i] {
+            PieceResult& result = results[i];
+            result.errors = ErrorHandler(piecePolicy);
+            LineIndex pieceLines = LineIndex::sharedWith(lines); // Only the lookup hint is per thread
+            Parser parser(tokens, pieceLines, result.symbols, result.errors);
+            result.clean = parser.parsePiece(bounds[i], bounds[i + 1]);
+            result.ast = std::move(parser.getAst());
+        });
+    }
+    pool.wait();
+
+    bool clean = std::all_of(results.begin(), results.end(), [](const PieceResult& result) { return result.clean; });
+    std::vector<int> journal;
+    symbolTable.setJournal(&journal);
+    for (size_t i = 0; clean && i < pieceCount; ++i) {
+        clean = mergeSymbols(results[i].symbols);
+    }
+    symbolTable.setJournal(nullptr);
+    if (!clean) {
+        for (auto it = journal.rbegin(); it != journal.rend(); ++it) {
+            symbolTable.undoLast(static_cast<SymbolTable::SymTabPos>(*it));
+        }
+        for (const PieceResult& result : results) {
+            for (const Error& error : result.errors.getErrors()) {
+                Stats::uncountError(error.kind); // Reported again by the sequential parse
+            }
+        }
+        parseSequentially();
+        return;
+    }
+
+    // The first piece's tree becomes the joined one; the others are copied in parallel
+    ast = std::move(results[0].ast);
+    size_t nodeCount = ast.size();
+    for (size_t i = 1; i < pieceCount; ++i) {
+        nodeCount += results[i].ast.size() - 1;
+    }
+    ast.reserve(nodeCount);
+    for (size_t i = 1; i < pieceCount; ++i) {
+        results[i].at = ast.reserveProgram(results[i].ast);
+        pool.submit([&, i] { ast.copyProgram(results[i].ast, results[i].at); });
+    }
+    pool.wait();
+    for (size_t i = 1; i < pieceCount; ++i) {
+        ast.linkProgram(results[i].ast, results[i].at);
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef PARALLELPARSER_H
+#define PARALLELPARSER_H
+
+#include <vector>
+
+#include "Token.h"
+#include "LineIndex.h"
+#include "SymbolTable.h"
+#include "ErrorHandler.h"
+#include "AST.h"
+
+// Parses one large token vector on several threads.
+// The tokens are split into pieces at top-level statements, i.e. at a token in column 1 right
+// after a NEWLINE or DEDENT (other than 'elif'/'else', which continue an 'if'), where the lexer
+// has closed every block and bracket (see Lexer.h). Each piece is parsed by its own Parser into its own tree (Parser::parsePiece),
+// and the trees are joined in source order (see Ast::reserveProgram), copying them in parallel.
+//
+// A piece cannot know the names the pieces before it assign, so it enters the names it reads
+// before assigning them instead of reporting them as undeclared. The pieces' symbol tables are
+// then merged in source order: a name read before its piece assigns it must already be in the
+// merged table. If a piece has an error, or a name turns out to be read before any assignment,
+// the program is parsed again by one Parser, so the errors, and where parsing stops, are exactly
+// those of Parser::parse(). The tree and symbol table always equal a sequential parse.
+class ParallelParser {
+private:
+    const std::vector<Token>& tokens;
+    const LineIndex& lines;
+    SymbolTable& symbolTable;
+    ErrorHandler& errorHandler;
+    size_t threadCount;
+    size_t minPieceTokens; // Smaller inputs are not worth splitting
+    Ast ast;
+
+    bool startsStatement(size_t i) const;
+    std::vector<size_t> splitIntoPieces() const; // First token of every piece, then the END_OF_FILE index
+    bool mergeSymbols(const SymbolTable& piece);
+    void parseSequentially();
+
+public:
+    ParallelParser(const std::vector<Token>& tokens, const LineIndex& lines, SymbolTable& symTab,
+                   ErrorHandler& errHandler, size_t threadCount, size_t minPieceTokens = 1 << 16);
+
+    // Same results as Parser::parse()
+    void parse();
+
+    // The tree built by parse()
+    const Ast& getAst() const { return ast; }
+    Ast& getAst() { return ast; }
+};
+
+#endif
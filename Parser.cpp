@@ -1,87 +1,82 @@
 #include "Parser.h"
-#include <iostream>
+#include "Stats.h" // TOKEN_TYPE_COUNT
+#include <array>
 #include <stdexcept> // For std::runtime_error
 
-// Returns the current token
-Token Parser::currentToken() const {
-    if (currentTokenIndex < tokens.size()) {
-        return tokens[currentTokenIndex];
+namespace {
+
+// Python's levels; 'not' is a prefix operator between 'and' and the comparisons
+const uint8_t NOT_PRECEDENCE = 3;
+const uint8_t COMPARISON_PRECEDENCE = 4;
+
+// Precedence of each binary operator, by token type; 0 for every other token
+constexpr std::array<uint8_t, Stats::TOKEN_TYPE_COUNT> BINARY_PRECEDENCE = [] {
+    std::array<uint8_t, Stats::TOKEN_TYPE_COUNT> table{};
+    auto set = [&table](TokenType type, uint8_t precedence) { table[static_cast<size_t>(type)] = precedence; };
+    set(TokenType::OR, 1);
+    set(TokenType::AND, 2);
+    for (TokenType type : {TokenType::EQUAL_EQUAL, TokenType::NOT_EQUAL, TokenType::LESS_THAN, TokenType::LESS_EQUAL,
+                           TokenType::GREATER_THAN, TokenType::GREATER_EQUAL}) {
+        set(type, COMPARISON_PRECEDENCE);
     }
-    // Return an EOF (end of file) token if we're past the end
-    return Token(TokenType::END_OF_FILE, "EOF", tokens.back().lineNumber, tokens.back().columnNumber);
-}
+    set(TokenType::PLUS, 5);
+    set(TokenType::MINUS, 5);
+    set(TokenType::MULTIPLY, 6);
+    set(TokenType::DIVIDE, 6);
+    set(TokenType::MODULO, 6);
+    return table;
+}();
 
-// Peeks at the next token without consuming and moving on
-Token Parser::peekNextToken() const {
-    if (currentTokenIndex + 1 < tokens.size()) {
-        return tokens[currentTokenIndex + 1];
-    }
-    return Token(TokenType::END_OF_FILE, "EOF", tokens.back().lineNumber, tokens.back().columnNumber);
+// ExpressionFrame::op before the frame has read its operator
+const Token NO_OPERATOR(TokenType::UNKNOWN, "", 0);
+
+} // namespace
+
+// Returns the current token
+// (the cursor keeps returning the EOF (end of file) token once we're past the end)
+const Token& Parser::currentToken() const {
+    return cursor.current();
 }
 
-// Consumes the current token if it matches the expected type, otherwise reports an error
-Token Parser::consume(TokenType expectedType) {
-    Token current = currentToken();
+// Consumes the current token if it matches the expected type, otherwise reports an error.
+// The reference stays valid until the cursor next reads a token (see TokenCursor.h). On a
+// mismatch it is the offending token, and statementFailed() is true.
+const Token& Parser::consume(TokenType expectedType) {
+    const Token& current = currentToken();
     if (current.type == expectedType) {
-        currentTokenIndex++;
+        cursor.advance();
         return current;
-    } else {
-        std::string expectedTypeName;
-        switch (expectedType) {
-            case TokenType::IDENTIFIER: expectedTypeName = "IDENTIFIER"; break;
-            case TokenType::ASSIGN: expectedTypeName = "ASSIGN (=)"; break;
-            case TokenType::LPAREN: expectedTypeName = "LPAREN"; break;
-            case TokenType::RPAREN: expectedTypeName = "RPAREN"; break;
-            case TokenType::COLON: expectedTypeName = "COLON"; break;
-            case TokenType::END_OF_FILE: expectedTypeName = "END_OF_FILE"; break;
-            case TokenType::IF: expectedTypeName = "IF"; break;
-            case TokenType::ELSE: expectedTypeName = "ELSE"; break;
-            case TokenType::ELIF: expectedTypeName = "ELIF"; break;
-            case TokenType::WHILE: expectedTypeName = "WHILE"; break;
-            case TokenType::FOR: expectedTypeName = "FOR"; break;
-            case TokenType::PRINT: expectedTypeName = "PRINT"; break;
-            case TokenType::INPUT: expectedTypeName = "INPUT"; break;
-            case TokenType::PLUS: expectedTypeName = "PLUS (+)"; break;
-            case TokenType::MINUS: expectedTypeName = "MINUS (-)"; break;
-            case TokenType::MULTIPLY: expectedTypeName = "MULTIPLY (*)"; break;
-            case TokenType::DIVIDE: expectedTypeName = "DIVIDE (/)"; break;
-            case TokenType::MODULO: expectedTypeName = "MODULO (%)"; break;
-            case TokenType::EQUAL_EQUAL: expectedTypeName = "EQUAL_EQUAL (==)"; break;
-            case TokenType::NOT_EQUAL: expectedTypeName = "NOT_EQUAL (!=)"; break;
-            case TokenType::LESS_THAN: expectedTypeName = "LESS_THAN (<)"; break;
-            case TokenType::LESS_EQUAL: expectedTypeName = "LESS_EQUAL (<=)"; break;
-            case TokenType::GREATER_THAN: expectedTypeName = "GREATER_THAN (>)"; break;
-            case TokenType::GREATER_EQUAL: expectedTypeName = "GREATER_EQUAL (>=)"; break;
-            case TokenType::AND: expectedTypeName = "AND"; break;
-            case TokenType::OR: expectedTypeName = "OR"; break;
-            case TokenType::NOT: expectedTypeName = "NOT"; break;
-            case TokenType::INTEGER_LITERAL: expectedTypeName = "INTEGER_LITERAL"; break;
-            case TokenType::FLOAT_LITERAL: expectedTypeName = "FLOAT_LITERAL"; break;
-            case TokenType::STRING_LITERAL: expectedTypeName = "STRING_LITERAL"; break;
-            case TokenType::BOOLEAN_LITERAL: expectedTypeName = "BOOLEAN_LITERAL"; break;
-            // can add more cases
-            default: expectedTypeName = "UNKNOWN_EXPECTED_TYPE"; break;
-        }
+    }
+    syntaxError(current, ErrorCode::EXPECTED_TOKEN, expectedType);
+    // Advance past the error token. When recovering, the statement is abandoned anyway, and the
+    // token may well start the next statement.
+    if (!recover) {
+        cursor.advance();
+    }
+    return current;
+}
 
-        syntaxError("Expected " + expectedTypeName +
-                    " but found '" + current.lexeme + "' (type: " +
-                    std::to_string(static_cast<int>(current.type)) + ")");
-        currentTokenIndex++; // Advance past the error token
-        return Token(TokenType::UNKNOWN, "ERROR", current.lineNumber, current.columnNumber); // Return an error token
+// consume() for callers that do not need the token back, which saves assembling it when the
+// tokens are in a TokenBuffer
+void Parser::expect(TokenType expectedType) {
+    if (cursor.currentType() == expectedType) {
+        cursor.advance();
+    } else {
+        consume(expectedType);
     }
 }
 
 // Checks if the current token matches the expected type without consuming
 bool Parser::match(TokenType expectedType) {
-    return currentToken().type == expectedType;
+    return cursor.currentType() == expectedType;
 }
 
 
 // Skip tokens until a likely statement boundary is found.
 // This attempts to find a token that typically starts a new statement.
 void Parser::synchronize() {
-    while (currentToken().type != TokenType::END_OF_FILE) {
-        switch (currentToken().type) {
+    while (cursor.currentType() != TokenType::END_OF_FILE) {
+        switch (cursor.currentType()) {
             case TokenType::IF:
             case TokenType::WHILE:
             case TokenType::FOR:
@@ -91,71 +86,228 @@ void Parser::synchronize() {
                 return;
             default:
                 // Skip the current token and check the next one
-                currentTokenIndex++;
+                cursor.advance();
                 break;
         }
     }
 }
 
-// Reports a syntax error using the error handler
-void Parser::syntaxError(const std::string& message) {
-    errorHandler.reportError(message, currentToken().lineNumber, currentToken().columnNumber, "Syntax");
+// Reports a syntax error at a token using the error handler. When recovering, only the first
+// error of a statement is kept: the rest are almost always follow-on errors of the same mistake.
+void Parser::syntaxError(const Token& at, ErrorCode code, TokenType expected) {
+    if (recover && statementFailed()) {
+        return;
+    }
+    errorHandler.reportError(ErrorKind::SYNTAX, code, at.lexeme, at.offset, expected, at.type);
 }
 
-// Constructor
-Parser::Parser(const std::vector<Token>& tokens, SymbolTable& symTab, ErrorHandler& errHandler)
-    : tokens(tokens), currentTokenIndex(0), symbolTable(symTab), errorHandler(errHandler) {}
+// TOO_DEEPLY_NESTED at the INDENT or '(' that would go past the limit
+void Parser::nestingError(const Token& at) {
+    tooDeep = true;
+    if (recover && statementFailed()) {
+        return;
+    }
+    errorHandler.reportError(ErrorKind::SYNTAX, ErrorCode::TOO_DEEPLY_NESTED, std::to_string(maxNesting), at.offset,
+                             TokenType::UNKNOWN, at.type);
+}
+
+// True once the statement being parsed has reported an error (errors before it do not count)
+bool Parser::statementFailed() const {
+    return errorHandler.reportedCount() > statementErrorMark;
+}
+
+// Recovery between top-level statements: skips to the first token of a later line that starts
+// in column 1 and follows a line break, where the next top-level statement begins (the DEDENTs
+// before it, which share its offset, are skipped too). The break is a physical one, found from the
+// offsets, so recovery does not depend on the lexer having ended the line: a line joined inside a
+// bracket that was never closed can still be the place to go on from. Leftover 'elif'/'else'
+// lines of a failed 'if' are skipped as well.
+void Parser::skipToNextStatement(size_t failedLine) {
+    size_t previousLine = 0; // The token before the cursor is gone; take it as a line break
+    while (cursor.currentType() != TokenType::END_OF_FILE) {
+        size_t offset = cursor.currentOffset();
+        TokenType type = cursor.currentType();
+        size_t line = lines.line(offset);
+        if (line > failedLine && line > previousLine && lines.column(offset) == 1 && !isLayoutToken(type) &&
+            type != TokenType::ELIF && type != TokenType::ELSE) {
+            return;
+        }
+        if (!isLayoutToken(type)) {
+            previousLine = line;
+        }
+        cursor.advance();
+    }
+}
 
-// Main Parsin
+// Constructor
+Parser::Parser(const std::vector<Token>& tokens, const LineIndex& lines, SymbolTable& symTab, ErrorHandler& errHandler)
+    : cursor(tokens), lines(lines), symbolTable(symTab), errorHandler(errHandler), statementErrorMark(0),
+      recover(errHandler.getPolicy().recover), piece(false), nesting(0),
+      maxNesting(errHandler.getPolicy().maxNesting), tooDeep(false) {}
+
+Parser::Parser(const TokenBuffer& tokens, const LineIndex& lines, SymbolTable& symTab, ErrorHandler& errHandler)
+    : cursor(tokens), lines(lines), symbolTable(symTab), errorHandler(errHandler), statementErrorMark(0),
+      recover(errHandler.getPolicy().recover), piece(false), nesting(0),
+      maxNesting(errHandler.getPolicy().maxNesting), tooDeep(false) {}
+
+Parser::Parser(Lexer& lexer, const LineIndex& lines, SymbolTable& symTab, ErrorHandler& errHandler)
+    : cursor(lexer), lines(lines), symbolTable(symTab), errorHandler(errHandler), statementErrorMark(0),
+      recover(errHandler.getPolicy().recover), piece(false), nesting(0),
+      maxNesting(errHandler.getPolicy().maxNesting), tooDeep(false) {}
+
+// Main Parsin (prints nothing, so parsers can run side by side; errors go to the ErrorHandler)
 void Parser::parse() {
-    std::cout << "\nStarting syntax analysis..." << std::endl;
-    parseProgram();
-    if (errorHandler.hasErrors()) {
-        std::cout << "Syntax analysis completed with errors." << std::endl;
-    } else {
-        std::cout << "Syntax analysis completed successfully." << std::endl;
+    ast.clear();
+    ast.setRoot(parseProgram());
+}
+
+bool Parser::parsePiece(size_t begin, size_t end) {
+    piece = true;
+    ast.clear();
+    cursor.seek(begin);
+    NodeId program = ast.addNode(NodeKind::Program, TokenType::UNKNOWN, "", currentLine());
+    while (cursor.position() < end && cursor.currentType() != TokenType::END_OF_FILE && !errorHandler.hasErrors()) {
+        ast.appendChild(program, parseTopLevelStatement());
     }
+    ast.setRoot(program);
+    piece = false;
+    return !errorHandler.hasErrors() && cursor.position() == end;
 }
 
 // GRAMMAR RULE IMPLEMENTATION
+// Each rule returns the node it built, or NO_NODE if it failed before it could build one.
+
+// Program: Statement* END_OF_FILE. Every statement ends with a NEWLINE (see Lexer.h).
+// Parsing stops at the first error, unless the ErrorPolicy asks for recovery: then a failed
+// statement is skipped and parsing goes on until an error past the limit has been dropped, so
+// a file with exactly maxErrors errors is checked to the end.
+NodeId Parser::parseProgram() {
+    NodeId program = ast.addNode(NodeKind::Program, TokenType::UNKNOWN, "", currentLine());
+    while (cursor.currentType() != TokenType::END_OF_FILE &&
+           !(recover ? errorHandler.droppedErrors() > 0 : errorHandler.hasErrors())) {
+        size_t line = currentLine();
+        ast.appendChild(program, parseTopLevelStatement());
+        if (recover && statementFailed()) {
+            skipToNextStatement(line);
+        }
+    }
+    return program;
+}
+
+NodeId Parser::parseTopLevelStatement() {
+    statementErrorMark = errorHandler.reportedCount();
+    tooDeep = false;
+    return parseStatement();
+}
+
+NodeId Parser::parseTopLevelStatementAt(size_t tokenIndex) {
+    cursor.seek(tokenIndex);
+    return parseTopLevelStatement();
+}
 
-// Python uses newline to separate statements. For simplification, we will assume a newline or EOF signifies an end of a statement.
-void Parser::parseProgram() {
-    while (currentToken().type != TokenType::END_OF_FILE && !errorHandler.hasErrors()) {
-        parseStatement();
-        // After parsing a statement, consume any trailing newlines.
-        // Indentation is currently not yet handled
-        while (match(TokenType::END_OF_FILE) == false && tokens[currentTokenIndex].lexeme == "\n") {
-            currentTokenIndex++; // Consume newline
+// Statement: ConditionalStatement | IterativeStatement | SimpleStatement
+// Blocks nest without recursion: every if / while / for and every indented block being parsed
+// is a frame on statementStack, and the steps below (see StatementStep) run until the statement
+// that was started here is done.
+NodeId Parser::parseStatement() {
+    size_t base = statementStack.size();
+    NodeId value = NO_NODE;
+    StatementStep step = StatementStep::START;
+    for (;;) {
+        switch (step) {
+            case StatementStep::START: step = startStatement(value); break;
+            case StatementStep::OPEN_BODY: step = openBody(value); break;
+            case StatementStep::NEXT_IN_BLOCK: step = nextInBlock(value); break;
+            case StatementStep::RETURN:
+                if (statementStack.size() == base) {
+                    return value;
+                }
+                step = resume(value);
+                break;
         }
     }
 }
 
-// Statements: DeclarativeStatement | AssignmentStatement | ArithmeticOperation |
-//              ConditionalStatement | IterativeStatement | PrintStatement | InputStatement
-void Parser::parseStatement() {
-    // Check for each possible statement type based on the lookahead (peek) token.
+// ConditionalStatement: "if" Expression ":" Block ("elif" Expression ":" Block)* ["else" ":" Block]
+// IterativeStatement: "while" Expression ":" Block | "for" IDENTIFIER "in" IDENTIFIER_OR_RANGE_CALL ":" Block
+// Parses the header of a compound statement and pushes its frame, or a whole simple statement
+Parser::StatementStep Parser::startStatement(NodeId& value) {
     if (match(TokenType::IF)) {
-        parseConditionalStatement();
-    } else if (match(TokenType::WHILE) || match(TokenType::FOR)) {
-        parseIterativeStatement();
-    } else if (match(TokenType::PRINT)) {
-        parsePrintStatement();
+        value = ast.addNode(NodeKind::If, TokenType::IF, "", currentLine());
+        expect(TokenType::IF);
+        if (statementFailed()) { synchronize(); return StatementStep::RETURN; }
+        ast.appendChild(value, parseExpression()); // Condition for 'if'
+        expect(TokenType::COLON);
+        if (statementFailed()) { synchronize(); return StatementStep::RETURN; }
+        statementStack.push_back({value, NodeKind::If, false});
+        return StatementStep::OPEN_BODY;
+    } else if (match(TokenType::WHILE)) {
+        value = ast.addNode(NodeKind::While, TokenType::WHILE, "", currentLine());
+        expect(TokenType::WHILE);
+        if (statementFailed()) { synchronize(); return StatementStep::RETURN; }
+        ast.appendChild(value, parseExpression()); // Loop condition
+        expect(TokenType::COLON);
+        if (statementFailed()) { synchronize(); return StatementStep::RETURN; }
+        statementStack.push_back({value, NodeKind::While, false});
+        return StatementStep::OPEN_BODY;
+    } else if (match(TokenType::FOR)) {
+        value = NO_NODE;
+        expect(TokenType::FOR);
+        if (statementFailed()) { synchronize(); return StatementStep::RETURN; }
+        Token loopVar = consume(TokenType::IDENTIFIER); // A copy: the cursor moves on before the For node is done
+        if (statementFailed()) { synchronize(); return StatementStep::RETURN; }
+        value = ast.addNode(NodeKind::For, TokenType::FOR, loopVar.lexeme, lineOf(loopVar));
+
+        SymbolTable::SymTabPos pos = symbolTable.search(loopVar.lexeme);
+        if (pos == SymbolTable::SymTabPos::NOT_FOUND) {
+            symbolTable.insert(loopVar.lexeme, "dynamic", 0, 0, lineOf(loopVar));
+        } else {
+            symbolTable.addLineOfUsage(pos, lineOf(loopVar));
+        }
+        syntaxError(currentToken(), ErrorCode::FOR_NOT_SUPPORTED);
+        synchronize(); // Basic error recovery to advance
+
+        expect(TokenType::COLON);
+        if (statementFailed()) { synchronize(); return StatementStep::RETURN; }
+        statementStack.push_back({value, NodeKind::For, false});
+        return StatementStep::OPEN_BODY;
+    }
+    value = parseSimpleStatement();
+    return StatementStep::RETURN;
+}
+
+// SimpleStatement: (AssignmentStatement | ArithmeticOperation | PrintStatement | InputStatement) NEWLINE
+NodeId Parser::parseSimpleStatement() {
+    NodeId statement = parseLine();
+    if (!statementFailed()) {
+        expect(TokenType::NEWLINE);
+    }
+    return statement;
+}
+
+// The part of a simple statement before its NEWLINE
+NodeId Parser::parseLine() {
+    if (match(TokenType::PRINT)) {
+        return parsePrintStatement();
     } else if (match(TokenType::INPUT)) {
-        parseInputStatement();
+        return parseInputStatement();
     } else if (match(TokenType::IDENTIFIER)) {
         // If it's an IDENTIFIER, it could be an assignment or part of an expression.
         // Look at the next token to differentiate.
-        if (peekNextToken().type == TokenType::ASSIGN) {
-            parseAssignmentStatement();
+        if (cursor.peekType() == TokenType::ASSIGN) {
+            return parseAssignmentStatement();
         } else {
             // Assume it's an expression statement (like "a + b", which is valid)
-            parseExpression();
+            size_t line = currentLine();
+            NodeId statement = ast.addNode(NodeKind::ExprStmt, TokenType::UNKNOWN, "", line);
+            ast.appendChild(statement, parseExpression());
+            return statement;
         }
     } else {
         // If it doesn't match any known statement start, it's a syntax error.
-        syntaxError("Unexpected token at start of statement: '" + currentToken().lexeme + "'");
+        syntaxError(currentToken(), match(TokenType::INDENT) ? ErrorCode::UNEXPECTED_INDENT : ErrorCode::UNEXPECTED_TOKEN);
         synchronize(); // Attempt to recover
+        return NO_NODE;
     }
 }
 
@@ -165,190 +317,338 @@ void Parser::parseDeclarativeStatement() {
 }
 
 // AssignmentStatement that uses IDENTIFIER "=" Expression
-void Parser::parseAssignmentStatement() {
-    Token identifier = consume(TokenType::IDENTIFIER);
-    if (errorHandler.hasErrors()) { synchronize(); return; } // Error recovery
+NodeId Parser::parseAssignmentStatement() {
+    Token identifier = consume(TokenType::IDENTIFIER); // A copy, still needed after the '='
+    if (statementFailed()) { synchronize(); return NO_NODE; } // Error recovery
 
     // If identifier not found, declare it with a generic type (dynamic)
-    if (symbolTable.search(identifier.lexeme) == SymbolTable::SymTabPos::NOT_FOUND) {
-        symbolTable.insert(identifier.lexeme, "dynamic", 0, 0, identifier.lineNumber);
+    SymbolTable::SymTabPos pos = symbolTable.search(identifier.lexeme);
+    if (pos == SymbolTable::SymTabPos::NOT_FOUND) {
+        symbolTable.insert(identifier.lexeme, "dynamic", 0, 0, lineOf(identifier));
     } else {
         // If already exists, record usage
-        symbolTable.addLineOfUsage(identifier.lexeme, identifier.lineNumber);
+        symbolTable.addLineOfUsage(pos, lineOf(identifier));
     }
 
-    consume(TokenType::ASSIGN);
-    if (errorHandler.hasErrors()) { synchronize(); return; }
+    expect(TokenType::ASSIGN);
+    if (statementFailed()) { synchronize(); return NO_NODE; }
 
-    parseExpression(); // Parse the value being assigned
+    NodeId assignment = ast.addNode(NodeKind::Assign, TokenType::ASSIGN, identifier.lexeme, lineOf(identifier));
+    ast.appendChild(assignment, parseExpression()); // Parse the value being assigned
+    return assignment;
 }
 
 // ArithmeticOperation -> Expression
-void Parser::parseArithmeticOperation() {
-    parseExpression();
+NodeId Parser::parseArithmeticOperation() {
+    return parseExpression();
 }
 
-void Parser::parseConditionalStatement() {
-    consume(TokenType::IF);
-    if (errorHandler.hasErrors()) { synchronize(); return; }
-    parseExpression(); // Condition for 'if'
-    consume(TokenType::COLON);
-    if (errorHandler.hasErrors()) { synchronize(); return; }
-    parseStatement(); // IF body
-    // Handle 'elif'
-    while (match(TokenType::ELIF)) {
-        consume(TokenType::ELIF);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        parseExpression(); // Condition for 'elif'
-        consume(TokenType::COLON);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        parseStatement(); // ELIF body
+// Block: SimpleStatement | NEWLINE INDENT Statement+ DEDENT
+// The body of an if/elif/else/while/for, after its ':'. It is either one simple statement on the
+// same line or the indented lines that follow, which get a frame of their own.
+Parser::StatementStep Parser::openBody(NodeId& value) {
+    bool indented = match(TokenType::NEWLINE);
+    if (indented) {
+        expect(TokenType::NEWLINE);
+        if (!match(TokenType::INDENT)) {
+            syntaxError(currentToken(), ErrorCode::EXPECTED_BLOCK);
+            synchronize();
+            value = NO_NODE;
+            return StatementStep::RETURN;
+        }
+        if (nesting >= maxNesting) {
+            nestingError(currentToken());
+            synchronize();
+            value = NO_NODE;
+            return StatementStep::RETURN;
+        }
+        expect(TokenType::INDENT);
     }
-
-    // Handle 'else'
-    if (match(TokenType::ELSE)) {
-        consume(TokenType::ELSE);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        consume(TokenType::COLON);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        parseStatement(); // ELSE body
+    value = ast.addNode(NodeKind::Block, TokenType::UNKNOWN, "", currentLine());
+    if (!indented) {
+        ast.appendChild(value, parseSimpleStatement());
+        return StatementStep::RETURN;
     }
+    statementStack.push_back({value, NodeKind::Block, false});
+    nesting++;
+    return StatementStep::NEXT_IN_BLOCK;
 }
 
-// IterativeStatement: "while" Expression ":" StatementBlock | "for" IDENTIFIER "in" IDENTIFIER_OR_RANGE_CALL ":" StatementBlock
-void Parser::parseIterativeStatement() {
-    if (match(TokenType::WHILE)) {
-        consume(TokenType::WHILE);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        parseExpression(); // Loop condition
-        consume(TokenType::COLON);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        parseStatement(); // WHILE body
-    } else if (match(TokenType::FOR)) {
-        consume(TokenType::FOR);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        Token loopVar = consume(TokenType::IDENTIFIER);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
+Parser::StatementStep Parser::nextInBlock(NodeId& value) {
+    if (!match(TokenType::DEDENT) && !match(TokenType::END_OF_FILE)) {
+        return StatementStep::START;
+    }
+    expect(TokenType::DEDENT);
+    value = statementStack.back().node;
+    statementStack.pop_back();
+    nesting--;
+    return StatementStep::RETURN;
+}
 
-        if (symbolTable.search(loopVar.lexeme) == SymbolTable::SymTabPos::NOT_FOUND) {
-            symbolTable.insert(loopVar.lexeme, "dynamic", 0, 0, loopVar.lineNumber);
-        } else {
-            symbolTable.addLineOfUsage(loopVar.lexeme, loopVar.lineNumber);
+// A block takes its statements until one fails. An if takes its blocks, and after each one
+// that parsed cleanly reads the next 'elif' or 'else' header.
+Parser::StatementStep Parser::resume(NodeId& value) {
+    StatementFrame& frame = statementStack.back();
+    ast.appendChild(frame.node, value);
+    value = frame.node;
+    if (frame.kind == NodeKind::Block) {
+        if (!statementFailed()) {
+            return StatementStep::NEXT_IN_BLOCK;
+        }
+        statementStack.pop_back();
+        nesting--;
+        return StatementStep::RETURN;
+    }
+    if (frame.kind == NodeKind::If && !frame.inElse && !statementFailed()) {
+        if (match(TokenType::ELIF)) {
+            expect(TokenType::ELIF);
+            if (statementFailed()) { synchronize(); statementStack.pop_back(); return StatementStep::RETURN; }
+            ast.appendChild(value, parseExpression()); // Condition for 'elif'
+            expect(TokenType::COLON);
+            if (statementFailed()) { synchronize(); statementStack.pop_back(); return StatementStep::RETURN; }
+            return StatementStep::OPEN_BODY;
+        } else if (match(TokenType::ELSE)) {
+            expect(TokenType::ELSE);
+            if (statementFailed()) { synchronize(); statementStack.pop_back(); return StatementStep::RETURN; }
+            expect(TokenType::COLON);
+            if (statementFailed()) { synchronize(); statementStack.pop_back(); return StatementStep::RETURN; }
+            ast.node(value).flags |= HAS_ELSE;
+            frame.inElse = true;
+            return StatementStep::OPEN_BODY;
         }
-        syntaxError("Simple 'for' loop syntax `for IDENTIFIER in ITERABLE` not fully implemented. Expected 'in' followed by iterable.");
-        synchronize(); // Basic error recovery to advance
-
-        consume(TokenType::COLON);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        parseStatement(); // FOR body
-    } else {
-        // This case should ideally not be reached if the outer `parseStatement` correctly directs here.
-        syntaxError("Internal error: Expected 'while' or 'for'.");
-        synchronize();
     }
+    statementStack.pop_back();
+    return StatementStep::RETURN;
 }
 
-// Expression: Comparison (("and" | "or") Comparison)*
-void Parser::parseExpression() {
-    parseComparison();
-    while (match(TokenType::AND) || match(TokenType::OR)) {
-        consume(currentToken().type); // Consume 'and' or 'or'
-        parseComparison();
+// Builds a Binary node over left and right, or returns left alone if the right side failed
+NodeId Parser::makeBinary(const Token& op, NodeId left, NodeId right) {
+    if (left == NO_NODE || right == NO_NODE) {
+        return left == NO_NODE ? right : left;
     }
+    NodeId binary = ast.addNode(NodeKind::Binary, op.type, op.lexeme, lineOf(op));
+    ast.appendChild(binary, left);
+    ast.appendChild(binary, right);
+    return binary;
 }
 
-// Comparison: ArithmeticExpression ( ("==" | "!=" | "<" | "<=" | ">" | ">=") ArithmeticExpression )*
-void Parser::parseComparison() {
-    parseArithmeticExpression();
-    while (match(TokenType::EQUAL_EQUAL) || match(TokenType::NOT_EQUAL) ||
-           match(TokenType::LESS_THAN) || match(TokenType::LESS_EQUAL) ||
-           match(TokenType::GREATER_THAN) || match(TokenType::GREATER_EQUAL)) {
-        consume(currentToken().type); // Consume the comparison operator
-        parseArithmeticExpression();
+// Adds `op right` to a comparison chain, as Python reads it: a < b < c is a < b and b < c with b
+// evaluated once. left is the chain so far and middle the right operand of its last comparison.
+// middle is copied into the new comparison, which is only exact because expressions other than
+// input() have no side effects; input() there is reported instead of being read twice.
+NodeId Parser::chainComparison(const Token& op, NodeId left, NodeId middle, NodeId right) {
+    if (left == NO_NODE || middle == NO_NODE || right == NO_NODE) {
+        return left == NO_NODE ? right : left;
+    }
+    bool readsInput = false;
+    ast.walk(middle, [&](NodeId id, size_t) {
+        readsInput = readsInput || ast.node(id).kind == NodeKind::Input;
+        return !readsInput;
+    });
+    if (readsInput) {
+        if (!(recover && statementFailed())) {
+            errorHandler.reportError(ErrorKind::SYNTAX, ErrorCode::MESSAGE,
+                                     "input() in the middle of a chained comparison is not supported", op.offset,
+                                     TokenType::UNKNOWN, op.type);
+        }
+        return left;
     }
+    NodeId link = makeBinary(op, ast.copySubtree(middle), right);
+    NodeId both = ast.addNode(NodeKind::Binary, TokenType::AND, "and", lineOf(op));
+    ast.appendChild(both, left);
+    ast.appendChild(both, link);
+    return both;
 }
 
-// ArithmeticExpression: Term ( ("+" | "-") Term )*
-void Parser::parseArithmeticExpression() {
-    parseTerm();
-    while (match(TokenType::PLUS) || match(TokenType::MINUS)) {
-        consume(currentToken().type); // Consume "+" or "-"
-        parseTerm();
+// Expression: Factor (BinaryOperator Factor)*, grouped by the precedence table as in Python:
+//   "or"  <  "and"  <  "not" (prefix)  <  "==" "!=" "<" "<=" ">" ">="  <  "+" "-"  <  "*" "/" "%"
+// The arithmetic operators and 'and' / 'or' are left-associative; comparisons chain (see
+// chainComparison). Each operator costs one table lookup. Instead of recursing, an operator's
+// right operand, the operand of a 'not' and the inside of a '(' get frames on expressionStack;
+// value is always the operand (or inner expression) that the frame on top is waiting for.
+NodeId Parser::parseExpression() {
+    size_t base = expressionStack.size();
+    expressionStack.push_back(ExpressionFrame{NO_OPERATOR, NO_NODE, NO_NODE, NO_NODE, 1, false, false, false});
+    NodeId value = NO_NODE;
+    bool ready = parseFactor(value);
+    for (;;) {
+        if (!ready) { // A '(' was opened: the expression inside starts afresh
+            expressionStack.push_back(ExpressionFrame{NO_OPERATOR, NO_NODE, NO_NODE, NO_NODE, 1, false, false, false});
+            ready = parseFactor(value);
+            continue;
+        }
+        ExpressionFrame& frame = expressionStack.back();
+        if (frame.paren) {
+            NodeId unary = frame.unary;
+            expressionStack.pop_back();
+            nesting--;
+            if (tooDeep) { // One error for the whole statement, not one per '(' left open
+                value = NO_NODE;
+                continue;
+            }
+            expect(TokenType::RPAREN);
+            if (statementFailed()) {
+                synchronize();
+                value = NO_NODE;
+            } else if (unary != NO_NODE && value != NO_NODE) {
+                ast.appendChild(unary, value);
+                value = unary;
+            }
+            continue;
+        }
+
+        bool comparison = frame.hasOp && BINARY_PRECEDENCE[static_cast<size_t>(frame.op.type)] == COMPARISON_PRECEDENCE;
+        if (!frame.hasOp) {
+            frame.left = value;
+        } else if (frame.chained) {
+            frame.left = chainComparison(frame.op, frame.left, frame.middle, value);
+        } else {
+            frame.left = makeBinary(frame.op, frame.left, value);
+        }
+        frame.middle = comparison ? value : NO_NODE;
+        TokenType type = cursor.currentType();
+        uint8_t precedence = BINARY_PRECEDENCE[static_cast<size_t>(type)];
+        if (precedence < frame.minPrecedence) { // Also ends at anything that is not an operator (0)
+            value = frame.left;
+            NodeId negation = frame.unary; // A 'not' frame
+            expressionStack.pop_back();
+            if (negation != NO_NODE && value != NO_NODE) {
+                ast.appendChild(negation, value);
+                value = negation;
+            }
+            if (expressionStack.size() == base) {
+                return value;
+            }
+            continue;
+        }
+        frame.chained = precedence == COMPARISON_PRECEDENCE && frame.middle != NO_NODE;
+        frame.op = consume(type);
+        frame.hasOp = true;
+        expressionStack.push_back(ExpressionFrame{NO_OPERATOR, NO_NODE, NO_NODE, NO_NODE,
+                                                  static_cast<uint8_t>(precedence + 1), false, false, false});
+        ready = parseFactor(value);
     }
 }
 
-// Term: Factor ( ("*" | "/" | "%") Factor )*
-void Parser::parseTerm() {
-    parseFactor();
-    while (match(TokenType::MULTIPLY) || match(TokenType::DIVIDE) || match(TokenType::MODULO)) {
-        consume(currentToken().type); // Consume "*", "/", or "%"
-        parseFactor();
+// Factor: "not"* ("+" | "-")? (INTEGER_LITERAL | FLOAT_LITERAL | STRING_LITERAL | BOOLEAN_LITERAL | IDENTIFIER | "(" Expression ")" | "input" "(" [STRING_LITERAL] ")")
+// A 'not' takes everything down to the comparisons (not a == b is not (a == b)), so like an
+// operator it gets a frame for its operand. As in Python it may only start an operand of 'and',
+// 'or' or another 'not': 1 + not x is an error.
+bool Parser::parseFactor(NodeId& factor) {
+    while (cursor.currentType() == TokenType::NOT) {
+        const ExpressionFrame& top = expressionStack.back();
+        bool notFrame = top.unary != NO_NODE && !top.paren;
+        if (top.minPrecedence > NOT_PRECEDENCE && !notFrame) {
+            syntaxError(currentToken(), ErrorCode::EXPECTED_EXPRESSION);
+            synchronize();
+            factor = NO_NODE;
+            return true;
+        }
+        const Token& op = consume(TokenType::NOT);
+        NodeId negation = ast.addNode(NodeKind::Unary, op.type, op.lexeme, lineOf(op));
+        expressionStack.push_back(ExpressionFrame{NO_OPERATOR, NO_NODE, negation, NO_NODE, COMPARISON_PRECEDENCE,
+                                                  false, false, false});
     }
-}
 
-// Factor: ("+" | "-"")* (INTEGER_LITERAL | FLOAT_LITERAL | STRING_LITERAL | BOOLEAN_LITERAL | IDENTIFIER | "(" Expression ")" | "input" "(" [STRING_LITERAL] ")")
-void Parser::parseFactor() {
-    // Handle plus/minus/not
-    if (match(TokenType::PLUS) || match(TokenType::MINUS) || match(TokenType::NOT)) {
-        consume(currentToken().type);
+    // Handle plus/minus
+    NodeId unary = NO_NODE;
+    TokenType type = cursor.currentType();
+    if (type == TokenType::PLUS || type == TokenType::MINUS) {
+        const Token& op = consume(type);
+        unary = ast.addNode(NodeKind::Unary, op.type, op.lexeme, lineOf(op));
+        type = cursor.currentType();
     }
 
-    if (match(TokenType::INTEGER_LITERAL) || match(TokenType::FLOAT_LITERAL) ||
-        match(TokenType::STRING_LITERAL) || match(TokenType::BOOLEAN_LITERAL)) {
-        consume(currentToken().type); // Consume the literal
-    } else if (match(TokenType::IDENTIFIER)) {
-        // If it's an identifier, ensure it's in the symbol table (or report error if undeclared)
-        Token idToken = consume(TokenType::IDENTIFIER);
-        if (symbolTable.search(idToken.lexeme) == SymbolTable::SymTabPos::NOT_FOUND) {
-            errorHandler.reportError("Undeclared identifier: " + idToken.lexeme, idToken.lineNumber, idToken.columnNumber, "Syntax");
-        } else {
-            symbolTable.addLineOfUsage(idToken.lexeme, idToken.lineNumber);
+    NodeId operand = NO_NODE;
+    switch (type) {
+        case TokenType::INTEGER_LITERAL:
+        case TokenType::FLOAT_LITERAL:
+        case TokenType::STRING_LITERAL:
+        case TokenType::BOOLEAN_LITERAL: {
+            const Token& literal = consume(type); // Consume the literal
+            operand = ast.addNode(NodeKind::Literal, literal.type, literal.lexeme, lineOf(literal));
+            break;
         }
-    } else if (match(TokenType::LPAREN)) {
-        consume(TokenType::LPAREN);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        parseExpression();
-        consume(TokenType::RPAREN);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-    }
-    else if (match(TokenType::INPUT)) {
-        // Handle input() as a factor that returns a value
-        consume(TokenType::INPUT);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        consume(TokenType::LPAREN);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
-        if (match(TokenType::STRING_LITERAL)) {
-            consume(TokenType::STRING_LITERAL); // Optional prompt string
+        case TokenType::IDENTIFIER: {
+            // If it's an identifier, ensure it's in the symbol table (or report error if undeclared)
+            const Token& idToken = consume(TokenType::IDENTIFIER);
+            SymbolTable::SymTabPos pos = symbolTable.search(idToken.lexeme);
+            if (pos == SymbolTable::SymTabPos::NOT_FOUND && piece) {
+                // An earlier piece may assign it (see parsePiece)
+                symbolTable.insert(idToken.lexeme, "dynamic", 0, 0, 0);
+                symbolTable.addLineOfUsage(idToken.lexeme, lineOf(idToken));
+            } else if (pos == SymbolTable::SymTabPos::NOT_FOUND) {
+                syntaxError(idToken, ErrorCode::UNDECLARED_IDENTIFIER);
+            } else {
+                symbolTable.addLineOfUsage(pos, lineOf(idToken));
+            }
+            operand = ast.addNode(NodeKind::Name, TokenType::IDENTIFIER, idToken.lexeme, lineOf(idToken));
+            break;
         }
-        consume(TokenType::RPAREN);
-        if (errorHandler.hasErrors()) { synchronize(); return; }
+        case TokenType::LPAREN:
+            if (nesting >= maxNesting) {
+                nestingError(currentToken());
+                synchronize();
+                factor = NO_NODE;
+                return true;
+            }
+            expect(TokenType::LPAREN);
+            if (statementFailed()) { synchronize(); factor = NO_NODE; return true; }
+            // The sign waits in the frame; parseExpression() applies it after the ')'
+            expressionStack.push_back(ExpressionFrame{NO_OPERATOR, NO_NODE, unary, NO_NODE, 0, false, true, false});
+            nesting++;
+            return false;
+        case TokenType::INPUT:
+            // Handle input() as a factor that returns a value
+            operand = parseInputCall();
+            break;
+        default:
+            syntaxError(currentToken(), ErrorCode::EXPECTED_EXPRESSION);
+            synchronize(); // Attempt to recover
+            factor = NO_NODE;
+            return true;
     }
-    else {
-        syntaxError("Expected an expression, literal, identifier, '(', or 'input()' call, but found '" + currentToken().lexeme + "'");
-        synchronize(); // Attempt to recover
+
+    factor = operand;
+    if (unary != NO_NODE && operand != NO_NODE) {
+        ast.appendChild(unary, operand);
+        factor = unary;
     }
+    return true;
 }
 
 // PrintStatement: "print" "(" Expression ")"
-void Parser::parsePrintStatement() {
-    consume(TokenType::PRINT);
-    if (errorHandler.hasErrors()) { synchronize(); return; }
-    consume(TokenType::LPAREN);
-    if (errorHandler.hasErrors()) { synchronize(); return; }
-    parseExpression(); // The expression to print
-    consume(TokenType::RPAREN);
-    if (errorHandler.hasErrors()) { synchronize(); return; }
+NodeId Parser::parsePrintStatement() {
+    NodeId print = ast.addNode(NodeKind::Print, TokenType::PRINT, "", currentLine());
+    expect(TokenType::PRINT);
+    if (statementFailed()) { synchronize(); return print; }
+    expect(TokenType::LPAREN);
+    if (statementFailed()) { synchronize(); return print; }
+    ast.appendChild(print, parseExpression()); // The expression to print
+    expect(TokenType::RPAREN);
+    if (statementFailed()) { synchronize(); return print; }
+    return print;
 }
 
 // InputStatement: "input" "(" [STRING_LITERAL] ")"
-void Parser::parseInputStatement() {
-    consume(TokenType::INPUT);
-    if (errorHandler.hasErrors()) { synchronize(); return; }
-    consume(TokenType::LPAREN);
-    if (errorHandler.hasErrors()) { synchronize(); return; }
+NodeId Parser::parseInputStatement() {
+    NodeId statement = ast.addNode(NodeKind::ExprStmt, TokenType::UNKNOWN, "", currentLine());
+    ast.appendChild(statement, parseInputCall());
+    return statement;
+}
+
+// "input" "(" [STRING_LITERAL] ")", shared by the statement and factor forms
+NodeId Parser::parseInputCall() {
+    NodeId input = ast.addNode(NodeKind::Input, TokenType::INPUT, "", currentLine());
+    expect(TokenType::INPUT);
+    if (statementFailed()) { synchronize(); return input; }
+    expect(TokenType::LPAREN);
+    if (statementFailed()) { synchronize(); return input; }
     if (match(TokenType::STRING_LITERAL)) {
-        consume(TokenType::STRING_LITERAL); // Optional prompt string
+        const Token& prompt = consume(TokenType::STRING_LITERAL); // Optional prompt string
+        ast.appendChild(input, ast.addNode(NodeKind::Literal, prompt.type, prompt.lexeme, lineOf(prompt)));
     }
-    consume(TokenType::RPAREN);
-    if (errorHandler.hasErrors()) { synchronize(); return; }
-}
\ No newline at end of file
+    expect(TokenType::RPAREN);
+    if (statementFailed()) { synchronize(); return input; }
+    return input;
+}
@@ -4,50 +4,127 @@
 #include <vector>
 #include <string>
 #include "Token.h"
+#include "TokenCursor.h"
+#include "TokenBuffer.h"
+#include "Lexer.h"
+#include "LineIndex.h"
 #include "SymbolTable.h"
 #include "ErrorHandler.h"
-
-// Forward declaration of any AST node classes if you implement them
-// class ExpressionNode;
-// class StatementNode;
+#include "AST.h"
 
 class Parser {
 private:
-    const std::vector<Token>& tokens;
-    size_t currentTokenIndex;
+    TokenCursor cursor;
+    const LineIndex& lines; // Lines of AST nodes and symbols
     SymbolTable& symbolTable;
     ErrorHandler& errorHandler;
+    Ast ast; // Tree built by the last parse()
+    size_t statementErrorMark; // errorHandler.reportedCount() when the current top-level statement began
+    bool recover;              // ErrorPolicy::recover: skip failed statements instead of stopping
+    bool piece;                // In parsePiece(): undeclared names are entered, not reported
+
+    // Nested blocks and parentheses are parsed with explicit stacks on the heap instead of native
+    // recursion, so machine-generated input nested thousands deep cannot overflow the stack; see
+    // parseStatement() and parseExpression(). nesting counts the open indented blocks and
+    // parentheses; past ErrorPolicy::maxNesting the statement fails with TOO_DEEPLY_NESTED.
+    enum class StatementStep : uint8_t {
+        START,         // Parse the statement at the cursor
+        OPEN_BODY,     // The compound statement on top has read a ':'; parse its block
+        NEXT_IN_BLOCK, // The block on top wants its next statement or its DEDENT
+        RETURN         // value is done: hand it to the frame on top, or return it
+    };
+    struct StatementFrame {
+        NodeId node;   // The If / While / For node, or the Block node
+        NodeKind kind;
+        bool inElse;   // If: the block being parsed is the 'else' one
+    };
+    struct ExpressionFrame {
+        Token op;              // Operator whose right operand is being parsed, once hasOp is set (a copy: it
+                               // outlives the cursor's window, see TokenCursor.h)
+        NodeId left;           // Operand so far
+        NodeId unary;          // The Unary node that takes the finished operand: the sign before a '(', or
+                               // the 'not' whose operand this frame is (NO_NODE for neither)
+        NodeId middle;         // Right operand of the comparison that built left, which a next comparison
+                               // chains from (NO_NODE if left was not built by a comparison)
+        uint8_t minPrecedence; // Operators binding less tightly end this frame
+        bool hasOp;
+        bool paren;            // An open '(' waiting for the expression inside it
+        bool chained;          // op is a comparison chained to the one that built left
+    };
+    std::vector<StatementFrame> statementStack;
+    std::vector<ExpressionFrame> expressionStack;
+    size_t nesting;
+    size_t maxNesting;
+    bool tooDeep; // The statement went past maxNesting: its open parentheses close without more errors
 
     // Current token being processed
-    Token currentToken() const;
-    Token peekNextToken() const;
-    Token consume(TokenType expectedType);
+    const Token& currentToken() const;
+    size_t lineOf(const Token& token) const { return lines.line(token.offset); }
+    size_t currentLine() const { return lines.line(cursor.currentOffset()); }
+    const Token& consume(TokenType expectedType);
+    void expect(TokenType expectedType); // consume() without returning the token
     bool match(TokenType expectedType);
     void synchronize(); // Error recovery
+    bool statementFailed() const;
+    void skipToNextStatement(size_t failedLine); // Recovery between statements (ErrorPolicy::recover)
 
-    // Parsing functions for grammar rules
-    void parseProgram();
-    void parseStatement();
+    // Parsing functions for grammar rules (each returns the AST node it built)
+    NodeId parseProgram();
+    NodeId parseTopLevelStatement();
+    NodeId parseStatement();
+    NodeId parseSimpleStatement(); // A one-line statement and its NEWLINE
+    NodeId parseLine();            // The same without the NEWLINE
     void parseDeclarativeStatement(); // For variable declarations (like "x = 72" after first declaration)
-    void parseAssignmentStatement(); // For variable assignments (x = y + 1)
-    void parseArithmeticOperation(); // For expressions like "a + b * c"
-    void parseConditionalStatement(); // if, elif, else
-    void parseIterativeStatement(); // for, while
-    void parseExpression();        // Handle all expression types
-    void parseComparison();        // Handle comparison operators (==, !=, <, etc.)
-    void parseArithmeticExpression(); // Handle + and - operations
-
-    void parseTerm();
-    void parseFactor();
-    void parsePrintStatement(); // For print()
-    void parseInputStatement(); // For input()
+    NodeId parseAssignmentStatement(); // For variable assignments (x = y + 1)
+    NodeId parseArithmeticOperation(); // For expressions like "a + b * c"
+    StatementStep startStatement(NodeId& value); // if / while / for up to ':', or a whole simple statement
+    StatementStep openBody(NodeId& value);       // Body of a conditional or loop: one line, or indented lines
+    StatementStep nextInBlock(NodeId& value);
+    StatementStep resume(NodeId& value);         // The frame on top takes value, its body or statement
+    // Binary operators by precedence climbing over the table in Parser.cpp
+    NodeId parseExpression();
+    // An operand, with an optional sign; a 'not' before it pushes a frame for its operand. False
+    // after an opening '(': its frame is pushed and the expression inside comes next.
+    bool parseFactor(NodeId& factor);
+    void nestingError(const Token& at);
+    NodeId parsePrintStatement(); // For print()
+    NodeId parseInputStatement(); // For input()
+    NodeId parseInputCall();      // input(...) as a statement or a value
+
+    NodeId makeBinary(const Token& op, NodeId left, NodeId right);
+    NodeId chainComparison(const Token& op, NodeId left, NodeId middle, NodeId right);
 
     // Helper for error reporting
-    void syntaxError(const std::string& message);
+    void syntaxError(const Token& at, ErrorCode code, TokenType expected = TokenType::UNKNOWN);
 
 public:
-    Parser(const std::vector<Token>& tokens, SymbolTable& symTab, ErrorHandler& errHandler);
+    // Parses an already tokenized vector. lines indexes the tokens' source; the AST and the
+    // symbol table record line numbers, which the parser looks up as it goes.
+    Parser(const std::vector<Token>& tokens, const LineIndex& lines, SymbolTable& symTab, ErrorHandler& errHandler);
+    // Parses a struct-of-arrays token buffer (see TokenBuffer.h)
+    Parser(const TokenBuffer& tokens, const LineIndex& lines, SymbolTable& symTab, ErrorHandler& errHandler);
+    // Parses while lexing: tokens are pulled from the lexer one at a time, so memory stays bounded
+    Parser(Lexer& lexer, const LineIndex& lines, SymbolTable& symTab, ErrorHandler& errHandler);
+    // Parses the whole program. Stops after the first statement with an error unless the
+    // ErrorHandler's policy asks for recovery (see ErrorPolicy).
     void parse();
+
+    // Parses the single top-level statement at the given token index (vector mode only) and
+    // returns its node; tokenPosition() is then the index where the next statement starts.
+    // Used to re-parse only the statements an edit touched (see IncrementalAnalyzer).
+    NodeId parseTopLevelStatementAt(size_t tokenIndex);
+    size_t tokenPosition() const { return cursor.position(); }
+
+    // Parses the top-level statements in the tokens [begin, end) (vector and TokenBuffer modes) as
+    // one piece of a larger program, into a tree of its own; see ParallelParser. A name read in
+    // the piece before it is assigned there is not reported as undeclared, since an earlier piece
+    // may assign it: it is entered with line of declaration 0 (lines start at 1), its reads as
+    // usages. True if the piece parsed without errors and its last statement ended at end.
+    bool parsePiece(size_t begin, size_t end);
+
+    // The tree built by parse(); its text fields view into the source buffer
+    const Ast& getAst() const { return ast; }
+    Ast& getAst() { return ast; }
 };
 
 #endif
\ No newline at end of file
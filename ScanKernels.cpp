@@ -0,0 +1,291 @@
+// implementation of ScanKernels.h
+
+#include "ScanKernels.h"
+#include "LexerTables.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ScanKernels {
+namespace {
+
+// Scalar versions, also used for the tail of the vector versions
+
+const char* skipBlanksScalar(const char* p, const char* end) {
+    while (p < end && LexerTables::hasFlag(*p, LexerTables::CHAR_BLANK)) ++p;
+    return p;
+}
+
+const char* findLineEndScalar(const char* p, const char* end) {
+    while (p < end && *p != '\n' && *p != '\0') ++p;
+    return p;
+}
+
+const char* skipIdentifierScalar(const char* p, const char* end) {
+    while (p < end && LexerTables::hasFlag(*p, LexerTables::CHAR_IDENT)) ++p;
+    return p;
+}
+
+const char* skipDigitsScalar(const char* p, const char* end) {
+    while (p < end && LexerTables::hasFlag(*p, LexerTables::CHAR_DIGIT)) ++p;
+    return p;
+}
+
+const char* findStringEndScalar(const char* p, const char* end, char quote) {
+    while (p < end && *p != quote && *p != '\n' && *p != '\0') ++p;
+    return p;
+}
+
+void collectLineStartsScalar(const char* begin, const char* end, size_t base, std::vector<size_t>& starts) {
+    for (const char* p = begin; p < end; ++p) {
+        if (*p == '\n') starts.push_back(base + static_cast<size_t>(p - begin) + 1);
+    }
+}
+
+const KernelSet scalarKernels = {
+    skipBlanksScalar, findLineEndScalar, skipIdentifierScalar, skipDigitsScalar, findStringEndScalar,
+    collectLineStartsScalar
+};
+
+#ifdef SCAN_KERNELS_X86
+
+// Each vector kernel builds a mask of bytes that stop the run and returns the first set bit.
+// Byte comparisons are signed, so bytes >= 0x80 are negative and never fall inside an ASCII range.
+
+inline unsigned countTrailingZeros(unsigned mask) {
+    return static_cast<unsigned>(__builtin_ctz(mask));
+}
+
+// ---- SSE2 (16 bytes per step) ----
+
+inline __m128i inRange128(__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+inline __m128i load128(const char* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+__attribute__((target("sse2"))) const char* skipBlanksSSE2(const char* p, const char* end) {
+    while (end - p >= 16) {
+        __m128i v = load128(p);
+        __m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                                  _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+        unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(blank)) & 0xFFFFu;
+        if (stop) return p + countTrailingZeros(stop);
+        p += 16;
+    }
+    return skipBlanksScalar(p, end);
+}
+
+__attribute__((target("sse2"))) const char* findLineEndSSE2(const char* p, const char* end) {
+    while (end - p >= 16) {
+        __m128i v = load128(p);
+        __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                                   _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+        unsigned stop = static_cast<unsigned>(_mm_movemask_epi8(hit));
+        if (stop) return p + countTrailingZeros(stop);
+        p += 16;
+    }
+    return findLineEndScalar(p, end);
+}
+
+__attribute__((target("sse2"))) const char* skipIdentifierSSE2(const char* p, const char* end) {
+    while (end - p >= 16) {
+        __m128i v = load128(p);
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20)); // folds A-Z onto a-z
+        __m128i ident = _mm_or_si128(_mm_or_si128(inRange128(lower, 'a', 'z'), inRange128(v, '0', '9')),
+                                     _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(ident)) & 0xFFFFu;
+        if (stop) return p + countTrailingZeros(stop);
+        p += 16;
+    }
+    return skipIdentifierScalar(p, end);
+}
+
+__attribute__((target("sse2"))) const char* skipDigitsSSE2(const char* p, const char* end) {
+    while (end - p >= 16) {
+        unsigned stop = ~static_cast<unsigned>(_mm_movemask_epi8(inRange128(load128(p), '0', '9'))) & 0xFFFFu;
+        if (stop) return p + countTrailingZeros(stop);
+        p += 16;
+    }
+    return skipDigitsScalar(p, end);
+}
+
+__attribute__((target("sse2"))) const char* findStringEndSSE2(const char* p, const char* end, char quote) {
+    while (end - p >= 16) {
+        __m128i v = load128(p);
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(quote)),
+                                                _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                                   _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+        unsigned stop = static_cast<unsigned>(_mm_movemask_epi8(hit));
+        if (stop) return p + countTrailingZeros(stop);
+        p += 16;
+    }
+    return findStringEndScalar(p, end, quote);
+}
+
+// Every set bit of the newline mask is one line start, so lines shorter than a vector cost no extra loads
+__attribute__((target("sse2"))) void collectLineStartsSSE2(const char* begin, const char* end, size_t base,
+                                                           std::vector<size_t>& starts) {
+    const char* p = begin;
+    while (end - p >= 16) {
+        unsigned hits = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(load128(p), _mm_set1_epi8('\n'))));
+        size_t at = base + static_cast<size_t>(p - begin) + 1;
+        for (; hits != 0; hits &= hits - 1) starts.push_back(at + countTrailingZeros(hits));
+        p += 16;
+    }
+    collectLineStartsScalar(p, end, base + static_cast<size_t>(p - begin), starts);
+}
+
+const KernelSet sse2Kernels = {
+    skipBlanksSSE2, findLineEndSSE2, skipIdentifierSSE2, skipDigitsSSE2, findStringEndSSE2, collectLineStartsSSE2
+};
+
+// ---- AVX2 (32 bytes per step) ----
+
+__attribute__((target("avx2"))) inline __m256i inRange256(__m256i v, char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+}
+
+__attribute__((target("avx2"))) inline __m256i load256(const char* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+__attribute__((target("avx2"))) const char* skipBlanksAVX2(const char* p, const char* end) {
+    while (end - p >= 32) {
+        __m256i v = load256(p);
+        __m256i blank = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(blank));
+        if (stop) return p + countTrailingZeros(stop);
+        p += 32;
+    }
+    return skipBlanksSSE2(p, end);
+}
+
+__attribute__((target("avx2"))) const char* findLineEndAVX2(const char* p, const char* end) {
+    while (end - p >= 32) {
+        __m256i v = load256(p);
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                                      _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+        unsigned stop = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+        if (stop) return p + countTrailingZeros(stop);
+        p += 32;
+    }
+    return findLineEndSSE2(p, end);
+}
+
+__attribute__((target("avx2"))) const char* skipIdentifierAVX2(const char* p, const char* end) {
+    while (end - p >= 32) {
+        __m256i v = load256(p);
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20)); // folds A-Z onto a-z
+        __m256i ident = _mm256_or_si256(_mm256_or_si256(inRange256(lower, 'a', 'z'), inRange256(v, '0', '9')),
+                                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(ident));
+        if (stop) return p + countTrailingZeros(stop);
+        p += 32;
+    }
+    return skipIdentifierSSE2(p, end);
+}
+
+__attribute__((target("avx2"))) const char* skipDigitsAVX2(const char* p, const char* end) {
+    while (end - p >= 32) {
+        unsigned stop = ~static_cast<unsigned>(_mm256_movemask_epi8(inRange256(load256(p), '0', '9')));
+        if (stop) return p + countTrailingZeros(stop);
+        p += 32;
+    }
+    return skipDigitsSSE2(p, end);
+}
+
+__attribute__((target("avx2"))) const char* findStringEndAVX2(const char* p, const char* end, char quote) {
+    while (end - p >= 32) {
+        __m256i v = load256(p);
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(quote)),
+                                                      _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))),
+                                      _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+        unsigned stop = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+        if (stop) return p + countTrailingZeros(stop);
+        p += 32;
+    }
+    return findStringEndSSE2(p, end, quote);
+}
+
+__attribute__((target("avx2"))) void collectLineStartsAVX2(const char* begin, const char* end, size_t base,
+                                                           std::vector<size_t>& starts) {
+    const char* p = begin;
+    while (end - p >= 32) {
+        unsigned hits = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(load256(p), _mm256_set1_epi8('\n'))));
+        size_t at = base + static_cast<size_t>(p - begin) + 1;
+        for (; hits != 0; hits &= hits - 1) starts.push_back(at + countTrailingZeros(hits));
+        p += 32;
+    }
+    collectLineStartsSSE2(p, end, base + static_cast<size_t>(p - begin), starts);
+}
+
+const KernelSet avx2Kernels = {
+    skipBlanksAVX2, findLineEndAVX2, skipIdentifierAVX2, skipDigitsAVX2, findStringEndAVX2, collectLineStartsAVX2
+};
+
+#endif // SCAN_KERNELS_X86
+
+bool cpuSupports(Isa isa) {
+    switch (isa) {
+#ifdef SCAN_KERNELS_X86
+        case Isa::AVX2: return __builtin_cpu_supports("avx2");
+        case Isa::SSE2: return __builtin_cpu_supports("sse2");
+#endif
+        case Isa::Scalar: return true;
+        default: return false;
+    }
+}
+
+Isa detectIsa() {
+#ifdef SCAN_KERNELS_X86
+    __builtin_cpu_init(); // May run before the runtime's own constructors have
+#endif
+    if (cpuSupports(Isa::AVX2)) return Isa::AVX2;
+    if (cpuSupports(Isa::SSE2)) return Isa::SSE2;
+    return Isa::Scalar;
+}
+
+} // namespace
+
+const KernelSet& kernelsFor(Isa isa) {
+    if (!cpuSupports(isa)) {
+        return scalarKernels;
+    }
+    switch (isa) {
+#ifdef SCAN_KERNELS_X86
+        case Isa::AVX2: return avx2Kernels;
+        case Isa::SSE2: return sse2Kernels;
+#endif
+        default: return scalarKernels;
+    }
+}
+
+Isa activeIsa() {
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+const KernelSet& active() {
+    static const KernelSet& kernels = kernelsFor(activeIsa());
+    return kernels;
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::AVX2: return "AVX2";
+        case Isa::SSE2: return "SSE2";
+        default: return "Scalar";
+    }
+}
+
+} // namespace ScanKernels
@@ -0,0 +1,50 @@
+#ifndef SCANKERNELS_H
+#define SCANKERNELS_H
+
+#include <cstddef>
+#include <vector>
+
+// Vectorized scanners for the Lexer's inner loops.
+// Each kernel takes [begin, end) and returns a pointer to the first byte that stops the run
+// (or end), except collectLineStarts, which finds every '\n' in the range for LineIndex.
+// The SSE2/AVX2 versions process 16/32 bytes per step; the best one the CPU supports is picked
+// once at startup, with a scalar fallback everywhere else.
+namespace ScanKernels {
+
+enum class Isa { Scalar, SSE2, AVX2 };
+
+struct KernelSet {
+    const char* (*skipBlanks)(const char* begin, const char* end);      // runs of ' ', '\t', '\r'
+    const char* (*findLineEnd)(const char* begin, const char* end);     // comment bodies up to '\n' or '\0'
+    const char* (*skipIdentifier)(const char* begin, const char* end);  // runs of [A-Za-z0-9_]
+    const char* (*skipDigits)(const char* begin, const char* end);      // runs of [0-9]
+    const char* (*findStringEnd)(const char* begin, const char* end, char quote); // quote, '\n' or '\0'
+    // Appends base + the offset just past each '\n' (base is the offset of begin in the source)
+    void (*collectLineStarts)(const char* begin, const char* end, size_t base, std::vector<size_t>& starts);
+};
+
+// Kernels for a specific instruction set (falls back to scalar if it was not compiled in or
+// the CPU lacks it). Mostly useful for benchmarking one path against another.
+const KernelSet& kernelsFor(Isa isa);
+
+// The instruction set selected for this machine
+Isa activeIsa();
+const char* isaName(Isa isa);
+
+// Dispatch through the selected kernel set
+const KernelSet& active();
+
+inline const char* skipBlanks(const char* begin, const char* end) { return active().skipBlanks(begin, end); }
+inline const char* findLineEnd(const char* begin, const char* end) { return active().findLineEnd(begin, end); }
+inline const char* skipIdentifier(const char* begin, const char* end) { return active().skipIdentifier(begin, end); }
+inline const char* skipDigits(const char* begin, const char* end) { return active().skipDigits(begin, end); }
+inline const char* findStringEnd(const char* begin, const char* end, char quote) {
+    return active().findStringEnd(begin, end, quote);
+}
+inline void collectLineStarts(const char* begin, const char* end, size_t base, std::vector<size_t>& starts) {
+    active().collectLineStarts(begin, end, base, starts);
+}
+
+} // namespace ScanKernels
+
+#endif
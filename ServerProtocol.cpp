@@ -0,0 +1,270 @@
+// implementation of ServerProtocol.h
+
+#include "ServerProtocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reads fields front to back, failing (and staying failed) on a short payload
+struct Reader {
+    std::string_view data;
+    bool ok = true;
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (data.size() < sizeof(T)) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, data.data(), sizeof(T));
+        data.remove_prefix(sizeof(T));
+        return value;
+    }
+
+    std::string_view bytes(size_t count) {
+        if (data.size() < count) {
+            ok = false;
+            return {};
+        }
+        std::string_view result = data.substr(0, count);
+        data.remove_prefix(count);
+        return result;
+    }
+};
+
+// Reserves the length prefix; finishFrame fills it in once the payload is written
+size_t startFrame(std::string& out) {
+    size_t start = out.size();
+    put<uint32_t>(out, 0);
+    return start;
+}
+
+void finishFrame(std::string& out, size_t start) {
+    uint32_t length = static_cast<uint32_t>(out.size() - start - sizeof(uint32_t));
+    std::memcpy(&out[start], &length, sizeof(length));
+}
+
+uint32_t clamp32(size_t value) {
+    return static_cast<uint32_t>(std::min<size_t>(value, UINT32_MAX));
+}
+
+} // namespace
+
+void ServerProtocol::encodeRequest(const Request& request, std::string& out) {
+    size_t start = startFrame(out);
+    RequestHeader header{};
+    header.requestId = request.requestId;
+    header.kind = static_cast<uint8_t>(request.kind);
+    header.flags = request.flags;
+    header.maxErrors = request.maxErrors;
+    put(out, header);
+    out += request.text;
+    finishFrame(out, start);
+}
+
+bool ServerProtocol::decodeRequest(std::string_view payload, Request& request) {
+    Reader reader{payload};
+    RequestHeader header = reader.get<RequestHeader>();
+    if (!reader.ok || header.kind > static_cast<uint8_t>(RequestKind::SOURCE)) {
+        return false;
+    }
+    request.requestId = header.requestId;
+    request.kind = static_cast<RequestKind>(header.kind);
+    request.flags = header.flags;
+    request.maxErrors = header.maxErrors;
+    request.text = reader.data;
+    return true;
+}
+
+void ServerProtocol::encodeResponse(uint32_t requestId, ResponseStatus status, size_t tokenCount,
+                                    const SymbolTable& symbolTable, const ErrorHandler& errorHandler,
+                                    const LineIndex& lines, std::string& out) {
+    size_t start = startFrame(out);
+    const std::vector<STEntry>& symbols = symbolTable.getEntries();
+    const std::vector<Error>& errors = errorHandler.getErrors();
+    ResponseHeader header{};
+    header.requestId = requestId;
+    header.status = static_cast<uint8_t>(status);
+    header.tokenCount = clamp32(tokenCount);
+    header.symbolCount = clamp32(symbols.size());
+    header.errorCount = clamp32(errors.size());
+    header.droppedErrors = clamp32(errorHandler.droppedErrors());
+    put(out, header);
+
+    for (const STEntry& entry : symbols) {
+        uint16_t nameLength = static_cast<uint16_t>(std::min<size_t>(entry.name.size(), UINT16_MAX));
+        uint16_t typeLength = static_cast<uint16_t>(std::min<size_t>(entry.dataType.size(), UINT16_MAX));
+        put(out, clamp32(entry.lineOfDeclaration));
+        put(out, clamp32(entry.size));
+        put(out, clamp32(entry.dimension));
+        put(out, clamp32(entry.linesOfUsage.size()));
+        put(out, nameLength);
+        put(out, typeLength);
+        for (size_t line : entry.linesOfUsage) {
+            put(out, clamp32(line));
+        }
+        out.append(entry.name, 0, nameLength);
+        out.append(entry.dataType, 0, typeLength);
+    }
+    for (const Error& error : errors) {
+        uint16_t detailLength = static_cast<uint16_t>(std::min<size_t>(error.detail.size(), UINT16_MAX));
+        put(out, static_cast<uint8_t>(error.kind));
+        put(out, static_cast<uint8_t>(error.code));
+        put(out, static_cast<uint8_t>(error.expected));
+        put(out, static_cast<uint8_t>(error.found));
+        put(out, clamp32(lines.line(error.offset)));
+        put(out, clamp32(lines.column(error.offset)));
+        put(out, detailLength);
+        out.append(error.detail, 0, detailLength);
+    }
+    finishFrame(out, start);
+}
+
+bool ServerProtocol::decodeResponse(std::string_view payload, Response& response) {
+    Reader reader{payload};
+    ResponseHeader header = reader.get<ResponseHeader>();
+    if (!reader.ok || header.status > static_cast<uint8_t>(ResponseStatus::BAD_REQUEST)) {
+        return false;
+    }
+    response.requestId = header.requestId;
+    response.status = static_cast<ResponseStatus>(header.status);
+    response.tokenCount = header.tokenCount;
+    response.droppedErrors = header.droppedErrors;
+    response.symbols.clear();
+    response.errors.clear();
+
+    for (uint32_t i = 0; i < header.symbolCount && reader.ok; ++i) {
+        uint32_t line = reader.get<uint32_t>();
+        uint32_t size = reader.get<uint32_t>();
+        uint32_t dimension = reader.get<uint32_t>();
+        uint32_t usageCount = reader.get<uint32_t>();
+        uint16_t nameLength = reader.get<uint16_t>();
+        uint16_t typeLength = reader.get<uint16_t>();
+        if (!reader.ok || usageCount > reader.data.size() / sizeof(uint32_t)) {
+            return false;
+        }
+        std::vector<size_t> usages(usageCount);
+        for (size_t& usage : usages) {
+            usage = reader.get<uint32_t>();
+        }
+        std::string_view name = reader.bytes(nameLength);
+        std::string_view dataType = reader.bytes(typeLength);
+        response.symbols.emplace_back(std::string(name), std::string(dataType), size, dimension, line);
+        response.symbols.back().linesOfUsage = std::move(usages);
+    }
+    for (uint32_t i = 0; i < header.errorCount && reader.ok; ++i) {
+        uint8_t kind = reader.get<uint8_t>();
+        uint8_t code = reader.get<uint8_t>();
+        uint8_t expected = reader.get<uint8_t>();
+        uint8_t found = reader.get<uint8_t>();
+        uint32_t line = reader.get<uint32_t>();
+        uint32_t column = reader.get<uint32_t>();
+        std::string_view detail = reader.bytes(reader.get<uint16_t>());
+        if (kind > static_cast<uint8_t>(ErrorKind::SYNTAX) || code > static_cast<uint8_t>(ErrorCode::MESSAGE) ||
+            expected > static_cast<uint8_t>(TokenType::UNKNOWN) || found > static_cast<uint8_t>(TokenType::UNKNOWN)) {
+            return false;
+        }
+        response.errors.push_back(ResponseError{Error(static_cast<ErrorKind>(kind), static_cast<ErrorCode>(code), detail, 0,
+                                                      static_cast<TokenType>(expected), static_cast<TokenType>(found)),
+                                                line, column});
+    }
+    return reader.ok && reader.data.empty();
+}
+
+#ifndef _WIN32
+
+bool ServerProtocol::writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t written = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+#else
+        ssize_t written = ::send(fd, data.data(), data.size(), 0);
+#endif
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+namespace {
+
+bool readExactly(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = ::recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+} // namespace
+
+bool ServerProtocol::readFrame(int fd, std::string& payload) {
+    uint32_t length;
+    if (!readExactly(fd, reinterpret_cast<char*>(&length), sizeof(length)) || length > MAX_FRAME_BYTES) {
+        return false;
+    }
+    payload.resize(length);
+    return readExactly(fd, payload.data(), length);
+}
+
+int ServerProtocol::connectTo(const std::string& socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+#else
+
+// Unix domain sockets are not wired up on Windows
+bool ServerProtocol::writeAll(int, std::string_view) {
+    return false;
+}
+
+bool ServerProtocol::readFrame(int, std::string&) {
+    return false;
+}
+
+int ServerProtocol::connectTo(const std::string&) {
+    return -1;
+}
+
+#endif
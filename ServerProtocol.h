@@ -0,0 +1,101 @@
+#ifndef SERVERPROTOCOL_H
+#define SERVERPROTOCOL_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "SymbolTable.h"
+#include "ErrorHandler.h"
+
+// Wire format of the analysis server (see AnalysisServer.h).
+// Every message is a frame: a uint32 payload length followed by the payload. Integers are in
+// native byte order, since both ends run on the same machine, and nothing is padded.
+//
+// Request payload:  RequestHeader, then the path or the source text (the rest of the frame)
+// Response payload: ResponseHeader, then symbolCount symbols, then errorCount errors:
+//   symbol: uint32 declLine, size, dimension, usageCount, uint16 nameLength, uint16 typeLength,
+//           usageCount uint32 usage lines, the name bytes, the type bytes
+//   error:  uint8 kind, code, expected, found (the ErrorHandler.h enums), uint32 line, column,
+//           uint16 detailLength, the detail bytes
+// Responses carry the request's id, and a client that pipelines requests on one connection may
+// get them back in any order.
+namespace ServerProtocol {
+
+const uint32_t MAX_FRAME_BYTES = 64u << 20; // Larger frames close the connection
+
+enum class RequestKind : uint8_t { PATH, SOURCE };
+
+// Request flags
+const uint8_t RECOVER = 1 << 0; // ErrorPolicy::recover for this request
+
+enum class ResponseStatus : uint8_t { OK, READ_FAILED, BAD_REQUEST };
+
+struct RequestHeader {
+    uint32_t requestId;
+    uint8_t kind;      // RequestKind
+    uint8_t flags;
+    uint8_t reserved[2];
+    uint32_t maxErrors; // 0: the server's default
+};
+
+struct ResponseHeader {
+    uint32_t requestId;
+    uint8_t status;     // ResponseStatus
+    uint8_t reserved[3];
+    uint32_t tokenCount;
+    uint32_t symbolCount;
+    uint32_t errorCount;
+    uint32_t droppedErrors; // Errors past the limit, counted but not sent
+};
+
+// A decoded request; text views into the frame it was decoded from
+struct Request {
+    uint32_t requestId = 0;
+    RequestKind kind = RequestKind::SOURCE;
+    uint8_t flags = 0;
+    uint32_t maxErrors = 0;
+    std::string_view text;
+};
+
+// An error as sent: its position is resolved to a line and column by the server, and the
+// offset in error is left 0
+struct ResponseError {
+    Error error;
+    uint32_t line;
+    uint32_t column;
+};
+
+// A decoded response
+struct Response {
+    uint32_t requestId = 0;
+    ResponseStatus status = ResponseStatus::OK;
+    uint32_t tokenCount = 0;
+    uint32_t droppedErrors = 0;
+    std::vector<STEntry> symbols;
+    std::vector<ResponseError> errors;
+};
+
+// Appends a whole request frame (length prefix included) to out
+void encodeRequest(const Request& request, std::string& out);
+// payload is a frame without its length prefix; returns false if it is malformed
+bool decodeRequest(std::string_view payload, Request& request);
+
+// Appends a whole response frame. The results are taken straight from the analysis, so the
+// server does not build a Response first; lines indexes the analyzed source.
+void encodeResponse(uint32_t requestId, ResponseStatus status, size_t tokenCount, const SymbolTable& symbolTable,
+                    const ErrorHandler& errorHandler, const LineIndex& lines, std::string& out);
+bool decodeResponse(std::string_view payload, Response& response);
+
+// Blocking helpers for a connected socket. readFrame returns false on end of stream, on an error
+// or on a frame over MAX_FRAME_BYTES.
+bool writeAll(int fd, std::string_view data);
+bool readFrame(int fd, std::string& payload);
+
+// Connects to a server's socket; returns -1 on failure
+int connectTo(const std::string& socketPath);
+
+} // namespace ServerProtocol
+
+#endif
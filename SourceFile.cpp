@@ -0,0 +1,149 @@
+// implementation of SourceFile.h
+
+#include "SourceFile.h"
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile::SourceFile()
+    : data(nullptr), length(0), mapped(false)
+#ifdef _WIN32
+    , fileHandle(nullptr), mappingHandle(nullptr)
+#endif
+{}
+
+SourceFile::~SourceFile() {
+    close();
+}
+
+SourceFile::SourceFile(SourceFile&& other) noexcept : SourceFile() {
+    *this = std::move(other);
+}
+
+SourceFile& SourceFile::operator=(SourceFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        mapped = other.mapped;
+        length = other.length;
+        fallbackBuffer = std::move(other.fallbackBuffer);
+        // A moved std::string may not keep its old pointer, so re-point into our own copy
+        data = mapped ? other.data : fallbackBuffer.data();
+#ifdef _WIN32
+        fileHandle = other.fileHandle;
+        mappingHandle = other.mappingHandle;
+        other.fileHandle = nullptr;
+        other.mappingHandle = nullptr;
+#endif
+        other.data = nullptr;
+        other.length = 0;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+// Releases the mapping (or the fallback buffer) and resets to an empty file
+void SourceFile::close() {
+    if (mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+#else
+        munmap(const_cast<char*>(data), length);
+#endif
+    }
+    fallbackBuffer.clear();
+    data = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+// Reads the whole stream in large blocks into the fallback buffer
+bool SourceFile::readFrom(std::istream& in) {
+    const size_t blockSize = 1 << 16;
+    size_t used = 0;
+    while (in) {
+        fallbackBuffer.resize(used + blockSize);
+        in.read(&fallbackBuffer[used], static_cast<std::streamsize>(blockSize));
+        used += static_cast<size_t>(in.gcount());
+    }
+    fallbackBuffer.resize(used);
+    if (in.bad()) {
+        close();
+        return false;
+    }
+    data = fallbackBuffer.data();
+    length = used;
+    return true;
+}
+
+bool SourceFile::readStream(std::istream& in) {
+    close();
+    return readFrom(in);
+}
+
+bool SourceFile::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (GetFileType(file) == FILE_TYPE_DISK && GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (view != nullptr) {
+                data = static_cast<const char*>(view);
+                length = static_cast<size_t>(fileSize.QuadPart);
+                mapped = true;
+                fileHandle = file;
+                mappingHandle = mapping;
+                return true;
+            }
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        size_t fileSize = static_cast<size_t>(info.st_size);
+        void* view = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) {
+            madvise(view, fileSize, MADV_SEQUENTIAL); // The lexer reads front to back
+            ::close(fd); // The mapping stays valid after the descriptor is closed
+            data = static_cast<const char*>(view);
+            length = fileSize;
+            mapped = true;
+            return true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    // Pipes, devices, empty files or a failed mapping: read through a stream instead
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    return readFrom(file);
+}
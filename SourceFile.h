@@ -0,0 +1,48 @@
+#ifndef SOURCEFILE_H
+#define SOURCEFILE_H
+
+#include <string>
+#include <string_view>
+#include <istream>
+
+// Read-only view of a source file.
+// Regular files are memory-mapped so the contents are never copied; anything that cannot be
+// mapped (pipes, stdin, character devices) is read into an owned buffer instead.
+// Tokens produced from contents() view into this buffer, so it must outlive the Lexer and its tokens.
+class SourceFile {
+private:
+    const char* data;
+    size_t length;
+    bool mapped;
+    std::string fallbackBuffer; // Used only when the input could not be mapped
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+
+    bool readFrom(std::istream& in);
+    void close();
+
+public:
+    SourceFile();
+    ~SourceFile();
+
+    // Mapped memory must be unmapped exactly once, so the object is move-only
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    SourceFile(SourceFile&& other) noexcept;
+    SourceFile& operator=(SourceFile&& other) noexcept;
+
+    // Opens a file by path. Returns false if the file could not be opened or read.
+    bool open(const std::string& path);
+
+    // Reads everything from a stream such as std::cin
+    bool readStream(std::istream& in);
+
+    std::string_view contents() const { return std::string_view(data, length); }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    bool isMapped() const { return mapped; }
+};
+
+#endif
@@ -0,0 +1,196 @@
+// implementation of Stats.h
+
+#include "Stats.h"
+
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef ANALYZER_NO_STATS
+
+namespace {
+
+// Slots of the live threads, plus the totals of threads that have exited (e.g. a finished
+// ThreadPool's workers)
+struct Registry {
+    std::mutex mutex;
+    std::vector<Stats::Counters*> live;
+    Stats::Snapshot retired;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+void zero(Stats::Counters& counters) {
+    for (auto& c : counters.phaseNanos) c.store(0, std::memory_order_relaxed);
+    for (auto& c : counters.tokensByType) c.store(0, std::memory_order_relaxed);
+    counters.symbolLookups.store(0, std::memory_order_relaxed);
+    counters.symbolMisses.store(0, std::memory_order_relaxed);
+    counters.bytesScanned.store(0, std::memory_order_relaxed);
+    for (auto& c : counters.errorsByKind) c.store(0, std::memory_order_relaxed);
+    counters.peakTokenVector.store(0, std::memory_order_relaxed);
+}
+
+void addTo(Stats::Snapshot& total, const Stats::Counters& counters) {
+    for (size_t i = 0; i < Stats::PHASE_COUNT; ++i) {
+        total.phaseSeconds[i] += static_cast<double>(counters.phaseNanos[i].load(std::memory_order_relaxed)) / 1e9;
+    }
+    for (size_t i = 0; i < Stats::TOKEN_TYPE_COUNT; ++i) {
+        total.tokensByType[i] += counters.tokensByType[i].load(std::memory_order_relaxed);
+    }
+    total.symbolLookups += counters.symbolLookups.load(std::memory_order_relaxed);
+    total.symbolMisses += counters.symbolMisses.load(std::memory_order_relaxed);
+    total.bytesScanned += counters.bytesScanned.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < Stats::ERROR_KIND_COUNT; ++i) {
+        total.errorsByKind[i] += counters.errorsByKind[i].load(std::memory_order_relaxed);
+    }
+    uint64_t peak = counters.peakTokenVector.load(std::memory_order_relaxed);
+    if (peak > total.peakTokenVector) {
+        total.peakTokenVector = peak;
+    }
+}
+
+// Registers itself on a thread's first hook and folds its counts into the totals on exit
+struct ThreadSlot {
+    Stats::Counters counters;
+
+    ThreadSlot() {
+        zero(counters);
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.live.push_back(&counters);
+    }
+    ~ThreadSlot() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        addTo(r.retired, counters);
+        for (size_t i = 0; i < r.live.size(); ++i) {
+            if (r.live[i] == &counters) {
+                r.live[i] = r.live.back();
+                r.live.pop_back();
+                break;
+            }
+        }
+    }
+};
+
+} // namespace
+
+Stats::Counters& Stats::local() {
+    // The registry must outlive every slot, including the main thread's
+    registry();
+    thread_local ThreadSlot slot;
+    return slot.counters;
+}
+
+Stats::Snapshot Stats::snapshot() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    Snapshot total = r.retired;
+    for (const Counters* counters : r.live) {
+        addTo(total, *counters);
+    }
+    total.enabled = true;
+    return total;
+}
+
+void Stats::reset() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.retired = Snapshot();
+    for (Counters* counters : r.live) {
+        zero(*counters);
+    }
+}
+
+#else
+
+Stats::Snapshot Stats::snapshot() {
+    return Snapshot();
+}
+
+void Stats::reset() {}
+
+#endif
+
+uint64_t Stats::Snapshot::tokens() const {
+    uint64_t total = 0;
+    for (uint64_t count : tokensByType) {
+        total += count;
+    }
+    return total;
+}
+
+const char* Stats::phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::READ: return "read";
+        case Phase::LEX: return "lex";
+        case Phase::PARSE: return "parse";
+        case Phase::INFER: return "infer";
+        case Phase::PRINT: return "print";
+        case Phase::OPTIMIZE: return "optimize";
+        case Phase::COMPILE: return "compile";
+        case Phase::RUN: return "run";
+    }
+    return "unknown";
+}
+
+const char* Stats::errorKindName(ErrorKind kind) {
+    switch (kind) {
+        case ErrorKind::LEXICAL: return "lexical";
+        case ErrorKind::SYNTAX: return "syntax";
+    }
+    return "unknown";
+}
+
+void Stats::printTable(const Snapshot& stats, std::ostream& out) {
+    out << "\n--- Run Statistics ---" << std::endl;
+    if (!stats.enabled) {
+        out << "Statistics were compiled out (ANALYZER_NO_STATS)." << std::endl;
+        out << "----------------------" << std::endl;
+        return;
+    }
+    out << std::left << std::fixed << std::setprecision(6);
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        out << std::setw(24) << (std::string(phaseName(static_cast<Phase>(i))) + " (s)") << stats.phaseSeconds[i] << std::endl;
+    }
+    out << std::defaultfloat;
+    out << std::setw(24) << "Bytes scanned" << stats.bytesScanned << std::endl;
+    out << std::setw(24) << "Tokens" << stats.tokens() << std::endl;
+    out << std::setw(24) << "Peak token vector" << stats.peakTokenVector << std::endl;
+    out << std::setw(24) << "Symbol lookups" << stats.symbolLookups << std::endl;
+    out << std::setw(24) << "Symbol misses" << stats.symbolMisses << std::endl;
+    for (size_t i = 0; i < ERROR_KIND_COUNT; ++i) {
+        out << std::setw(24) << (std::string(errorKindName(static_cast<ErrorKind>(i))) + " errors") << stats.errorsByKind[i] << std::endl;
+    }
+    out << "Tokens by type:" << std::endl;
+    for (size_t i = 0; i < TOKEN_TYPE_COUNT; ++i) {
+        if (stats.tokensByType[i] != 0) {
+            out << "  " << std::setw(22) << tokenTypeName(static_cast<TokenType>(i)) << stats.tokensByType[i] << std::endl;
+        }
+    }
+    out << "----------------------" << std::endl;
+}
+
+void Stats::printJson(const Snapshot& stats, std::ostream& out) {
+    out << "{\"enabled\":" << (stats.enabled ? "true" : "false") << ",\"phaseSeconds\":{";
+    out << std::fixed << std::setprecision(6);
+    for (size_t i = 0; i < PHASE_COUNT; ++i) {
+        out << (i ? "," : "") << '"' << phaseName(static_cast<Phase>(i)) << "\":" << stats.phaseSeconds[i];
+    }
+    out << std::defaultfloat;
+    out << "},\"bytesScanned\":" << stats.bytesScanned << ",\"tokens\":" << stats.tokens()
+        << ",\"peakTokenVector\":" << stats.peakTokenVector << ",\"symbolLookups\":" << stats.symbolLookups
+        << ",\"symbolMisses\":" << stats.symbolMisses << ",\"errors\":{";
+    for (size_t i = 0; i < ERROR_KIND_COUNT; ++i) {
+        out << (i ? "," : "") << '"' << errorKindName(static_cast<ErrorKind>(i)) << "\":" << stats.errorsByKind[i];
+    }
+    out << "},\"tokensByType\":{";
+    for (size_t i = 0; i < TOKEN_TYPE_COUNT; ++i) {
+        out << (i ? "," : "") << '"' << tokenTypeName(static_cast<TokenType>(i)) << "\":" << stats.tokensByType[i];
+    }
+    out << "}}" << std::endl;
+}
@@ -0,0 +1,150 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <iostream>
+
+#include "Token.h"
+#include "ErrorHandler.h"
+
+// Run-time counters and per-phase wall time for the analyzer.
+// Every thread counts into its own slot (plain loads and stores, no locked instructions), and
+// snapshot() adds the slots up, so the hooks are cheap enough to leave on in production.
+// Building with -DANALYZER_NO_STATS turns every hook into an empty inline function.
+namespace Stats {
+
+// INFER: type inference after parsing; OPTIMIZE: --optimize and --run; COMPILE and RUN: --run only
+enum class Phase : uint8_t { READ, LEX, PARSE, INFER, PRINT, OPTIMIZE, COMPILE, RUN };
+const size_t PHASE_COUNT = 8;
+
+const size_t ERROR_KIND_COUNT = 2; // ::ErrorKind
+
+const size_t TOKEN_TYPE_COUNT = static_cast<size_t>(TokenType::UNKNOWN) + 1;
+
+// Totals over every thread since startup (or the last reset)
+struct Snapshot {
+    bool enabled = false; // false when the hooks were compiled out
+    double phaseSeconds[PHASE_COUNT] = {};
+    uint64_t tokensByType[TOKEN_TYPE_COUNT] = {};
+    uint64_t symbolLookups = 0;
+    uint64_t symbolMisses = 0;
+    uint64_t bytesScanned = 0;
+    uint64_t errorsByKind[ERROR_KIND_COUNT] = {};
+    uint64_t peakTokenVector = 0; // Largest token vector built by any single tokenize()
+
+    uint64_t tokens() const;
+};
+
+Snapshot snapshot();
+void reset(); // Meant for between runs; counts made while it runs may be lost
+
+const char* phaseName(Phase phase);
+const char* errorKindName(ErrorKind kind);
+
+// Human-readable table, or one JSON object on a single line (easy to scrape from logs)
+void printTable(const Snapshot& stats, std::ostream& out = std::cout);
+void printJson(const Snapshot& stats, std::ostream& out = std::cout);
+
+#ifndef ANALYZER_NO_STATS
+
+struct Counters {
+    std::atomic<uint64_t> phaseNanos[PHASE_COUNT];
+    std::atomic<uint64_t> tokensByType[TOKEN_TYPE_COUNT];
+    std::atomic<uint64_t> symbolLookups;
+    std::atomic<uint64_t> symbolMisses;
+    std::atomic<uint64_t> bytesScanned;
+    std::atomic<uint64_t> errorsByKind[ERROR_KIND_COUNT];
+    std::atomic<uint64_t> peakTokenVector;
+};
+
+// The calling thread's slot
+Counters& local();
+
+// Only the owning thread writes a slot, so a relaxed load + store is enough (and compiles to a
+// plain add); the atomics just make snapshot() reading it from another thread well defined
+inline void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+inline void countToken(TokenType type, size_t bytes) {
+    Counters& counters = local();
+    bump(counters.tokensByType[static_cast<size_t>(type)]);
+    bump(counters.bytesScanned, bytes);
+}
+
+// For a counted token the caller throws away (the chunk-end END_OF_FILE tokens of ParallelLexer)
+inline void uncountToken(TokenType type) {
+    std::atomic<uint64_t>& counter = local().tokensByType[static_cast<size_t>(type)];
+    counter.store(counter.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+}
+
+// For bytes the caller scans again (the chunks ParallelLexer lexes a second time)
+inline void uncountBytes(size_t bytes) {
+    std::atomic<uint64_t>& counter = local().bytesScanned;
+    counter.store(counter.load(std::memory_order_relaxed) - bytes, std::memory_order_relaxed);
+}
+
+// For a counted error the caller throws away (the pieces of a ParallelParser that reparses sequentially)
+inline void uncountError(ErrorKind kind) {
+    std::atomic<uint64_t>& counter = local().errorsByKind[static_cast<size_t>(kind)];
+    counter.store(counter.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+}
+
+inline void countLookup(bool found) {
+    Counters& counters = local();
+    bump(counters.symbolLookups);
+    if (!found) {
+        bump(counters.symbolMisses);
+    }
+}
+
+inline void countError(ErrorKind kind) {
+    bump(local().errorsByKind[static_cast<size_t>(kind)]);
+}
+
+inline void notePeakTokens(size_t size) {
+    std::atomic<uint64_t>& peak = local().peakTokenVector;
+    if (size > peak.load(std::memory_order_relaxed)) {
+        peak.store(size, std::memory_order_relaxed);
+    }
+}
+
+// Adds the lifetime of the scope to a phase's wall time
+class PhaseTimer {
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit PhaseTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~PhaseTimer() {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        bump(local().phaseNanos[static_cast<size_t>(phase)], static_cast<uint64_t>(elapsed.count()));
+    }
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
+#else
+
+inline void countToken(TokenType, size_t) {}
+inline void uncountToken(TokenType) {}
+inline void uncountBytes(size_t) {}
+inline void uncountError(ErrorKind) {}
+inline void countLookup(bool) {}
+inline void countError(ErrorKind) {}
+inline void notePeakTokens(size_t) {}
+
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase) {}
+};
+
+#endif
+
+} // namespace Stats
+
+#endif
@@ -1,59 +1,161 @@
 // implementation of SymbolTable.h
 
 #include "SymbolTable.h"
+#include "Stats.h"
+#include <algorithm>
 #include <iomanip>
 
-bool SymbolTable::insert(const std::string& name, const std::string& dataType, size_t size,
-                         size_t dimension, int lineOfDeclaration) {
-    if (search(name) != SymTabPos::NOT_FOUND) {
-        // Entry with this name already exists
-        return false;
+// FNV-1a, which is cheap for the short names identifiers usually have
+uint32_t SymbolTable::hashName(std::string_view name) {
+    uint32_t hash = 2166136261u;
+    for (char c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
     }
+    return hash;
+}
+
+// Doubles the index and re-inserts every entry using its stored hash
+void SymbolTable::growIndex() {
+    std::vector<IndexSlot> oldIndex = std::move(index);
+    index.assign(oldIndex.empty() ? 16 : oldIndex.size() * 2, IndexSlot{0, 0});
+    size_t mask = index.size() - 1;
+    for (const IndexSlot& slot : oldIndex) {
+        if (slot.id != 0) {
+            size_t i = slot.hash & mask;
+            while (index[i].id != 0) {
+                i = (i + 1) & mask;
+            }
+            index[i] = slot;
+        }
+    }
+}
 
-    entries.emplace_back(name, dataType, size, dimension, lineOfDeclaration);
+bool SymbolTable::insert(std::string_view name, const std::string& dataType, size_t size,
+                         size_t dimension, size_t lineOfDeclaration) {
+    if ((entries.size() + 1) * 2 > index.size()) {
+        growIndex();
+    }
+    uint32_t hash = hashName(name);
+    size_t mask = index.size() - 1;
+    size_t i = hash & mask;
+    for (; index[i].id != 0; i = (i + 1) & mask) {
+        if (index[i].hash == hash && entries[index[i].id - 1].name == name) {
+            // Entry with this name already exists
+            return false;
+        }
+    }
+    entries.emplace_back(std::string(name), dataType, size, dimension, lineOfDeclaration);
+    index[i] = IndexSlot{hash, static_cast<uint32_t>(entries.size())};
+    if (journal != nullptr) {
+        journal->push_back(static_cast<int>(entries.size() - 1));
+    }
     return true;
 }
 
-SymbolTable::SymTabPos SymbolTable::search(const std::string& name) const {
+SymbolTable::SymTabPos SymbolTable::search(std::string_view name) const {
     if (entries.empty()) {
+        Stats::countLookup(false);
         return SymTabPos::NOT_FOUND;
     }
-    for (auto i = 0u; i < entries.size(); ++i) {
-        if (name == entries.at(i).name) {
-            return static_cast<SymTabPos>(i);
+    uint32_t hash = hashName(name);
+    size_t mask = index.size() - 1;
+    for (size_t i = hash & mask; index[i].id != 0; i = (i + 1) & mask) {
+        if (index[i].hash == hash && entries[index[i].id - 1].name == name) {
+            Stats::countLookup(true);
+            return static_cast<SymTabPos>(index[i].id - 1);
         }
     }
+    Stats::countLookup(false);
     return SymTabPos::NOT_FOUND;
 }
 
 //Updates the data type of an existing entry
-void SymbolTable::updateDataType(const std::string& name, const std::string& newDataType) {
+void SymbolTable::updateDataType(std::string_view name, const std::string& newDataType) {
     SymTabPos pos = search(name);
     if (pos != SymTabPos::NOT_FOUND) {
         entries[static_cast<int>(pos)].dataType = newDataType;
     }
 }
 
+void SymbolTable::updateDataType(SymTabPos pos, const std::string& newDataType, size_t newSize) {
+    if (pos != SymTabPos::NOT_FOUND) {
+        entries[static_cast<int>(pos)].dataType = newDataType;
+        entries[static_cast<int>(pos)].size = newSize;
+    }
+}
+
 // Line of usage for an existing entry
-void SymbolTable::addLineOfUsage(const std::string& name, int lineNum) {
-    SymTabPos pos = search(name);
+void SymbolTable::addLineOfUsage(std::string_view name, size_t lineNum) {
+    addLineOfUsage(search(name), lineNum);
+}
+
+void SymbolTable::addLineOfUsage(SymTabPos pos, size_t lineNum) {
     if (pos != SymTabPos::NOT_FOUND) {
         entries[static_cast<int>(pos)].linesOfUsage.push_back(lineNum);
+        if (journal != nullptr) {
+            journal->push_back(static_cast<int>(pos));
+        }
+    }
+}
+
+// Empties an index slot, moving later entries of the same probe run back so lookups still find them
+void SymbolTable::eraseIndexSlot(size_t slot) {
+    size_t mask = index.size() - 1;
+    size_t next = slot;
+    while (true) {
+        next = (next + 1) & mask;
+        if (index[next].id == 0) {
+            break;
+        }
+        size_t home = index[next].hash & mask;
+        // The entry at `next` can stay only if its home slot lies cyclically in (slot, next]
+        bool stays = slot <= next ? (slot < home && home <= next) : (slot < home || home <= next);
+        if (!stays) {
+            index[slot] = index[next];
+            slot = next;
+        }
     }
+    index[slot] = IndexSlot{0, 0};
+}
+
+void SymbolTable::undoLast(SymTabPos pos) {
+    if (pos == SymTabPos::NOT_FOUND) {
+        return;
+    }
+    STEntry& entry = entries[static_cast<int>(pos)];
+    if (!entry.linesOfUsage.empty()) {
+        entry.linesOfUsage.pop_back();
+        return;
+    }
+    // Undoing the declaration: entries are undone newest first, so this is the last one
+    uint32_t id = static_cast<uint32_t>(static_cast<int>(pos) + 1);
+    size_t mask = index.size() - 1;
+    size_t i = hashName(entry.name) & mask;
+    while (index[i].id != id) {
+        i = (i + 1) & mask;
+    }
+    eraseIndexSlot(i);
+    entries.pop_back();
+}
+
+void SymbolTable::clear() {
+    entries.clear();
+    std::fill(index.begin(), index.end(), IndexSlot{0, 0});
 }
 
-void SymbolTable::printTable() const {
-    std::cout << "\n--- Symbol Table ---" << std::endl;
-    std::cout << std::left << std::setw(15) << "Name"
+void SymbolTable::printTable(std::ostream& out) const {
+    out << "\n--- Symbol Table ---" << '\n';
+    out << std::left << std::setw(15) << "Name"
               << std::setw(10) << "Type"
               << std::setw(8) << "Size"
               << std::setw(12) << "Dimension"
               << std::setw(20) << "Decl. Line"
-              << std::setw(20) << "Usage Lines" << std::endl;
-    std::cout << std::string(85, '-') << std::endl;
+              << std::setw(20) << "Usage Lines" << '\n';
+    out << std::string(85, '-') << '\n';
 
     for (const auto& entry : entries) {
-        std::cout << std::left << std::setw(15) << entry.name
+        out << std::left << std::setw(15) << entry.name
                   << std::setw(10) << entry.dataType
                   << std::setw(8) << entry.size
                   << std::setw(12) << entry.dimension
@@ -66,7 +168,7 @@ void SymbolTable::printTable() const {
                 usageLinesStr += ", ";
             }
         }
-        std::cout << std::setw(20) << usageLinesStr << std::endl;
+        out << std::setw(20) << usageLinesStr << '\n';
     }
-    std::cout << std::string(85, '-') << std::endl;
+    out << std::string(85, '-') << '\n';
 }
\ No newline at end of file
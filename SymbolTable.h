@@ -3,6 +3,9 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
 #include <iostream> // For printing symbol table
 
 // You can further refine STEntry for Python-specific attributes
@@ -11,40 +14,73 @@ struct STEntry {
     std::string dataType;         // data type (int, float, etc)
     size_t size;                  // size of the data type (4 for int, 8 for float)
     size_t dimension;             // dimension (for arrays/lists)
-    int lineOfDeclaration;        // line number where declared
+    size_t lineOfDeclaration;     // line number where declared
     // int lineOfUsage;           // track multiple usages, maybe a vector<int>
-    std::vector<int> linesOfUsage; // Store all lines where the variable is used
+    std::vector<size_t> linesOfUsage; // Store all lines where the variable is used
 
     // Constructor
     STEntry(const std::string& name, const std::string& dataType, size_t size,
-            size_t dimension, int lineDecl)
+            size_t dimension, size_t lineDecl)
         : name(name), dataType(dataType), size(size), dimension(dimension),
           lineOfDeclaration(lineDecl) {}
 };
 
+// Each name is stored once (interned) in its entry, and the entry's position doubles as the
+// symbol's ID. An open-addressing hash index maps names to IDs so lookups are O(1), while
+// entries stay in declaration order.
 class SymbolTable {
 private:
     std::vector<STEntry> entries;
 
+    // Hash index: linear probing over a power-of-two table, kept at most half full
+    struct IndexSlot {
+        uint32_t hash;
+        uint32_t id; // entry position + 1, 0 marks an empty slot
+    };
+    std::vector<IndexSlot> index;
+
+    // When set, every insert/addLineOfUsage appends the affected position, so it can be undone
+    std::vector<int>* journal;
+
+    static uint32_t hashName(std::string_view name);
+    void growIndex();
+    void eraseIndexSlot(size_t slot);
+
 public:
     enum class SymTabPos { NOT_FOUND = -1 };
 
+    SymbolTable() : journal(nullptr) {}
+
     // Inserts a new entry into the symbol table
     // Returns true if inserted successfully, false if name already exists
-    bool insert(const std::string& name, const std::string& dataType, size_t size,
-                size_t dimension, int lineOfDeclaration);
+    // The name is copied, so it may be a view into a token's lexeme
+    bool insert(std::string_view name, const std::string& dataType, size_t size,
+                size_t dimension, size_t lineOfDeclaration);
 
     // Search for an entry by name then returns its position (index)
-    SymTabPos search(const std::string& name) const;
+    SymTabPos search(std::string_view name) const;
 
     // Updates the data type of an existing entry (useful for inferred types in Python)
-    void updateDataType(const std::string& name, const std::string& newDataType);
+    void updateDataType(std::string_view name, const std::string& newDataType);
+    // Same, with the size, for a position already returned by search() (see TypeInference)
+    void updateDataType(SymTabPos pos, const std::string& newDataType, size_t newSize);
 
     // Add a line of usage to an existing entry
-    void addLineOfUsage(const std::string& name, int lineNum);
+    void addLineOfUsage(std::string_view name, size_t lineNum);
+    // Same, for a position already returned by search() (skips the second lookup)
+    void addLineOfUsage(SymTabPos pos, size_t lineNum);
+
+    // Undo support for a merge that has to be rolled back (see ParallelParser).
+    // undoLast reverts the most recent insert/addLineOfUsage that touched pos: it drops the last
+    // usage line, or removes the entry if it has none (which must then be the newest entry).
+    void setJournal(std::vector<int>* newJournal) { journal = newJournal; }
+    void undoLast(SymTabPos pos);
+
+    // Removes every entry but keeps the allocated capacity, so a table can be reused
+    void clear();
 
     // Prints the symbol table contents
-    void printTable() const;
+    void printTable(std::ostream& out = std::cout) const;
 
     // Getter for entries
     const std::vector<STEntry>& getEntries() const {
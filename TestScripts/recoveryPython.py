@@ -0,0 +1,26 @@
+# Lexical Error as Invalid character
+invalid_char = 10
+
+# Syntax Error - Missing right parenthesis in print statement
+print("This line has a missing parenthesis"
+
+# Syntax Error - Missing colon after if condition
+if 1 == 1
+    print("Condition is true")
+
+# Lexical Error - Missing closing quote
+unterminated_str = "No closing quote!"
+
+# Syntax Error 3- Incorrect assignment syntax (keyword used as variable)
+if = 5
+
+# Syntax Error 4 - Incomplete arithmetic expression
+x = 10 +
+
+# Syntax Error 5 - Missing expression in while loop
+while:
+    print("This loop will not parse")
+
+# Another assignment
+my_var = 20
+another_var == 30
\ No newline at end of file
@@ -26,6 +26,11 @@ while counter < 3:
     print(counter)
     counter = counter + 1
 
+# Lines are joined inside parentheses
+total = (counter +
+         declared_int)
+print(total)
+
 # Input and Print Statements
 user_name = input("Enter name of user: ")
 print("Hello, ")
@@ -0,0 +1,50 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing thread pool.
+// Every worker owns a queue: it takes its own newest task first, and when its queue is empty it
+// steals the oldest task from another worker, so uneven task sizes (one huge file among many small
+// ones) still keep every core busy.
+class ThreadPool {
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::atomic<size_t> queued;  // Tasks sitting in a queue
+    size_t pending;              // Tasks submitted but not finished (guarded by stateMutex)
+    bool stopping;
+    std::atomic<size_t> nextQueue; // Round-robin target for submit()
+
+    bool tryTake(size_t worker, std::function<void()>& task);
+    void workerLoop(size_t worker);
+
+public:
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool(); // Finishes queued tasks, then joins the workers
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    void wait(); // Blocks until every submitted task has finished
+    size_t size() const { return workers.size(); }
+};
+
+#endif
@@ -1,10 +1,12 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
-#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
 
 // Define token types (keywords, operators, identifiers, literals)
-enum class TokenType {
+enum class TokenType : uint8_t {
     DECLARE,        // for variable declarations
     PRINT,          // print()
     INPUT,          // input()
@@ -54,6 +56,11 @@ enum class TokenType {
     // Identifiers
     IDENTIFIER,
 
+    // Layout (see Lexer.h)
+    NEWLINE,        // end of a logical line
+    INDENT,         // the line is indented deeper than the enclosing block
+    DEDENT,         // one per block the line's indentation closes
+
     // End of File
     END_OF_FILE,
 
@@ -61,16 +68,89 @@ enum class TokenType {
     UNKNOWN
 };
 
+// Name of a token type, as printed in the tokens table
+inline const char* tokenTypeName(TokenType type) {
+    switch (type) {
+        case TokenType::IDENTIFIER: return "IDENTIFIER";
+        case TokenType::INTEGER_LITERAL: return "INTEGER_LITERAL";
+        case TokenType::FLOAT_LITERAL: return "FLOAT_LITERAL";
+        case TokenType::STRING_LITERAL: return "STRING_LITERAL";
+        case TokenType::BOOLEAN_LITERAL: return "BOOLEAN_LITERAL";
+        case TokenType::PLUS: return "PLUS";
+        case TokenType::MINUS: return "MINUS";
+        case TokenType::MULTIPLY: return "MULTIPLY";
+        case TokenType::DIVIDE: return "DIVIDE";
+        case TokenType::MODULO: return "MODULO"; // For %
+        case TokenType::ASSIGN: return "ASSIGN"; // For =
+        case TokenType::EQUAL_EQUAL: return "EQUAL_EQUAL"; // For ==
+        case TokenType::NOT_EQUAL: return "NOT_EQUAL"; // For !=
+        case TokenType::LESS_THAN: return "LESS_THAN";
+        case TokenType::LESS_EQUAL: return "LESS_EQUAL"; // For <=
+        case TokenType::GREATER_THAN: return "GREATER_THAN";
+        case TokenType::GREATER_EQUAL: return "GREATER_EQUAL"; // For >=
+        case TokenType::AND: return "AND";
+        case TokenType::OR: return "OR";
+        case TokenType::NOT: return "NOT";
+        case TokenType::LPAREN: return "LPAREN";
+        case TokenType::RPAREN: return "RPAREN";
+        case TokenType::LBRACE: return "LBRACE"; 
+        case TokenType::RBRACE: return "RBRACE";
+        case TokenType::LBRACKET: return "LBRACKET";
+        case TokenType::RBRACKET: return "RBRACKET";
+        case TokenType::COMMA: return "COMMA";
+        case TokenType::COLON: return "COLON"; // For :
+        case TokenType::SEMICOLON: return "SEMICOLON";
+        case TokenType::DOT: return "DOT";
+        case TokenType::IF: return "IF";
+        case TokenType::ELSE: return "ELSE";
+        case TokenType::ELIF: return "ELIF";
+        case TokenType::WHILE: return "WHILE";
+        case TokenType::FOR: return "FOR";
+        case TokenType::PRINT: return "PRINT"; 
+        case TokenType::INPUT: return "INPUT";
+        case TokenType::DEF: return "DEF"; 
+        case TokenType::RETURN: return "RETURN";
+        case TokenType::DECLARE: return "DECLARE";
+        case TokenType::NEWLINE: return "NEWLINE";
+        case TokenType::INDENT: return "INDENT";
+        case TokenType::DEDENT: return "DEDENT";
+        case TokenType::END_OF_FILE: return "END_OF_FILE";
+        case TokenType::UNKNOWN: return "UNKNOWN"; 
+        // more cases can be added
+        default: return "UNKNOWN_TYPE"; // Fallback for any unhandled types
+    }
+}
+
+// NEWLINE, INDENT and DEDENT only shape the blocks; they carry no text
+inline bool isLayoutToken(TokenType type) {
+    return type == TokenType::NEWLINE || type == TokenType::INDENT || type == TokenType::DEDENT;
+}
+
+// Lexeme of a token that is not source text: the layout tokens and END_OF_FILE are named after
+// their type, the error token of an unexpected character is empty
+inline const char* syntheticLexeme(TokenType type) {
+    switch (type) {
+        case TokenType::NEWLINE: return "NEWLINE";
+        case TokenType::INDENT: return "INDENT";
+        case TokenType::DEDENT: return "DEDENT";
+        case TokenType::END_OF_FILE: return "EOF";
+        default: return "";
+    }
+}
+
 // Structure to hold token information
+// The lexeme is a view into the source buffer the Lexer was given (or a string literal
+// for synthesized tokens like EOF, see syntheticLexeme), so tokens must not outlive that buffer.
+// The position is only the byte offset where the token starts (a string's opening quote, the
+// end of the source for EOF); line and column are looked up in a LineIndex when printed.
 struct Token {
     TokenType type;
-    std::string lexeme;
-    int lineNumber;
-    int columnNumber;
+    std::string_view lexeme;
+    size_t offset;
 
     // Constructor for convenience
-    Token(TokenType type, const std::string& lexeme, int line, int col)
-        : type(type), lexeme(lexeme), lineNumber(line), columnNumber(col) {}
+    Token(TokenType type, std::string_view lexeme, size_t offset)
+        : type(type), lexeme(lexeme), offset(offset) {}
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+// implementation of TokenBuffer.h
+
+#include "TokenBuffer.h"
+
+void TokenBuffer::reset(std::string_view newSource) {
+    source = newSource;
+    types.clear();
+    offsets.clear();
+    lengths.clear();
+    flags.clear();
+}
+
+void TokenBuffer::reserve(size_t tokenCount) {
+    types.reserve(tokenCount);
+    offsets.reserve(tokenCount);
+    lengths.reserve(tokenCount);
+    flags.reserve(tokenCount);
+}
+
+void TokenBuffer::push(const Token& token) {
+    // Pointer comparison through uintptr_t: lexemes from string literals are outside the source
+    uintptr_t at = reinterpret_cast<uintptr_t>(token.lexeme.data());
+    uintptr_t begin = reinterpret_cast<uintptr_t>(source.data());
+    bool inSource = at >= begin && at + token.lexeme.size() <= begin + source.size();
+    uint8_t tokenFlags = 0;
+    if (!inSource) {
+        tokenFlags |= SYNTHETIC;
+    } else if (at != begin + token.offset) {
+        tokenFlags |= QUOTED; // Strings, terminated or not, start at their quote
+    }
+    types.push_back(token.type);
+    offsets.push_back(static_cast<uint32_t>(token.offset));
+    lengths.push_back(inSource ? static_cast<uint32_t>(token.lexeme.size()) : 0);
+    flags.push_back(tokenFlags);
+}
+
+size_t TokenBuffer::memoryBytes() const {
+    return types.capacity() * sizeof(TokenType) + offsets.capacity() * sizeof(uint32_t) +
+           lengths.capacity() * sizeof(uint32_t) + flags.capacity() * sizeof(uint8_t);
+}
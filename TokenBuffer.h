@@ -0,0 +1,61 @@
+#ifndef TOKENBUFFER_H
+#define TOKENBUFFER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "Token.h"
+
+// Struct-of-arrays token store: one dense array per field instead of a vector of 32-byte Tokens.
+// The parser's match() loops only read types, which packs 64 tokens per cache line; the lexeme
+// is an offset and a length into the source (a flag tells whether it starts after the token's
+// opening quote), and positions are offsets like Token's.
+// About 10 bytes per token. Offsets are 32 bits, so sources must be under 4 GB (see fits());
+// larger inputs stay on std::vector<Token>.
+class TokenBuffer {
+private:
+    std::string_view source; // Not owned, like Token::lexeme
+    std::vector<TokenType> types;
+    std::vector<uint32_t> offsets; // Token::offset
+    std::vector<uint32_t> lengths;
+    std::vector<uint8_t> flags;
+
+    // flags
+    static const uint8_t QUOTED = 1 << 0;    // Lexeme starts after the opening quote, one byte later
+    static const uint8_t SYNTHETIC = 1 << 1; // Lexeme is not source text (see syntheticLexeme)
+
+public:
+    static bool fits(std::string_view source) { return source.size() < UINT32_MAX; }
+
+    // Empties the buffer for a new source, keeping the capacity of every array
+    void reset(std::string_view newSource);
+    void reserve(size_t tokenCount);
+
+    // Appends a token the Lexer produced from this buffer's source
+    void push(const Token& token);
+
+    size_t size() const { return types.size(); }
+    bool empty() const { return types.empty(); }
+
+    TokenType type(size_t i) const { return types[i]; }
+    const TokenType* typeData() const { return types.data(); }
+    std::string_view lexeme(size_t i) const;
+    size_t offset(size_t i) const { return offsets[i]; }
+    Token token(size_t i) const { return Token(types[i], lexeme(i), offsets[i]); } // As the Lexer produced it
+
+    std::string_view getSource() const { return source; }
+
+    // Bytes held by the arrays (capacity)
+    size_t memoryBytes() const;
+};
+
+inline std::string_view TokenBuffer::lexeme(size_t i) const {
+    if (flags[i] & SYNTHETIC) {
+        return syntheticLexeme(types[i]);
+    }
+    return std::string_view(source.data() + offsets[i] + (flags[i] & QUOTED), lengths[i]);
+}
+
+#endif
@@ -0,0 +1,87 @@
+// implementation of TokenCursor.h
+
+#include "TokenCursor.h"
+
+// An empty vector or TokenBuffer reads as the streaming mode's END_OF_FILE token
+TokenCursor::TokenCursor(const std::vector<Token>& tokens)
+    : tokens(tokens.empty() ? nullptr : &tokens), index(0), last(tokens.empty() ? 0 : tokens.size() - 1),
+      buffer(nullptr),
+      assembled{Token(TokenType::END_OF_FILE, "EOF", 0), Token(TokenType::END_OF_FILE, "EOF", 0)},
+      assembledIndex{SIZE_MAX, SIZE_MAX}, lexer(nullptr),
+      ring{Token(TokenType::END_OF_FILE, "EOF", 0), Token(TokenType::END_OF_FILE, "EOF", 0)},
+      head(0), hasLookahead(false) {}
+
+TokenCursor::TokenCursor(const TokenBuffer& buffer)
+    : tokens(nullptr), index(0), last(buffer.empty() ? 0 : buffer.size() - 1),
+      buffer(buffer.empty() ? nullptr : &buffer),
+      assembled{Token(TokenType::END_OF_FILE, "EOF", 0), Token(TokenType::END_OF_FILE, "EOF", 0)},
+      assembledIndex{SIZE_MAX, SIZE_MAX}, lexer(nullptr),
+      ring{Token(TokenType::END_OF_FILE, "EOF", 0), Token(TokenType::END_OF_FILE, "EOF", 0)},
+      head(0), hasLookahead(false) {}
+
+TokenCursor::TokenCursor(Lexer& lexer)
+    : tokens(nullptr), index(0), last(0), buffer(nullptr),
+      assembled{Token(TokenType::END_OF_FILE, "EOF", 0), Token(TokenType::END_OF_FILE, "EOF", 0)},
+      assembledIndex{SIZE_MAX, SIZE_MAX}, lexer(&lexer),
+      ring{lexer.next(), Token(TokenType::END_OF_FILE, "EOF", 0)},
+      head(0), hasLookahead(false) {}
+
+// Token i of a TokenBuffer
+const Token& TokenCursor::assemble(size_t i) const {
+    Token& slot = assembled[i & 1];
+    if (assembledIndex[i & 1] != i) {
+        slot = buffer->token(i);
+        assembledIndex[i & 1] = i;
+    }
+    return slot;
+}
+
+// Returns the current token; at the end this is the END_OF_FILE sentinel
+const Token& TokenCursor::current() const {
+    if (tokens != nullptr) {
+        return (*tokens)[index];
+    }
+    if (buffer != nullptr) {
+        return assemble(index);
+    }
+    return ring[head];
+}
+
+// Returns the token after the current one without consuming anything
+const Token& TokenCursor::peekNext() {
+    if (tokens != nullptr) {
+        return (*tokens)[index < last ? index + 1 : last];
+    }
+    if (buffer != nullptr) {
+        return assemble(index < last ? index + 1 : last);
+    }
+    if (!hasLookahead) {
+        // The lexer keeps returning END_OF_FILE, so peeking at the end is harmless
+        ring[head ^ 1] = lexer->next();
+        hasLookahead = true;
+    }
+    return ring[head ^ 1];
+}
+
+TokenType TokenCursor::peekType() {
+    if (buffer != nullptr) {
+        return buffer->type(index < last ? index + 1 : last);
+    }
+    return peekNext().type;
+}
+
+size_t TokenCursor::currentOffset() const {
+    if (buffer != nullptr) {
+        return buffer->offset(index);
+    }
+    return current().offset;
+}
+
+// Moves to the next token in streaming mode
+void TokenCursor::pullNext() {
+    if (!hasLookahead) {
+        ring[head ^ 1] = lexer->next(); // The other slot, so the token being left stays readable
+    }
+    head ^= 1;
+    hasLookahead = false;
+}
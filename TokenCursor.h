@@ -0,0 +1,78 @@
+#ifndef TOKENCURSOR_H
+#define TOKENCURSOR_H
+
+#include <vector>
+#include "Token.h"
+#include "TokenBuffer.h"
+#include "Lexer.h"
+
+// Read position over a token stream with one token of lookahead.
+// It either walks an already tokenized vector or TokenBuffer, or pulls tokens from a Lexer on
+// demand into a two-slot ring buffer (current + next), so parsing while lexing needs constant memory.
+// The last token (the lexer's END_OF_FILE) is a sentinel: advance() never moves past it, so
+// reading the current token needs no bounds check and keeps returning END_OF_FILE at the end.
+// currentType()/peekType() only read the type; over a TokenBuffer that is all match() needs,
+// while current()/peekNext() have to assemble a Token from the buffer's arrays.
+// A reference from current() stays valid across one advance() (until the cursor next reads a
+// token), so a parser can consume a token and still use it; every mode keeps a two-token window.
+class TokenCursor {
+private:
+    // Vector mode
+    const std::vector<Token>* tokens;
+    size_t index; // Also used in TokenBuffer mode
+    size_t last;  // Index of the END_OF_FILE sentinel, where advance() stops
+
+    // TokenBuffer mode
+    const TokenBuffer* buffer;
+    // Token i is assembled into assembled[i & 1], so the previous token survives an advance()
+    // and repeated current() calls, or a current() after peekNext(), reuse the slot
+    mutable Token assembled[2];
+    mutable size_t assembledIndex[2];
+
+    const Token& assemble(size_t i) const;
+
+    // Streaming mode
+    Lexer* lexer;
+    Token ring[2];
+    size_t head;     // Slot holding the current token
+    bool hasLookahead; // Whether the other slot already holds the next token
+
+    void pullNext(); // advance() in streaming mode
+
+public:
+    explicit TokenCursor(const std::vector<Token>& tokens);
+    explicit TokenCursor(const TokenBuffer& buffer);
+    explicit TokenCursor(Lexer& lexer);
+
+    const Token& current() const;
+    const Token& peekNext(); // May pull one token from the lexer
+    TokenType currentType() const;
+    TokenType peekType();
+    size_t currentOffset() const; // current().offset, without assembling a Token
+    void advance();
+
+    // Index of the current token (vector and TokenBuffer modes), e.g. to resume parsing at a known statement
+    size_t position() const { return index; }
+    void seek(size_t tokenIndex) { index = tokenIndex < last ? tokenIndex : last; }
+};
+
+// Called for every match(), so it is inline
+inline TokenType TokenCursor::currentType() const {
+    if (tokens != nullptr) {
+        return (*tokens)[index].type;
+    }
+    if (buffer != nullptr) {
+        return buffer->type(index);
+    }
+    return ring[head].type;
+}
+
+inline void TokenCursor::advance() {
+    if (lexer == nullptr) {
+        index += index < last; // Stays on the sentinel
+        return;
+    }
+    pullNext();
+}
+
+#endif
@@ -0,0 +1,320 @@
+// implementation of TypeInference.h
+
+#include "TypeInference.h"
+
+namespace {
+
+const uint32_t NO_VARIABLE = UINT32_MAX;
+const TypeSet TYPE_NUMBER = TYPE_BOOL | TYPE_INT | TYPE_FLOAT;
+const TypeSet BASE_TYPES[] = {TYPE_BOOL, TYPE_INT, TYPE_FLOAT, TYPE_STR};
+
+bool isComparison(TokenType op) {
+    return op == TokenType::EQUAL_EQUAL || op == TokenType::NOT_EQUAL || op == TokenType::LESS_THAN ||
+           op == TokenType::LESS_EQUAL || op == TokenType::GREATER_THAN || op == TokenType::GREATER_EQUAL;
+}
+
+// Type of `a op b` for single types, 0 where Python raises a TypeError
+TypeSet arithmeticPair(TokenType op, TypeSet a, TypeSet b) {
+    if ((a & TYPE_NUMBER) && (b & TYPE_NUMBER)) {
+        if (a == TYPE_FLOAT || b == TYPE_FLOAT || op == TokenType::DIVIDE) {
+            return TYPE_FLOAT;
+        }
+        return TYPE_INT; // bool takes part as an int
+    }
+    bool intLike = (a | b) & (TYPE_BOOL | TYPE_INT);
+    if ((op == TokenType::PLUS && a == TYPE_STR && b == TYPE_STR) ||
+        (op == TokenType::MULTIPLY && (a == TYPE_STR || b == TYPE_STR) && intLike)) {
+        return TYPE_STR;
+    }
+    return 0;
+}
+
+// Whether `a op b` is defined: == and != always are, orderings only between numbers or strings
+bool comparable(TokenType op, TypeSet a, TypeSet b) {
+    return op == TokenType::EQUAL_EQUAL || op == TokenType::NOT_EQUAL || ((a & TYPE_NUMBER) && (b & TYPE_NUMBER)) ||
+           (a == TYPE_STR && b == TYPE_STR);
+}
+
+// Rows of BinaryTable: the arithmetic operators, then == / != and the orderings
+const size_t OPERATOR_ROWS = 7;
+const size_t FIRST_COMPARISON_ROW = 5;
+
+size_t operatorRow(TokenType op) {
+    switch (op) {
+        case TokenType::PLUS: return 0;
+        case TokenType::MINUS: return 1;
+        case TokenType::MULTIPLY: return 2;
+        case TokenType::DIVIDE: return 3;
+        case TokenType::MODULO: return 4;
+        case TokenType::EQUAL_EQUAL:
+        case TokenType::NOT_EQUAL: return 5;
+        default: return 6;
+    }
+}
+
+// Result of each operator on every pair of sets of the four base types, so a Binary node costs
+// one lookup however many types its operands may have
+struct BinaryTable {
+    TypeSet result[OPERATOR_ROWS][16][16];
+
+    BinaryTable() {
+        const TokenType representative[OPERATOR_ROWS] = {TokenType::PLUS, TokenType::MINUS, TokenType::MULTIPLY,
+                                                         TokenType::DIVIDE, TokenType::MODULO, TokenType::EQUAL_EQUAL,
+                                                         TokenType::LESS_THAN};
+        for (size_t row = 0; row < OPERATOR_ROWS; ++row) {
+            TokenType op = representative[row];
+            for (TypeSet left = 0; left < 16; ++left) {
+                for (TypeSet right = 0; right < 16; ++right) {
+                    TypeSet types = 0;
+                    for (TypeSet a : BASE_TYPES) {
+                        for (TypeSet b : BASE_TYPES) {
+                            if ((left & a) && (right & b)) {
+                                types |= isComparison(op) ? (comparable(op, a, b) ? TYPE_BOOL : 0) : arithmeticPair(op, a, b);
+                            }
+                        }
+                    }
+                    result[row][left][right] = types;
+                }
+            }
+        }
+    }
+};
+
+const BinaryTable BINARY_TABLE;
+
+} // namespace
+
+std::string typeSetName(TypeSet types) {
+    if (types == 0 || (types & TYPE_DYNAMIC)) {
+        return "dynamic";
+    }
+    static const char* const names[] = {"bool", "int", "float", "str"};
+    std::string name;
+    for (size_t i = 0; i < 4; ++i) {
+        if (types & BASE_TYPES[i]) {
+            if (!name.empty()) {
+                name += '|';
+            }
+            name += names[i];
+        }
+    }
+    return name;
+}
+
+size_t typeSetSize(TypeSet types) {
+    if (types & TYPE_DYNAMIC) {
+        return 0;
+    }
+    return (types & TYPE_FLOAT) ? 8 : (types & TYPE_INT) ? 4 : (types & TYPE_BOOL) ? 1 : 0;
+}
+
+TypeInference::TypeInference(const Ast& ast, SymbolTable& symbolTable)
+    : ast(ast), symbolTable(symbolTable), evaluations(0) {}
+
+void TypeInference::emit(TypeOp op, uint32_t operand) {
+    code.push_back(static_cast<uint32_t>(op) | (operand << 8));
+}
+
+// Post-order, so the program runs on a stack; each variable read is recorded once per assignment.
+// The nodes still to emit are kept on an explicit stack (an operator chain can be as long as
+// its line), each with whether its operands have been emitted already.
+void TypeInference::compileValue(NodeId id, uint32_t assignment, std::vector<uint32_t>& lastReader,
+                                 std::vector<std::pair<uint32_t, uint32_t>>& reads) {
+    pending.clear();
+    pending.emplace_back(id, false);
+    while (!pending.empty()) {
+        NodeId current = pending.back().first;
+        bool operandsDone = pending.back().second;
+        pending.pop_back();
+        if (current == NO_NODE) {
+            emit(TypeOp::PUSH, 0); // Part of a failed parse
+            continue;
+        }
+        const AstNode& node = ast.node(current);
+        switch (node.kind) {
+            case NodeKind::Literal:
+                emit(TypeOp::PUSH, node.op == TokenType::INTEGER_LITERAL  ? TYPE_INT
+                                   : node.op == TokenType::FLOAT_LITERAL  ? TYPE_FLOAT
+                                   : node.op == TokenType::STRING_LITERAL ? TYPE_STR
+                                                                          : TYPE_BOOL);
+                break;
+            case NodeKind::Name: {
+                SymbolTable::SymTabPos pos = symbolTable.search(node.text);
+                if (pos == SymbolTable::SymTabPos::NOT_FOUND) {
+                    emit(TypeOp::PUSH, TYPE_DYNAMIC);
+                    break;
+                }
+                uint32_t variable = static_cast<uint32_t>(pos);
+                if (lastReader[variable] != assignment) {
+                    lastReader[variable] = assignment;
+                    reads.emplace_back(variable, assignment);
+                }
+                emit(TypeOp::VARIABLE, variable);
+                break;
+            }
+            case NodeKind::Input:
+                emit(TypeOp::PUSH, TYPE_STR);
+                break;
+            case NodeKind::Unary:
+                if (operandsDone) {
+                    emit(node.op == TokenType::NOT ? TypeOp::NOT : TypeOp::SIGN);
+                } else {
+                    pending.emplace_back(current, true);
+                    pending.emplace_back(node.firstChild, false);
+                }
+                break;
+            case NodeKind::Binary:
+                if (operandsDone) {
+                    if (node.op == TokenType::AND || node.op == TokenType::OR) {
+                        emit(TypeOp::EITHER);
+                    } else {
+                        emit(TypeOp::BINARY, static_cast<uint32_t>(operatorRow(node.op)));
+                    }
+                } else {
+                    NodeId right = node.firstChild == NO_NODE ? NO_NODE : ast.node(node.firstChild).nextSibling;
+                    pending.emplace_back(current, true);
+                    pending.emplace_back(right, false); // Popped after the left operand
+                    pending.emplace_back(node.firstChild, false);
+                }
+                break;
+            default:
+                emit(TypeOp::PUSH, TYPE_DYNAMIC);
+                break;
+        }
+    }
+}
+
+// Finds the assignments (walking statements only) and compiles their values
+void TypeInference::collect() {
+    assignments.clear();
+    code.clear();
+    std::vector<uint32_t> lastReader(types.size(), NO_VARIABLE);
+    std::vector<std::pair<uint32_t, uint32_t>> reads; // (variable, assignment)
+    ast.walk(ast.getRoot(), [&](NodeId id, size_t) {
+        const AstNode& node = ast.node(id);
+        switch (node.kind) {
+            case NodeKind::Program:
+            case NodeKind::Block:
+            case NodeKind::If:
+            case NodeKind::While:
+                return true;
+            case NodeKind::Assign:
+            case NodeKind::For: {
+                SymbolTable::SymTabPos pos = symbolTable.search(node.text);
+                if (pos == SymbolTable::SymTabPos::NOT_FOUND) {
+                    return node.kind == NodeKind::For;
+                }
+                uint32_t variable = static_cast<uint32_t>(pos);
+                if (node.kind == NodeKind::For) {
+                    types[variable] |= TYPE_DYNAMIC; // Iterables are not parsed, so their items could be anything
+                    return true;
+                }
+                if (node.firstChild != NO_NODE) {
+                    uint32_t assignment = static_cast<uint32_t>(assignments.size());
+                    uint32_t codeStart = static_cast<uint32_t>(code.size());
+                    compileValue(node.firstChild, assignment, lastReader, reads);
+                    assignments.push_back({variable, codeStart, static_cast<uint32_t>(code.size())});
+                }
+                return false;
+            }
+            default:
+                return false; // Expressions assign nothing
+        }
+    });
+
+    // Counting sort of the reads by variable
+    readerStart.assign(types.size() + 1, 0);
+    for (const auto& read : reads) {
+        readerStart[read.first + 1]++;
+    }
+    for (size_t v = 0; v < types.size(); ++v) {
+        readerStart[v + 1] += readerStart[v];
+    }
+    readers.resize(reads.size());
+    std::vector<uint32_t> next(readerStart.begin(), readerStart.end() - 1);
+    for (const auto& read : reads) {
+        readers[next[read.first]++] = read.second;
+    }
+}
+
+// A set of 0 (a value that never exists yet) makes every result 0
+TypeSet TypeInference::evaluate(const Assignment& assignment) {
+    stack.clear();
+    for (uint32_t i = assignment.codeStart; i < assignment.codeEnd; ++i) {
+        uint32_t instruction = code[i];
+        uint32_t operand = instruction >> 8;
+        switch (static_cast<TypeOp>(instruction & 0xFF)) {
+            case TypeOp::PUSH:
+                stack.push_back(static_cast<TypeSet>(operand));
+                break;
+            case TypeOp::VARIABLE:
+                stack.push_back(types[operand]);
+                break;
+            case TypeOp::NOT:
+                stack.back() = stack.back() == 0 ? 0 : TYPE_BOOL;
+                break;
+            case TypeOp::SIGN: { // -str raises
+                TypeSet x = stack.back();
+                stack.back() = static_cast<TypeSet>(((x & (TYPE_BOOL | TYPE_INT)) ? TYPE_INT : 0) | (x & (TYPE_FLOAT | TYPE_DYNAMIC)));
+                break;
+            }
+            case TypeOp::EITHER: { // 'and' / 'or': the operand that decided
+                TypeSet y = stack.back();
+                stack.pop_back();
+                TypeSet& x = stack.back();
+                x = (x == 0 || y == 0) ? 0 : static_cast<TypeSet>(x | y);
+                break;
+            }
+            case TypeOp::BINARY: {
+                TypeSet y = stack.back();
+                stack.pop_back();
+                TypeSet& x = stack.back();
+                if (x == 0 || y == 0) {
+                    x = 0;
+                } else if ((x | y) & TYPE_DYNAMIC) {
+                    x = operand >= FIRST_COMPARISON_ROW ? TYPE_BOOL : TYPE_DYNAMIC; // Comparisons give a bool or raise
+                } else {
+                    x = BINARY_TABLE.result[operand][x][y];
+                }
+                break;
+            }
+        }
+    }
+    return stack.empty() ? 0 : stack.back();
+}
+
+void TypeInference::run() {
+    types.assign(symbolTable.getEntries().size(), 0);
+    evaluations = 0;
+    collect();
+
+    // Every assignment once in source order, then the readers of each variable that grew
+    std::vector<uint32_t> worklist(assignments.size());
+    for (uint32_t a = 0; a < assignments.size(); ++a) {
+        worklist[a] = static_cast<uint32_t>(assignments.size()) - 1 - a;
+    }
+    std::vector<bool> queued(assignments.size(), true);
+    while (!worklist.empty()) {
+        uint32_t a = worklist.back();
+        worklist.pop_back();
+        queued[a] = false;
+        evaluations++;
+        const Assignment& assignment = assignments[a];
+        TypeSet grown = types[assignment.target] | evaluate(assignment);
+        if (grown == types[assignment.target]) {
+            continue;
+        }
+        types[assignment.target] = grown;
+        for (uint32_t i = readerStart[assignment.target]; i < readerStart[assignment.target + 1]; ++i) {
+            if (!queued[readers[i]]) {
+                queued[readers[i]] = true;
+                worklist.push_back(readers[i]);
+            }
+        }
+    }
+
+    for (size_t position = 0; position < types.size(); ++position) {
+        symbolTable.updateDataType(static_cast<SymbolTable::SymTabPos>(position), typeSetName(types[position]),
+                                   typeSetSize(types[position]));
+    }
+}
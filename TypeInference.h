@@ -0,0 +1,82 @@
+#ifndef TYPEINFERENCE_H
+#define TYPEINFERENCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "AST.h"
+#include "SymbolTable.h"
+
+// Set of the types a value may have: one bit per type, joined with |. 0 (no type yet) is the
+// bottom of the lattice and TYPE_DYNAMIC (anything, e.g. a for loop variable) the top.
+using TypeSet = uint8_t;
+const TypeSet TYPE_BOOL = 1 << 0;
+const TypeSet TYPE_INT = 1 << 1;
+const TypeSet TYPE_FLOAT = 1 << 2;
+const TypeSet TYPE_STR = 1 << 3;
+const TypeSet TYPE_DYNAMIC = 1 << 4;
+
+// "int", "int|float", ...; "dynamic" for the top or an empty set
+std::string typeSetName(TypeSet types);
+// Size as STEntry reports it: 1 for bool, 4 for int, 8 for float, 0 for str (its length is not
+// fixed) and dynamic; the largest member for a union
+size_t typeSetSize(TypeSet types);
+
+// Resolves the "dynamic" types the Parser gives every variable. A variable's type is the union
+// of the types of every value assigned to it anywhere in the program (literals, input() -> str,
+// and the results of arithmetic, comparisons and 'and'/'or' on those).
+// Each assigned value is compiled once into a short postfix program over type sets, so the
+// tree is walked once. The programs are then run from a worklist: when a variable's set grows,
+// only the assignments that read it are queued again. A set can only grow, at most 5 times, so
+// the whole run is linear in the size of the tree.
+class TypeInference {
+private:
+    // Instructions of the type programs: the opcode in the low 8 bits, the operand above
+    enum class TypeOp : uint8_t {
+        PUSH,     // Push the set in the operand
+        VARIABLE, // Push the set of the variable at SymbolTable position operand
+        NOT,      // not x
+        SIGN,     // -x, +x
+        EITHER,   // x and y, x or y
+        BINARY    // x op y, operand = row of the operator table
+    };
+
+    struct Assignment {
+        uint32_t target;    // SymbolTable position
+        uint32_t codeStart; // The value's program: code[codeStart, codeEnd)
+        uint32_t codeEnd;
+    };
+
+    const Ast& ast;
+    SymbolTable& symbolTable;
+    std::vector<TypeSet> types; // By SymbolTable position
+    std::vector<Assignment> assignments;
+    std::vector<uint32_t> code;
+    std::vector<TypeSet> stack;
+    std::vector<std::pair<NodeId, bool>> pending; // compileValue's nodes to emit, and whether their operands are done
+    // Assignments reading each variable, by SymbolTable position: readers[readerStart[v] ..
+    // readerStart[v + 1])
+    std::vector<uint32_t> readerStart;
+    std::vector<uint32_t> readers;
+    size_t evaluations;
+
+    void emit(TypeOp op, uint32_t operand = 0);
+    void compileValue(NodeId id, uint32_t assignment, std::vector<uint32_t>& lastReader,
+                      std::vector<std::pair<uint32_t, uint32_t>>& reads);
+    void collect();
+    TypeSet evaluate(const Assignment& assignment);
+
+public:
+    TypeInference(const Ast& ast, SymbolTable& symbolTable);
+
+    // Infers every variable's type and writes it (and its size) into the symbol table
+    void run();
+
+    const std::vector<TypeSet>& getTypes() const { return types; }
+    size_t assignmentCount() const { return assignments.size(); }
+    size_t evaluationCount() const { return evaluations; } // Assignments evaluated by the last run
+};
+
+#endif
@@ -1,35 +1,106 @@
 #include <iostream>
 #include <fstream>
-#include <sstream>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <memory>
 
 #include "Lexer.h"
 #include "Parser.h"
 #include "SymbolTable.h"
 #include "ErrorHandler.h"
 #include "Token.h"
+#include "SourceFile.h"
+#include "BatchAnalyzer.h"
+#include "ParallelLexer.h"
+#include "ParallelParser.h"
+#include "AnalysisCache.h"
+#include "Stats.h"
+#include "OutputWriter.h"
+#include "AnalysisServer.h"
+#include "Compiler.h"
+#include "Interpreter.h"
+#include "Optimizer.h"
+#include "TypeInference.h"
 
-std::string readSourceCode(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Failed to open file " << filename << std::endl;
-        return "";
+#include <algorithm>
+#include <charconv>
+#include <csignal>
+
+// Batch mode: analyzes every file (directories are searched for .py files) across a thread pool
+int runBatch(const std::vector<std::string>& inputs, const std::string& listFile, size_t jobs, const std::string& cacheDir,
+             OutputFormat format, ErrorPolicy policy) {
+    std::vector<std::string> paths = inputs;
+    if (!listFile.empty()) {
+        std::ifstream list(listFile);
+        if (!list.is_open()) {
+            std::cerr << "Error: Failed to open file list " << listFile << std::endl;
+            return 1;
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty()) {
+                paths.push_back(line);
+            }
+        }
+    }
+
+    std::unique_ptr<AnalysisCache> cache;
+    if (!cacheDir.empty()) {
+        cache = std::make_unique<AnalysisCache>(cacheDir);
+    }
+    BatchAnalyzer analyzer(jobs, cache.get(), format, policy);
+    BatchSummary summary = analyzer.run(BatchAnalyzer::collectFiles(paths));
+    if (format == OutputFormat::TABLE || format == OutputFormat::SUMMARY) {
+        BatchAnalyzer::printSummary(summary);
+    }
+    return summary.filesWithErrors == 0 ? 0 : 1;
+}
+
+AnalysisServer* activeServer = nullptr;
+
+void stopServer(int) {
+    if (activeServer != nullptr) {
+        activeServer->stop();
+    }
+}
+
+// Server mode: answers requests on a Unix domain socket until SIGINT or SIGTERM
+int runServer(const std::string& socketPath, size_t jobs, ErrorPolicy policy) {
+    AnalysisServer server(socketPath, jobs, policy);
+    if (!server.listen()) {
+        return 1;
     }
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    activeServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    std::cerr << "Listening on " << socketPath << " with " << server.threads() << " workers" << std::endl;
+    server.run();
+    activeServer = nullptr;
+    std::cerr << "Served " << server.requestsServed() << " requests on " << server.connectionsAccepted()
+              << " connections" << std::endl;
+    return 0;
 }
 
-int main() {
-    std::cout << "PYTHON Parser Made Using C++ by Kenneth Lance L. Apolinar" << std::endl;
-    // use path so that it's easier to test multiple files
-    std::cout << "Enter path to Python source file: ";
-    std::string filename;
-    std::getline(std::cin, filename); // Get filename from user
+// Resolves the symbol table's variable types from the tree of the last parse
+void inferTypes(const Ast& ast, SymbolTable& symbolTable) {
+    Stats::PhaseTimer timer(Stats::Phase::INFER);
+    TypeInference(ast, symbolTable).run();
+}
 
-    // Read the source code
-    std::string sourceCode = readSourceCode(filename);
+// Single-file mode: prints the source, the tokens table, the symbol table and any errors
+int runFile(const std::string& filename, bool streaming, bool showAst, bool optimize, size_t jobs, ErrorPolicy policy) {
+    // Map (or read) the source code. The Lexer and its tokens view straight into this buffer.
+    SourceFile source;
+    bool loaded;
+    {
+        Stats::PhaseTimer timer(Stats::Phase::READ);
+        loaded = (filename == "-") ? source.readStream(std::cin) : source.open(filename);
+    }
+    if (!loaded) {
+        std::cerr << "Error: Failed to open file " << filename << std::endl;
+    }
+    std::string_view sourceCode = source.contents();
 
     if (sourceCode.empty()) {
         if (!filename.empty()) { // Only print error if user entered a filename
@@ -38,45 +109,388 @@ int main() {
         return 1;
     }
 
-    std::cout << "\n| Source Code Parsed |" << std::endl;
-    std::cout << sourceCode << std::endl;
-    std::cout << "--------------------------" << std::endl;
+    {
+        Stats::PhaseTimer timer(Stats::Phase::PRINT);
+        std::cout << "\n| Source Code Parsed |" << std::endl;
+        std::cout << sourceCode << std::endl;
+        std::cout << "--------------------------" << std::endl;
+    }
 
     // Initialize components
-    ErrorHandler errorHandler;
+    ErrorHandler errorHandler(policy);
     SymbolTable symbolTable;
 
-    //  Lexical Analysis
+    auto printParseResult = [&]() {
+        if (errorHandler.hasErrors()) {
+            std::cout << "Syntax analysis completed with errors." << std::endl;
+        } else {
+            std::cout << "Syntax analysis completed successfully." << std::endl;
+        }
+    };
+    auto optimizeAst = [&](Ast& ast) {
+        if (optimize && !errorHandler.hasErrors()) {
+            OptimizerReport report;
+            {
+                Stats::PhaseTimer timer(Stats::Phase::OPTIMIZE);
+                report = Optimizer(ast, symbolTable).optimize();
+            }
+            Stats::PhaseTimer timer(Stats::Phase::PRINT);
+            report.print();
+        }
+    };
+    auto printAst = [&](const Ast& ast) {
+        if (showAst) {
+            Stats::PhaseTimer timer(Stats::Phase::PRINT);
+            ast.print();
+            ast.printMemoryReport();
+        }
+    };
+
     Lexer lexer(sourceCode, errorHandler);
-    std::vector<Token> tokens = lexer.tokenize();
+    LineIndex lines(sourceCode); // Built when the first line number is needed
+    if (streaming) {
+        // Lexical and Syntax Analysis together; tokens are discarded once parsed
+        // (the parse time includes lexing here)
+        Parser parser(lexer, lines, symbolTable, errorHandler);
+        std::cout << "\nStarting syntax analysis..." << std::endl;
+        {
+            Stats::PhaseTimer timer(Stats::Phase::PARSE);
+            parser.parse();
+        }
+        inferTypes(parser.getAst(), symbolTable);
+        printParseResult();
+        optimizeAst(parser.getAst());
+        printAst(parser.getAst());
+    } else {
+        //  Lexical Analysis (split across threads when --jobs asks for more than one)
+        std::vector<Token> tokens;
+        {
+            Stats::PhaseTimer timer(Stats::Phase::LEX);
+            tokens = jobs > 1 ? ParallelLexer(sourceCode, errorHandler, jobs).tokenize() : lexer.tokenize();
+        }
 
-    // Print Lexemes and Tokens Table
-    lexer.printLexemesAndTokens(tokens);
+        // Print Lexemes and Tokens Table
+        {
+            Stats::PhaseTimer timer(Stats::Phase::PRINT);
+            lexer.printLexemesAndTokens(tokens, lines);
+        }
 
-    if (errorHandler.hasErrors()) {
-        errorHandler.printErrors();
-        std::cout << "\nLexical errors found. Cannot proceed parsing." << std::endl;
-        return 1;
+        if (errorHandler.hasErrors()) {
+            Stats::PhaseTimer timer(Stats::Phase::PRINT);
+            errorHandler.printErrors(lines);
+            std::cout << "\nLexical errors found. Cannot proceed parsing." << std::endl;
+            return 1;
+        }
+
+        // Syntax Analysis (also split across threads by --jobs)
+        ParallelParser parser(tokens, lines, symbolTable, errorHandler, jobs);
+        std::cout << "\nStarting syntax analysis..." << std::endl;
+        {
+            Stats::PhaseTimer timer(Stats::Phase::PARSE);
+            parser.parse();
+        }
+        inferTypes(parser.getAst(), symbolTable);
+        printParseResult();
+        optimizeAst(parser.getAst());
+        printAst(parser.getAst());
     }
 
-    // Syntax Analysis
-    Parser parser(tokens, symbolTable, errorHandler);
-    parser.parse();
+    Stats::PhaseTimer timer(Stats::Phase::PRINT);
 
     // Print Symbol Table
     symbolTable.printTable();
 
     // Final Error Report
     if (errorHandler.hasErrors()) {
-        errorHandler.printErrors();
+        errorHandler.printErrors(lines);
         std::cout << "\nParsing completed with errors." << std::endl;
     } else {
         std::cout << "\nParsing completed successfully with no errors!" << std::endl;
     }
+    return 0;
+}
+
+// Single-file mode for the machine-readable formats: no source echo or tables, and everything
+// goes out in one write at the end (see OutputWriter.h)
+int runFileFormatted(const std::string& filename, OutputFormat format, bool streaming, size_t jobs, ErrorPolicy policy) {
+    SourceFile source;
+    bool loaded;
+    {
+        Stats::PhaseTimer timer(Stats::Phase::READ);
+        loaded = (filename == "-") ? source.readStream(std::cin) : source.open(filename);
+    }
+    if (!loaded || source.contents().empty()) {
+        std::cerr << "Error: Failed to open file " << filename << std::endl;
+        return 1;
+    }
+    std::string_view sourceCode = source.contents();
+
+    ErrorHandler errorHandler(policy);
+    SymbolTable symbolTable;
+    std::vector<Token> tokens;
+    int status = 0;
+    Lexer lexer(sourceCode, errorHandler);
+    LineIndex lines(sourceCode);
+    if (streaming) {
+        // No token vector, so no token records either
+        Parser parser(lexer, lines, symbolTable, errorHandler);
+        {
+            Stats::PhaseTimer timer(Stats::Phase::PARSE);
+            parser.parse();
+        }
+        inferTypes(parser.getAst(), symbolTable);
+    } else {
+        {
+            Stats::PhaseTimer timer(Stats::Phase::LEX);
+            tokens = jobs > 1 ? ParallelLexer(sourceCode, errorHandler, jobs).tokenize() : lexer.tokenize();
+        }
+        if (errorHandler.hasErrors()) {
+            status = 1; // Same as the table output: lexical errors stop the analysis before parsing
+        } else {
+            ParallelParser parser(tokens, lines, symbolTable, errorHandler, jobs);
+            {
+                Stats::PhaseTimer timer(Stats::Phase::PARSE);
+                parser.parse();
+            }
+            inferTypes(parser.getAst(), symbolTable);
+        }
+    }
+
+    Stats::PhaseTimer timer(Stats::Phase::PRINT);
+    OutputWriter writer(format);
+    writer.writeHeader();
+    writer.writeFile(filename, sourceCode, lines, streaming ? nullptr : &tokens, 0, symbolTable, errorHandler);
+    writer.flush();
+    return status;
+}
+
+// Run mode: checks the file like the other modes, then compiles it to bytecode and executes it.
+// Only the program's own output goes to stdout; errors of any stage go to stderr.
+int runProgram(const std::string& filename, bool showBytecode, ErrorPolicy policy) {
+    SourceFile source;
+    bool loaded;
+    {
+        Stats::PhaseTimer timer(Stats::Phase::READ);
+        loaded = (filename == "-") ? source.readStream(std::cin) : source.open(filename);
+    }
+    if (!loaded || source.contents().empty()) {
+        std::cerr << "Error: Failed to open file " << filename << std::endl;
+        return 1;
+    }
+    std::string_view sourceCode = source.contents();
+
+    ErrorHandler errorHandler(policy);
+    SymbolTable symbolTable;
+    LineIndex lines(sourceCode);
+    Lexer lexer(sourceCode, errorHandler);
+    std::vector<Token> tokens;
+    {
+        Stats::PhaseTimer timer(Stats::Phase::LEX);
+        tokens = lexer.tokenize();
+    }
+    Parser parser(tokens, lines, symbolTable, errorHandler);
+    if (!errorHandler.hasErrors()) {
+        Stats::PhaseTimer timer(Stats::Phase::PARSE);
+        parser.parse();
+    }
+    if (errorHandler.hasErrors()) {
+        errorHandler.printErrors(lines);
+        return 1;
+    }
+
+    {
+        Stats::PhaseTimer timer(Stats::Phase::OPTIMIZE);
+        Optimizer(parser.getAst(), symbolTable).optimize();
+    }
 
-    std::cout << "\nPress Enter to exit. Thank you for using!";
-    std::cin.ignore(); // Consume the newline character left by previous std::getline
-    std::cin.get();
+    BytecodeProgram program;
+    {
+        Stats::PhaseTimer timer(Stats::Phase::COMPILE);
+        Compiler compiler(parser.getAst(), symbolTable);
+        if (!compiler.compile(program)) {
+            std::cerr << "Compile Error at Line " << compiler.getError().line << ": " << compiler.getError().message
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (showBytecode) {
+        program.disassemble(std::cerr);
+    }
 
+    Stats::PhaseTimer timer(Stats::Phase::RUN);
+    Interpreter interpreter(program);
+    if (!interpreter.run()) {
+        std::cerr << "Runtime Error at Line " << interpreter.getError().line << ": " << interpreter.getError().message
+                  << std::endl;
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
+
+// Options followed by a value
+const char* const VALUE_OPTIONS[] = {"--jobs", "--serve", "--list", "--cache", "--format", "--max-errors",
+                                     "--max-nesting"};
+
+// Reads the whole of an option's value as a count; std::stoul would throw on "x" and accept "1x"
+bool parseCount(const std::string& option, const std::string& text, size_t& count) {
+    const char* end = text.data() + text.size();
+    auto result = std::from_chars(text.data(), end, count);
+    if (text.empty() || result.ec != std::errc() || result.ptr != end) {
+        std::cerr << "Error: " << option << " needs a whole number, not '" << text << "'" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Usage: parser [--stream] [--ast] [--optimize] [--format F] [--all-errors] [--max-errors N] [--max-nesting N]
+//               [--stats[=json]] [path | -]
+//        parser --batch [--jobs N] [--list FILE] [--cache DIR] [--format F] [--all-errors] [--max-errors N]
+//               [--max-nesting N] [--stats[=json]] [path | directory]...
+//        parser --serve SOCKET [--jobs N] [--all-errors] [--max-errors N] [--max-nesting N] [--stats[=json]]
+//        parser --run [--bytecode] [--max-nesting N] [--stats[=json]] [path | -]
+// With no path it is prompted for interactively. "-" reads the source from stdin,
+// so the analyzer can sit at the end of a pipe. Only --batch takes more than one path.
+// --stream parses while lexing instead of building the whole token vector first (no token table).
+// --ast prints the syntax tree and its memory usage after parsing.
+// --optimize folds constants and simplifies the syntax tree after parsing (see Optimizer.h) and
+// prints what it removed; with --ast the optimized tree is printed.
+// --batch analyzes many files in parallel (--jobs defaults to the number of cores); --list reads
+// additional paths from FILE, one per line. --cache keeps results in DIR, keyed by file contents,
+// so files unchanged since an earlier run are not lexed or parsed again.
+// --jobs N outside batch mode lexes and parses a single large file on N threads.
+// --serve keeps running and analyzes requests sent to the Unix domain socket SOCKET by any number
+// of clients, on --jobs worker threads (see AnalysisServer.h and ServerProtocol.h); the error
+// options set the default for its requests. Stop it with SIGINT or SIGTERM.
+// --run executes the program after checking it: it is optimized, compiled to register bytecode
+// and run by the interpreter (see Compiler.h and Interpreter.h), reading input() from stdin. --bytecode
+// also prints the compiled code to stderr first.
+// --format picks the output: table (default, for interactive use), none, summary, ndjson, csv or
+// binary (see OutputWriter.h). --ast only applies to the table format.
+// --all-errors keeps parsing after a statement with an error, so every error is reported in one
+// run; --max-errors N does the same but stops after N errors.
+// --max-nesting N (at least 1) sets how deeply blocks and parentheses may nest before the parser
+// reports an error instead (default 200, see ErrorPolicy).
+// --stats prints run statistics (phase times, token/symbol/error counters) at the end, as a table
+// or, with --stats=json, as one JSON line (see Stats.h).
+int main(int argc, char* argv[]) {
+    bool streaming = false;
+    bool showAst = false;
+    bool optimize = false;
+    bool batch = false;
+    bool run = false;
+    bool showBytecode = false;
+    size_t jobs = 0;
+    std::string listFile;
+    std::string cacheDir;
+    std::string statsFormat;
+    std::string serveSocket;
+    OutputFormat format = OutputFormat::TABLE;
+    ErrorPolicy policy;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 == argc &&
+            std::find(std::begin(VALUE_OPTIONS), std::end(VALUE_OPTIONS), arg) != std::end(VALUE_OPTIONS)) {
+            std::cerr << "Error: " << arg << " needs a value" << std::endl;
+            return 1;
+        }
+        if (arg == "--stream") {
+            streaming = true;
+        } else if (arg == "--ast") {
+            showAst = true;
+        } else if (arg == "--optimize") {
+            optimize = true;
+        } else if (arg == "--run") {
+            run = true;
+        } else if (arg == "--bytecode") {
+            showBytecode = true;
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--jobs") {
+            if (!parseCount(arg, argv[++i], jobs)) {
+                return 1;
+            }
+        } else if (arg == "--serve") {
+            serveSocket = argv[++i];
+        } else if (arg == "--list") {
+            listFile = argv[++i];
+        } else if (arg == "--cache") {
+            cacheDir = argv[++i];
+        } else if (arg == "--format") {
+            if (!parseOutputFormat(argv[++i], format)) {
+                std::cerr << "Error: Unknown output format " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--all-errors") {
+            policy.recover = true;
+        } else if (arg == "--max-errors") {
+            policy.recover = true;
+            if (!parseCount(arg, argv[++i], policy.maxErrors)) {
+                return 1;
+            }
+        } else if (arg == "--max-nesting") {
+            if (!parseCount(arg, argv[++i], policy.maxNesting)) {
+                return 1;
+            }
+            if (policy.maxNesting == 0) { // Not even a program's top-level block would fit
+                std::cerr << "Error: " << arg << " needs a whole number of at least 1, not '" << argv[i] << "'"
+                          << std::endl;
+                return 1;
+            }
+        } else if (arg == "--stats" || arg == "--stats=table") {
+            statsFormat = "table";
+        } else if (arg == "--stats=json") {
+            statsFormat = "json";
+        } else if (arg.compare(0, 2, "--") == 0) {
+            std::cerr << "Error: Unknown option " << arg << std::endl;
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (!batch && paths.size() > 1) {
+        std::cerr << "Error: Only one path can be given without --batch" << std::endl;
+        return 1;
+    }
+
+    if (format == OutputFormat::TABLE && serveSocket.empty() && !run) {
+        std::cout << "PYTHON Parser Made Using C++ by Kenneth Lance L. Apolinar" << std::endl;
+    }
+
+    bool interactive = false;
+    int status;
+    if (!serveSocket.empty()) {
+        status = runServer(serveSocket, jobs, policy);
+    } else if (batch) {
+        status = runBatch(paths, listFile, jobs, cacheDir, format, policy);
+    } else {
+        std::string filename = paths.empty() ? "" : paths.back();
+
+        interactive = filename.empty();
+        if (interactive) {
+            // use path so that it's easier to test multiple files
+            std::cout << "Enter path to Python source file: ";
+            std::getline(std::cin, filename); // Get filename from user
+        }
+        if (run) {
+            status = runProgram(filename, showBytecode, policy);
+        } else {
+            status = format == OutputFormat::TABLE ? runFile(filename, streaming, showAst, optimize, jobs, policy)
+                                                   : runFileFormatted(filename, format, streaming, jobs, policy);
+        }
+    }
+
+    if (statsFormat == "json") {
+        Stats::printJson(Stats::snapshot());
+    } else if (statsFormat == "table") {
+        Stats::printTable(Stats::snapshot());
+    }
+
+    if (interactive && status == 0) {
+        std::cout << "\nPress Enter to exit. Thank you for using!";
+        std::cin.ignore(); // Consume the newline character left by previous std::getline
+        std::cin.get();
+    }
+
+    return status;
+}